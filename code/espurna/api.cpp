@@ -25,243 +25,16 @@ Copyright (C) 2020-2021 by Maxim Prokhorov <prokhorov dot max at outlook dot com
 #include <algorithm>
 #include <memory>
 #include <cstring>
-#include <forward_list>
 #include <vector>
 
 #include "system.h"
 #include "rpc.h"
 
+#include "api_body.h"
 #include "api_path.h"
 
 // -----------------------------------------------------------------------------
 
-PathParts::PathParts(espurna::StringView path) :
-    _path(path)
-{
-    if (!_path.length()) {
-        _ok = false;
-        return;
-    }
-
-    PathPart::Type type { PathPart::Type::Unknown };
-    size_t length { 0ul };
-    size_t offset { 0ul };
-
-    const char* p { _path.begin() };
-    if (*p == '\0') {
-       goto error;
-    }
-
-    _parts.reserve(std::count(_path.begin(), _path.end(), '/') + 1);
-
-start:
-    type = PathPart::Type::Unknown;
-    length = 0;
-    offset = p - _path.c_str();
-
-    switch (*p) {
-    case '+':
-        goto parse_single_wildcard;
-    case '#':
-        goto parse_multi_wildcard;
-    case '/':
-    default:
-        goto parse_value;
-    }
-
-parse_value:
-    type = PathPart::Type::Value;
-
-    switch (*p) {
-    case '+':
-    case '#':
-        goto error;
-    case '/':
-    case '\0':
-        goto push_result;
-    }
-
-    ++p;
-    ++length;
-
-    goto parse_value;
-
-parse_single_wildcard:
-    type = PathPart::Type::SingleWildcard;
-
-    ++p;
-    switch (*p) {
-    case '/':
-        ++p;
-    case '\0':
-        goto push_result;
-    }
-
-    goto error;
-
-parse_multi_wildcard:
-    type = PathPart::Type::MultiWildcard;
-
-    ++p;
-    if (*p == '\0') {
-        goto push_result;
-    }
-    goto error;
-
-push_result:
-    emplace_back(type, offset, length);
-    if (*p == '/') {
-        ++p;
-        goto start;
-    } else if (*p != '\0') {
-        goto start;
-    }
-    goto success;
-
-error:
-    _ok = false;
-    _parts.clear();
-    return;
-
-success:
-    _ok = true;
-}
-
-// match when, for example, given the path 'topic/one/two/three' and pattern 'topic/+/two/+'
-
-bool PathParts::match(const PathParts& path) const {
-    if (!_ok || !path) {
-        return false;
-    }
-
-    auto lhs = begin();
-    auto lhs_end = end();
-
-    auto rhs = path.begin();
-    auto rhs_end = path.end();
-loop:
-    if (lhs == lhs_end) {
-        goto check_end;
-    }
-
-    switch ((*lhs).type) {
-    case PathPart::Type::Value:
-        if (
-            (rhs != rhs_end)
-            && ((*rhs).type == PathPart::Type::Value)
-            && ((*rhs).length == (*lhs).length)
-        ) {
-            if (0 == std::memcmp(
-                _path.c_str() + (*lhs).offset,
-                path.path().c_str() + (*rhs).offset,
-                (*rhs).length))
-            {
-                std::advance(lhs, 1);
-                std::advance(rhs, 1);
-                goto loop;
-            }
-        }
-        goto error;
-
-    case PathPart::Type::SingleWildcard:
-        if (
-            (rhs != rhs_end)
-            && ((*rhs).type == PathPart::Type::Value)
-        ) {
-            std::advance(lhs, 1);
-            std::advance(rhs, 1);
-            goto loop;
-        }
-        goto error;
-
-    case PathPart::Type::MultiWildcard:
-        if (std::next(lhs) == lhs_end) {
-            while (rhs != rhs_end) {
-                if ((*rhs).type != PathPart::Type::Value) {
-                    goto error;
-                }
-                std::advance(rhs, 1);
-            }
-            lhs = lhs_end;
-            break;
-        }
-        goto error;
-
-    case PathPart::Type::Unknown:
-        goto error;
-    };
-
-check_end:
-    if ((lhs == lhs_end) && (rhs == rhs_end)) {
-        return true;
-    }
-
-error:
-    return false;
-}
-
-espurna::StringView PathParts::wildcard(const PathParts& pattern, const PathParts& value, int index) {
-    if (index < 0) {
-        index = std::abs(index + 1);
-    }
-
-    espurna::StringView out;
-
-    if (std::abs(index) < pattern.parts().size()) {
-        const auto& pattern_parts = pattern.parts();
-        int counter { 0 };
-
-        for (size_t part = 0; part < pattern.size(); ++part) {
-            const auto& lhs = pattern_parts[part];
-            const auto& rhs = value.parts()[part];
-
-            const auto path = value.path();
-
-            switch (lhs.type) {
-            case PathPart::Type::Value:
-            case PathPart::Type::Unknown:
-                break;
-
-            case PathPart::Type::SingleWildcard:
-                if (counter == index) {
-                    out = espurna::StringView(
-                        path.begin() + rhs.offset, path.begin() + rhs.offset + rhs.length);
-                    return out;
-                }
-                ++counter;
-                break;
-
-            case PathPart::Type::MultiWildcard:
-                if (counter == index) {
-                    out = espurna::StringView(
-                        path.begin() + rhs.offset, path.end());
-                }
-                return out;
-            }
-        }
-    }
-
-    return out;
-}
-
-size_t PathParts::wildcards(const PathParts& pattern) {
-    size_t out { 0 };
-
-    for (const auto& part : pattern) {
-        switch (part.type) {
-        case PathPart::Type::Unknown:
-        case PathPart::Type::Value:
-        case PathPart::Type::MultiWildcard:
-            break;
-        case PathPart::Type::SingleWildcard:
-            ++out;
-            break;
-        }
-    }
-
-    return out;
-}
-
 #if WEB_SUPPORT
 String ApiRequest::wildcard(int index) const {
     return PathParts::wildcard(_pattern, _parts, index).toString();
@@ -364,11 +137,27 @@ bool is_json(AsyncWebServerRequest* request) {
 // - ALL headers are parsed (and we could access those during filter and canHandle callbacks), but we need to explicitly
 //   request them to stay in memory so that the actual handler can work with them
 
-void attach_helper(AsyncWebServerRequest& request, RequestHelper&& helper) {
-    request._tempObject = new RequestHelper(std::move(helper));
+class BaseWebHandler;
+
+struct RequestState {
+    BaseWebHandler* handler;
+    RequestHelper helper;
+    Body body { API_JSON_BODY_SIZE };
+};
+
+RequestState* request_state(AsyncWebServerRequest* request) {
+    return reinterpret_cast<RequestState*>(request->_tempObject);
+}
+
+RequestHelper& request_helper(AsyncWebServerRequest* request) {
+    return request_state(request)->helper;
+}
+
+void attach_helper(AsyncWebServerRequest& request, BaseWebHandler& handler, RequestHelper&& helper) {
+    request._tempObject = new RequestState{&handler, std::move(helper)};
     request.onDisconnect(
         [&]() {
-            auto* ptr = reinterpret_cast<RequestHelper*>(request._tempObject);
+            auto* ptr = request_state(&request);
             delete ptr;
             request._tempObject = nullptr;
         });
@@ -376,9 +165,14 @@ void attach_helper(AsyncWebServerRequest& request, RequestHelper&& helper) {
         STRING_VIEW("Api-Key").toString());
     request.addInterestingHeader(
         STRING_VIEW("Accept").toString());
+    request.addInterestingHeader(
+        STRING_VIEW("If-None-Match").toString());
 }
 
-class BaseWebHandler : public AsyncWebHandler {
+// Handlers are not registered in the webserver directly, see WebDispatcher below
+// Path of the request is already matched, the rest of the checks are up to the handler
+
+class BaseWebHandler {
 public:
     BaseWebHandler() = delete;
 
@@ -397,6 +191,13 @@ public:
         _parts(_pattern)
     {}
 
+    virtual ~BaseWebHandler() = default;
+
+    virtual bool canHandle(AsyncWebServerRequest*, RequestHelper&&) = 0;
+    virtual void handleRequest(AsyncWebServerRequest*) = 0;
+    virtual void handleBody(AsyncWebServerRequest*, uint8_t*, size_t, size_t, size_t) {
+    }
+
     const String& pattern() const {
         return _pattern;
     }
@@ -412,12 +213,10 @@ private:
 
 // 'Modernized' API configuration:
 // - `Api-Key` header for both GET and PUT
-// - Parse request body as JSON object. Limited to LWIP internal buffer size, and will also break when client
-//   does weird stuff and PUTs data in multiple packets b/c only the initial packet is parsed.
+// - Parse request body as JSON object. Body may arrive in multiple packets, which are buffered until
+//   the whole content-length is received. Limited to API_JSON_BODY_SIZE, larger ones are rejected with 413
 // - Same as the text/plain, when ApiRequest::handle was not called it will then call GET
 //
-// TODO: bump to arduinojson v6 to handle partial / broken data payloads
-// TODO: somehow detect partial data and buffer (optionally)
 // TODO: POST instead of PUT?
 
 class JsonWebHandler final : public BaseWebHandler {
@@ -439,20 +238,11 @@ public:
         _put(std::forward<Put>(put))
     {}
 
-    bool isRequestHandlerTrivial() override {
-        return true;
-    }
-
-    bool canHandle(AsyncWebServerRequest* request) override {
-        if (!apiEnabled()) {
-            return false;
-        }
-
-        auto helper = RequestHelper(*request, parts());
-        if (helper.match() && apiAuthenticate(request)) {
+    bool canHandle(AsyncWebServerRequest* request, RequestHelper&& helper) override {
+        if (apiAuthenticate(request)) {
             switch (request->method()) {
             case HTTP_HEAD:
-                return true;
+                break;
             case HTTP_PUT:
                 if (!is_json(request)) {
                     return false;
@@ -469,7 +259,7 @@ public:
             default:
                 return false;
             }
-            attach_helper(*request, std::move(helper));
+            attach_helper(*request, *this, std::move(helper));
             return true;
         }
 
@@ -484,32 +274,27 @@ public:
             return;
         }
 
-        if (!apireq.done()) {
-            auto* response = request->beginResponseStream(
-                content_type::Json.toString(), root.measureLength() + 1);
-            root.printTo(*response);
-            request->send(response);
+        // response was already sent via Request::handle()
+        if (apireq.done()) {
             return;
         }
 
-        request->send(500);
+        auto* response = request->beginResponseStream(
+            content_type::Json.toString(), root.measureLength() + 1);
+        root.printTo(*response);
+        request->send(response);
     }
 
-    void _handlePut(AsyncWebServerRequest* request, uint8_t* data, size_t size) {
-        // XXX: arduinojson v5 de-serializer will happily read garbage from raw ptr, since there's no length limit
-        //      this is fixed in v6 though. for now, use a wrapper, but be aware that this actually uses more mem for the jsonbuffer
-        auto* ptr = reinterpret_cast<const char*>(data);
-        auto reader = StringView(ptr, ptr + size);
-
+    // arduinojson v5 de-serializer would happily read garbage from raw ptr, since there's no length limit
+    // body reader stops at its size. parsed strings are copied into the json buffer
+    void _handlePut(AsyncWebServerRequest* request, RequestHelper& helper, const Body& body) {
         DynamicJsonBuffer jsonBuffer(BufferSize);
-        JsonObject& root = jsonBuffer.parseObject(reader);
+        JsonObject& root = jsonBuffer.parseObject(body);
         if (!root.success()) {
             request->send(500);
             return;
         }
 
-        auto& helper = *reinterpret_cast<RequestHelper*>(request->_tempObject);
-
         auto apireq = helper.request();
         if (!_put(apireq, root)) {
             request->send(500);
@@ -523,9 +308,26 @@ public:
         return;
     }
 
-    void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t, size_t total) override {
-        if (total && (len == total)) {
-            _handlePut(request, data, total);
+    // PUT always has json content-type (see canHandle()), body of anything else is ignored
+    void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) override {
+        if (request->method() != HTTP_PUT) {
+            return;
+        }
+
+        auto& state = *request_state(request);
+
+        // error response was already sent
+        if (state.body.error() != Body::Error::None) {
+            return;
+        }
+
+        if (!state.body.append(data, len, index, total)) {
+            request->send((state.body.error() == Body::Error::TooLarge) ? 413 : 400);
+            return;
+        }
+
+        if (state.body.complete()) {
+            _handlePut(request, state.helper, state.body);
         }
     }
 
@@ -537,7 +339,7 @@ public:
             return;
         }
 
-        auto& helper = *reinterpret_cast<RequestHelper*>(request->_tempObject);
+        auto& helper = request_helper(request);
 
         switch (request->method()) {
         case HTTP_HEAD:
@@ -550,9 +352,14 @@ public:
             return;
         }
 
-        // see handleBody()
-        case HTTP_PUT:
+        // see handleBody(), response is already sent unless the body was empty
+        case HTTP_PUT: {
+            const auto& body = request_state(request)->body;
+            if (!body.complete() && (body.error() == Body::Error::None)) {
+                request->send(400);
+            }
             break;
+        }
 
         default:
             request->send(405);
@@ -571,8 +378,7 @@ private:
 // ESPurna legacy API configuration
 // - ?apikey=... to authorize in GET or PUT
 // - ?anything=... for input data (common key is "value")
-// MUST correctly override isRequestHandlerTrivial() to allow auth with PUT
-// (i.e. so that ESPAsyncWebServer parses the body and adds form-data to request params list)
+// Relies on ESPAsyncWebServer parsing the form-data body into the request params list, see WebDispatcher
 
 class BasicWebHandler final : public BaseWebHandler {
 public:
@@ -583,15 +389,7 @@ public:
         _put(std::forward<Put>(put))
     {}
 
-    bool isRequestHandlerTrivial() override {
-        return false;
-    }
-
-    bool canHandle(AsyncWebServerRequest* request) override {
-        if (!apiEnabled()) {
-            return false;
-        }
-
+    bool canHandle(AsyncWebServerRequest* request, RequestHelper&& helper) override {
         switch (request->method()) {
         case HTTP_HEAD:
         case HTTP_GET:
@@ -605,13 +403,8 @@ public:
             return false;
         }
 
-        auto helper = RequestHelper(*request, parts());
-        if (helper.match()) {
-            attach_helper(*request, std::move(helper));
-            return true;
-        }
-
-        return false;
+        attach_helper(*request, *this, std::move(helper));
+        return true;
     }
 
     void handleRequest(AsyncWebServerRequest* request) override {
@@ -640,7 +433,7 @@ public:
 
         case HTTP_GET:
         case HTTP_PUT: {
-            auto& helper = *reinterpret_cast<RequestHelper*>(request->_tempObject);
+            auto& helper = request_helper(request);
 
             auto apireq = helper.request();
             if (is_put) {
@@ -689,9 +482,74 @@ private:
     BasicHandler _put;
 };
 
+// Single webserver handler for every API path. Patterns are compiled into a PathTrie, so
+// the request path is parsed and resolved once instead of every handler re-parsing it in turn
+// When multiple patterns match the same path, the one registered first is used
+
+class WebDispatcher final : public AsyncWebHandler {
+public:
+    // Server only asks once, before any handler is known. JSON body is never form-data and
+    // is passed to the handleBody() as-is, while the basic handlers need the form-data params
+    bool isRequestHandlerTrivial() override {
+        return false;
+    }
+
+    bool canHandle(AsyncWebServerRequest* request) override {
+        if (!apiEnabled()) {
+            return false;
+        }
+
+        // &path is request->url(), see RequestHelper
+        PathParts path(request->url());
+
+        const auto id = _trie.match(path);
+        if (id == PathTrie::None) {
+            return false;
+        }
+
+        auto* handler = _handlers[id];
+        return handler->canHandle(request,
+            RequestHelper(*request, handler->parts(), std::move(path)));
+    }
+
+    void handleRequest(AsyncWebServerRequest* request) override {
+        auto* state = request_state(request);
+        if (!state) {
+            request->send(500);
+            return;
+        }
+
+        state->handler->handleRequest(request);
+    }
+
+    void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) override {
+        auto* state = request_state(request);
+        if (state) {
+            state->handler->handleBody(request, data, len, index, total);
+        }
+    }
+
+    bool add(BaseWebHandler* handler) {
+        if (!_trie.add(handler->parts(), _handlers.size())) {
+            return false;
+        }
+
+        _handlers.push_back(handler);
+        return true;
+    }
+
+    const std::vector<BaseWebHandler*>& handlers() const {
+        return _handlers;
+    }
+
+private:
+    PathTrie _trie;
+    std::vector<BaseWebHandler*> _handlers;
+};
+
 namespace internal {
 
-std::forward_list<BaseWebHandler*> list;
+WebDispatcher* dispatcher { nullptr };
 
 } // namespace internal
 
@@ -713,9 +571,20 @@ bool error(ApiRequest& request) {
 
 STRING_VIEW_INLINE(BasePath, API_BASE_PATH);
 
+WebDispatcher& dispatcher() {
+    if (!internal::dispatcher) {
+        internal::dispatcher = new WebDispatcher();
+        webServer().addHandler(internal::dispatcher);
+    }
+
+    return *internal::dispatcher;
+}
+
 void add(BaseWebHandler* ptr) {
-    webServer().addHandler(ptr);
-    internal::list.emplace_front(ptr);
+    if (!dispatcher().add(ptr)) {
+        DEBUG_MSG_P(PSTR("[API] Cannot register %s\n"), ptr->pattern().c_str());
+        delete ptr;
+    }
 }
 
 template <typename Handler, typename Get, typename Put>
@@ -739,7 +608,7 @@ void setup() {
         STRING_VIEW("list"),
         [](Request& request) {
             String paths;
-            for (auto& api : internal::list) {
+            for (auto* api : dispatcher().handlers()) {
                 paths += api->pattern();
                 paths += '\r';
                 paths += '\n';
@@ -46,3 +46,5 @@ bool apiRestFul();
 void apiCommonSetup();
 
 void apiSetup();
+void apiStateSetup();
+void apiEventsSetup();
@@ -0,0 +1,162 @@
+/*
+
+Part of the API MODULE
+
+Copyright (C) 2021 by Maxim Prokhorov <prokhorov dot max at outlook dot com>
+
+*/
+
+#pragma once
+
+#include <ArduinoJson.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace espurna {
+namespace api {
+
+// Request body, as it arrives from the webserver in multiple handleBody() calls
+// Data is copied into small fixed-size chunks instead of a single buffer of the total size,
+// and chunks are only allocated when they are needed. Total size cannot exceed the limit.
+struct Body {
+    static constexpr size_t ChunkSize { 256 };
+
+    enum class Error {
+        None,
+        TooLarge,
+        Unexpected,
+    };
+
+    Body() = delete;
+    explicit Body(size_t limit) :
+        _limit(limit)
+    {}
+
+    // false when data cannot be stored, see error()
+    bool append(const uint8_t* data, size_t length, size_t index, size_t total) {
+        if (_error != Error::None) {
+            return false;
+        }
+
+        if (!index && !_total) {
+            if (total > _limit) {
+                _error = Error::TooLarge;
+                return false;
+            }
+
+            _total = total;
+            _chunks.reserve((total + ChunkSize - 1) / ChunkSize);
+        }
+
+        // server always sends data in order; anything else is a broken request
+        if ((index != _size) || (total != _total) || (length > (_total - _size))) {
+            _error = Error::Unexpected;
+            return false;
+        }
+
+        while (length) {
+            const auto offset = _size % ChunkSize;
+            if (!offset) {
+                _chunks.emplace_back(new char[ChunkSize]);
+            }
+
+            const auto size = std::min(length, ChunkSize - offset);
+            std::memcpy(_chunks.back().get() + offset, data, size);
+
+            data += size;
+            length -= size;
+            _size += size;
+        }
+
+        return true;
+    }
+
+    Error error() const {
+        return _error;
+    }
+
+    bool complete() const {
+        return _total && (_size == _total);
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    char operator[](size_t index) const {
+        return _chunks[index / ChunkSize][index % ChunkSize];
+    }
+
+private:
+    using Chunk = std::unique_ptr<char[]>;
+
+    size_t _limit;
+    size_t _total { 0 };
+    size_t _size { 0 };
+
+    std::vector<Chunk> _chunks;
+    Error _error { Error::None };
+};
+
+} // namespace api
+} // namespace espurna
+
+namespace ArduinoJson {
+namespace Internals {
+
+// Allow to pass the body to the parser as-is. Strings are copied into the JsonBuffer,
+// same as with any other read-only input. See StringView adapter in web_utils.h
+
+template <>
+struct StringTraits<::espurna::api::Body, void> {
+    struct Reader {
+        Reader(const ::espurna::api::Body& body) :
+            _body(body)
+        {}
+
+        void move() {
+            _current = _next;
+            _next = '\0';
+        }
+
+        char current() {
+            if (!_current) {
+                _current = read();
+            }
+            return _current;
+        }
+
+        char next() {
+            if (!_next) {
+                _next = read();
+            }
+            return _next;
+        }
+
+    private:
+        char read() {
+            if (_index < _body.size()) {
+                return _body[_index++];
+            }
+
+            return '\0';
+        }
+
+        const ::espurna::api::Body& _body;
+        size_t _index { 0 };
+
+        char _current = 0;
+        char _next = 0;
+    };
+
+    static const bool has_append = false;
+    static const bool has_equals = false;
+    static const bool should_duplicate = true;
+};
+
+} // namespace Internals
+} // namespace ArduinoJson
@@ -84,7 +84,7 @@ void onConnected(JsonObject& root) {
 void setup() {
     wsRegister()
         .onVisible(onVisible)
-        .onConnected(onConnected)
+        .onConnected(Prefix, onConnected)
         .onKeyCheck(onKeyCheck);
 }
 
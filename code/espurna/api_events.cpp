@@ -0,0 +1,435 @@
+/*
+
+Part of the API MODULE
+
+Copyright (C) 2020-2021 by Maxim Prokhorov <prokhorov dot max at outlook dot com>
+
+*/
+
+#include "espurna.h"
+
+#if API_SUPPORT && API_EVENTS_SUPPORT
+
+#include "api.h"
+#include "relay.h"
+#include "sensor.h"
+#include "web.h"
+
+#if LIGHT_PROVIDER != LIGHT_PROVIDER_NONE
+#include "light.h"
+#endif
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Live updates as Server-Sent Events, for consumers that would otherwise poll the API
+// ref. https://html.spec.whatwg.org/multipage/server-sent-events.html
+//
+// GET /api/events?apikey=...
+// event: relay
+// data: {"id":0,"status":1}
+//
+// event: magnitude
+// data: {"topic":"temperature/0","value":"21.5","units":"°C"}
+//
+// Connection does not queue the messages. Instead, every stream remembers which relays, magnitudes
+// or light were updated and writes out the latest values when there is enough space in the TCP
+// send buffer. Slow reader only receives fewer events, memory usage stays the same.
+// Right after connecting, everything is marked as updated and sent as a snapshot.
+
+namespace espurna {
+namespace api {
+namespace events {
+namespace build {
+namespace {
+
+constexpr bool relaySupport() {
+    return 1 == RELAY_SUPPORT;
+}
+
+constexpr bool sensorSupport() {
+    return 1 == SENSOR_SUPPORT;
+}
+
+constexpr size_t clientsMax() {
+    return API_EVENTS_CLIENTS_MAX;
+}
+
+// comment line, only to keep intermediate proxies and the TCP connection alive
+constexpr auto KeepAlive = duration::Seconds(15);
+
+// single event is formatted on stack, anything longer is not sent
+constexpr size_t EventSize { 192 };
+
+} // namespace
+} // namespace build
+
+namespace {
+
+STRING_VIEW_INLINE(Path, API_BASE_PATH "events");
+
+class Client {
+public:
+    explicit Client(AsyncClient* client);
+
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    Client(Client&&) = delete;
+    Client& operator=(Client&&) = delete;
+
+    void relay(size_t id) {
+        _relays |= (1ul << id);
+    }
+
+    void magnitude(size_t index) {
+        if (index < _magnitudes.size()) {
+            _magnitudes[index] = true;
+        }
+    }
+
+    void light() {
+        _light = true;
+    }
+
+    void flush();
+
+private:
+    bool send_relays(bool& sent);
+    bool send_magnitudes(bool& sent);
+    bool send_light(bool& sent);
+
+    bool add(const char* data, int length);
+    void keepalive();
+
+    AsyncClient* _client;
+    time::CoreClock::time_point _last;
+
+    uint32_t _relays { 0 };
+    std::vector<bool> _magnitudes;
+    bool _light { false };
+};
+
+namespace internal {
+
+std::vector<std::unique_ptr<Client>> clients;
+
+} // namespace internal
+
+void detach(Client* ptr) {
+    auto& clients = internal::clients;
+    clients.erase(
+        std::remove_if(
+            clients.begin(),
+            clients.end(),
+            [&](const std::unique_ptr<Client>& client) {
+                return client.get() == ptr;
+            }),
+        clients.end());
+}
+
+// Request is no longer needed after the response headers are acknowledged,
+// connection is owned by the stream until it is disconnected
+Client::Client(AsyncClient* client) :
+    _client(client),
+    _last(time::CoreClock::now()),
+    _relays(build::relaySupport()
+        ? ((relayCount() < 32)
+            ? ((1ul << relayCount()) - 1ul)
+            : std::numeric_limits<uint32_t>::max())
+        : 0),
+    _magnitudes(build::sensorSupport() ? magnitudeCount() : 0, true),
+#if LIGHT_PROVIDER != LIGHT_PROVIDER_NONE
+    _light(true)
+#else
+    _light(false)
+#endif
+{
+    _client->setRxTimeout(0);
+    _client->onError(nullptr, nullptr);
+    _client->onData(nullptr, nullptr);
+    _client->onAck(
+        [](void* arg, AsyncClient*, size_t, uint32_t) {
+            static_cast<Client*>(arg)->flush();
+        }, this);
+    _client->onPoll(
+        [](void* arg, AsyncClient*) {
+            static_cast<Client*>(arg)->flush();
+        }, this);
+    _client->onTimeout(
+        [](void*, AsyncClient* client, uint32_t) {
+            client->close(true);
+        }, nullptr);
+    _client->onDisconnect(
+        [](void* arg, AsyncClient* client) {
+            detach(static_cast<Client*>(arg));
+            delete client;
+        }, this);
+}
+
+// formatted events are always expected to fit into the buffer, skip the ones that do not
+bool Client::add(const char* data, int length) {
+    if ((length <= 0) || (static_cast<size_t>(length) >= build::EventSize)) {
+        return true;
+    }
+
+    if (_client->space() < static_cast<size_t>(length)) {
+        return false;
+    }
+
+    _client->add(data, length, ASYNC_WRITE_FLAG_COPY);
+    _last = time::CoreClock::now();
+
+    return true;
+}
+
+void Client::keepalive() {
+    if (time::CoreClock::now() - _last < build::KeepAlive) {
+        return;
+    }
+
+    const char comment[] = ":\n\n";
+    if (add(comment, sizeof(comment) - 1)) {
+        _client->send();
+    }
+}
+
+// Appends to the formatted event, nothing is written after the output was truncated
+// Resulting length is either negative or at least the buffer size in that case, see add()
+template <typename... Args>
+void append(char* buffer, size_t size, int& length, const char* format, Args&&... args) {
+    if ((length < 0) || (static_cast<size_t>(length) >= size)) {
+        return;
+    }
+
+    const int result = snprintf_P(&buffer[length], size - length,
+        format, std::forward<Args>(args)...);
+    length = (result < 0) ? result : (length + result);
+}
+
+// false when send buffer is full, remaining events are sent on the next ack or poll
+bool Client::send_relays(bool& sent) {
+    char buffer[build::EventSize];
+
+    for (size_t id = 0; _relays && (id < relayCount()); ++id) {
+        const auto mask = (1ul << id);
+        if (!(_relays & mask)) {
+            continue;
+        }
+
+        const int length = snprintf_P(buffer, sizeof(buffer),
+            PSTR("event: relay\ndata: {\"id\":%u,\"status\":%d}\n\n"),
+            id, relayStatus(id) ? 1 : 0);
+        if (!add(buffer, length)) {
+            return false;
+        }
+
+        _relays &= ~mask;
+        sent = true;
+    }
+
+    return true;
+}
+
+bool Client::send_magnitudes(bool& sent) {
+    char buffer[build::EventSize];
+
+    for (size_t index = 0; index < _magnitudes.size(); ++index) {
+        if (!_magnitudes[index]) {
+            continue;
+        }
+
+        const auto value = magnitudeReportValue(index);
+        const InlineString<15> units(magnitudeUnitsView(value.units));
+
+        const int length = snprintf_P(buffer, sizeof(buffer),
+            PSTR("event: magnitude\ndata: {\"topic\":\"%s\",\"value\":\"%s\",\"units\":\"%s\"}\n\n"),
+            value.topic.c_str(), value.repr.c_str(), units.c_str());
+        if (!add(buffer, length)) {
+            return false;
+        }
+
+        _magnitudes[index] = false;
+        sent = true;
+    }
+
+    return true;
+}
+
+bool Client::send_light(bool& sent) {
+#if LIGHT_PROVIDER != LIGHT_PROVIDER_NONE
+    if (!_light) {
+        return true;
+    }
+
+    char buffer[build::EventSize];
+
+    int length = snprintf_P(buffer, sizeof(buffer),
+        PSTR("event: light\ndata: {\"state\":%d,\"brightness\":%ld,\"channels\":["),
+        lightState() ? 1 : 0, lightBrightness());
+
+    for (size_t index = 0; index < lightChannels(); ++index) {
+        append(buffer, sizeof(buffer), length,
+            PSTR("%s%ld"), index ? "," : "", lightChannel(index));
+    }
+
+    append(buffer, sizeof(buffer), length, PSTR("]}\n\n"));
+    if (!add(buffer, length)) {
+        return false;
+    }
+
+    _light = false;
+    sent = true;
+#endif
+
+    return true;
+}
+
+void Client::flush() {
+    if (!_client->connected() || !_client->canSend()) {
+        return;
+    }
+
+    bool sent { false };
+    if (send_relays(sent) && send_magnitudes(sent)) {
+        send_light(sent);
+    }
+
+    if (sent) {
+        _client->send();
+        return;
+    }
+
+    keepalive();
+}
+
+// Same as the built-in AsyncEventSource response, but the connection is handed over to our own client
+class Response : public AsyncWebServerResponse {
+public:
+    Response() {
+        _code = 200;
+        _contentType = F("text/event-stream");
+        _sendContentLength = false;
+        addHeader(F("Cache-Control"), F("no-cache"));
+        addHeader(F("Connection"), F("keep-alive"));
+    }
+
+    void _respond(AsyncWebServerRequest* request) override {
+        const auto head = _assembleHead(request->version());
+        request->client()->write(head.c_str(), _headLength);
+        _state = RESPONSE_WAIT_ACK;
+    }
+
+    // request *and* this response are destroyed here, nothing should be accessed afterwards
+    size_t _ack(AsyncWebServerRequest* request, size_t length, uint32_t) override {
+        if (length) {
+            internal::clients.emplace_back(
+                std::make_unique<Client>(request->client()));
+            delete request;
+        }
+
+        return 0;
+    }
+
+    bool _sourceValid() const override {
+        return true;
+    }
+};
+
+class Handler : public AsyncWebHandler {
+public:
+    bool canHandle(AsyncWebServerRequest* request) override {
+        if (request->method() != HTTP_GET) {
+            return false;
+        }
+
+        if (!apiEnabled() || (StringView(request->url()) != Path)) {
+            return false;
+        }
+
+        STRING_VIEW_INLINE(ApiKey, "Api-Key");
+        request->addInterestingHeader(ApiKey.toString());
+
+        return true;
+    }
+
+    void handleRequest(AsyncWebServerRequest* request) override {
+        if (!apiAuthenticate(request)) {
+            request->send(403);
+            return;
+        }
+
+        if (internal::clients.size() >= build::clientsMax()) {
+            request->send(503);
+            return;
+        }
+
+        request->send(new Response());
+    }
+};
+
+void flush() {
+    for (auto& client : internal::clients) {
+        client->flush();
+    }
+}
+
+// callbacks only mark things as updated, actual writes happen in the loop
+template <typename T>
+void update(T&& callback) {
+    if (internal::clients.empty()) {
+        return;
+    }
+
+    for (auto& client : internal::clients) {
+        callback(*client);
+    }
+
+    espurnaRegisterOnceUnique(flush);
+}
+
+void setup() {
+    webServer().addHandler(new Handler());
+
+    if (build::relaySupport()) {
+        relayOnStatusChange([](size_t id, bool) {
+            update([&](Client& client) {
+                client.relay(id);
+            });
+        });
+    }
+
+    if (build::sensorSupport()) {
+        sensorOnMagnitudeReport([](const sensor::Value& value) {
+            update([&](Client& client) {
+                for (size_t index = 0; index < magnitudeCount(); ++index) {
+                    if ((magnitudeType(index) == value.type) && (magnitudeIndex(index) == value.index)) {
+                        client.magnitude(index);
+                        break;
+                    }
+                }
+            });
+        });
+    }
+
+#if LIGHT_PROVIDER != LIGHT_PROVIDER_NONE
+    lightOnReport([]() {
+        update([](Client& client) {
+            client.light();
+        });
+    });
+#endif
+}
+
+} // namespace
+} // namespace events
+} // namespace api
+} // namespace espurna
+
+void apiEventsSetup() {
+    espurna::api::events::setup();
+}
+
+#endif // API_SUPPORT && API_EVENTS_SUPPORT
@@ -0,0 +1,350 @@
+/*
+
+Part of the API MODULE
+
+Copyright (C) 2021 by Maxim Prokhorov <prokhorov dot max at outlook dot com>
+
+*/
+
+#include "api_path.h"
+
+#include <algorithm>
+#include <cstring>
+
+PathParts::PathParts(espurna::StringView path) :
+    _path(path)
+{
+    if (!_path.length()) {
+        _ok = false;
+        return;
+    }
+
+    PathPart::Type type { PathPart::Type::Unknown };
+    size_t length { 0ul };
+    size_t offset { 0ul };
+
+    const char* p { _path.begin() };
+    if (*p == '\0') {
+       goto error;
+    }
+
+    _parts.reserve(std::count(_path.begin(), _path.end(), '/') + 1);
+
+start:
+    type = PathPart::Type::Unknown;
+    length = 0;
+    offset = p - _path.c_str();
+
+    switch (*p) {
+    case '+':
+        goto parse_single_wildcard;
+    case '#':
+        goto parse_multi_wildcard;
+    case '/':
+    default:
+        goto parse_value;
+    }
+
+parse_value:
+    type = PathPart::Type::Value;
+
+    switch (*p) {
+    case '+':
+    case '#':
+        goto error;
+    case '/':
+    case '\0':
+        goto push_result;
+    }
+
+    ++p;
+    ++length;
+
+    goto parse_value;
+
+parse_single_wildcard:
+    type = PathPart::Type::SingleWildcard;
+
+    ++p;
+    switch (*p) {
+    case '/':
+        ++p;
+    case '\0':
+        goto push_result;
+    }
+
+    goto error;
+
+parse_multi_wildcard:
+    type = PathPart::Type::MultiWildcard;
+
+    ++p;
+    if (*p == '\0') {
+        goto push_result;
+    }
+    goto error;
+
+push_result:
+    emplace_back(type, offset, length);
+    if (*p == '/') {
+        ++p;
+        goto start;
+    } else if (*p != '\0') {
+        goto start;
+    }
+    goto success;
+
+error:
+    _ok = false;
+    _parts.clear();
+    return;
+
+success:
+    _ok = true;
+}
+
+// match when, for example, given the path 'topic/one/two/three' and pattern 'topic/+/two/+'
+
+bool PathParts::match(const PathParts& path) const {
+    if (!_ok || !path) {
+        return false;
+    }
+
+    auto lhs = begin();
+    auto lhs_end = end();
+
+    auto rhs = path.begin();
+    auto rhs_end = path.end();
+loop:
+    if (lhs == lhs_end) {
+        goto check_end;
+    }
+
+    switch ((*lhs).type) {
+    case PathPart::Type::Value:
+        if (
+            (rhs != rhs_end)
+            && ((*rhs).type == PathPart::Type::Value)
+            && ((*rhs).length == (*lhs).length)
+        ) {
+            if (0 == std::memcmp(
+                _path.c_str() + (*lhs).offset,
+                path.path().c_str() + (*rhs).offset,
+                (*rhs).length))
+            {
+                std::advance(lhs, 1);
+                std::advance(rhs, 1);
+                goto loop;
+            }
+        }
+        goto error;
+
+    case PathPart::Type::SingleWildcard:
+        if (
+            (rhs != rhs_end)
+            && ((*rhs).type == PathPart::Type::Value)
+        ) {
+            std::advance(lhs, 1);
+            std::advance(rhs, 1);
+            goto loop;
+        }
+        goto error;
+
+    case PathPart::Type::MultiWildcard:
+        if (std::next(lhs) == lhs_end) {
+            while (rhs != rhs_end) {
+                if ((*rhs).type != PathPart::Type::Value) {
+                    goto error;
+                }
+                std::advance(rhs, 1);
+            }
+            lhs = lhs_end;
+            break;
+        }
+        goto error;
+
+    case PathPart::Type::Unknown:
+        goto error;
+    };
+
+check_end:
+    if ((lhs == lhs_end) && (rhs == rhs_end)) {
+        return true;
+    }
+
+error:
+    return false;
+}
+
+espurna::StringView PathParts::wildcard(const PathParts& pattern, const PathParts& value, int index) {
+    if (index < 0) {
+        index = std::abs(index + 1);
+    }
+
+    espurna::StringView out;
+
+    if (std::abs(index) < pattern.parts().size()) {
+        const auto& pattern_parts = pattern.parts();
+        int counter { 0 };
+
+        for (size_t part = 0; part < pattern.size(); ++part) {
+            const auto& lhs = pattern_parts[part];
+            const auto& rhs = value.parts()[part];
+
+            const auto path = value.path();
+
+            switch (lhs.type) {
+            case PathPart::Type::Value:
+            case PathPart::Type::Unknown:
+                break;
+
+            case PathPart::Type::SingleWildcard:
+                if (counter == index) {
+                    out = espurna::StringView(
+                        path.begin() + rhs.offset, path.begin() + rhs.offset + rhs.length);
+                    return out;
+                }
+                ++counter;
+                break;
+
+            case PathPart::Type::MultiWildcard:
+                if (counter == index) {
+                    out = espurna::StringView(
+                        path.begin() + rhs.offset, path.end());
+                }
+                return out;
+            }
+        }
+    }
+
+    return out;
+}
+
+size_t PathParts::wildcards(const PathParts& pattern) {
+    size_t out { 0 };
+
+    for (const auto& part : pattern) {
+        switch (part.type) {
+        case PathPart::Type::Unknown:
+        case PathPart::Type::Value:
+        case PathPart::Type::MultiWildcard:
+            break;
+        case PathPart::Type::SingleWildcard:
+            ++out;
+            break;
+        }
+    }
+
+    return out;
+}
+
+PathTrie::PathTrie() {
+    _nodes.push_back(Node{
+        .type = PathPart::Type::Unknown,
+        .value = espurna::StringView(),
+        .child = Empty,
+        .sibling = Empty,
+        .id = None,
+    });
+}
+
+PathTrie::Index PathTrie::emplace(Index parent, PathPart::Type type, espurna::StringView value) {
+    Index last { Empty };
+    for (auto index = _nodes[parent].child; index != Empty; index = _nodes[index].sibling) {
+        const auto& node = _nodes[index];
+        if ((node.type == type) && ((type != PathPart::Type::Value) || (node.value == value))) {
+            return index;
+        }
+
+        last = index;
+    }
+
+    const auto out = _nodes.size();
+    _nodes.push_back(Node{
+        .type = type,
+        .value = value,
+        .child = Empty,
+        .sibling = Empty,
+        .id = None,
+    });
+
+    if (last != Empty) {
+        _nodes[last].sibling = out;
+    } else {
+        _nodes[parent].child = out;
+    }
+
+    return out;
+}
+
+bool PathTrie::add(const PathParts& pattern, Id id) {
+    if (!pattern || (id == None)) {
+        return false;
+    }
+
+    auto node = Root;
+    for (size_t part = 0; part < pattern.size(); ++part) {
+        const auto type = pattern.parts()[part].type;
+        if (type == PathPart::Type::Unknown) {
+            return false;
+        }
+
+        node = emplace(node, type, pattern[part]);
+    }
+
+    if (_nodes[node].id != None) {
+        return false;
+    }
+
+    _nodes[node].id = id;
+    return true;
+}
+
+// Every branch that is able to match the path is visited, only the lowest id is kept
+
+void PathTrie::match(Index node, const PathParts& path, size_t part, Id& out) const {
+    const auto& current = _nodes[node];
+    if (part == path.size()) {
+        out = std::min(out, current.id);
+    }
+
+    for (auto index = current.child; index != Empty; index = _nodes[index].sibling) {
+        const auto& next = _nodes[index];
+        switch (next.type) {
+        case PathPart::Type::Value:
+            if ((part < path.size()) && (next.value == path[part])) {
+                match(index, path, part + 1, out);
+            }
+            break;
+
+        case PathPart::Type::SingleWildcard:
+            if (part < path.size()) {
+                match(index, path, part + 1, out);
+            }
+            break;
+
+        // consumes the rest of the path, including the empty one
+        case PathPart::Type::MultiWildcard:
+            out = std::min(out, next.id);
+            break;
+
+        case PathPart::Type::Unknown:
+            break;
+        }
+    }
+}
+
+PathTrie::Id PathTrie::match(const PathParts& path) const {
+    Id out { None };
+
+    // request path is never expected to have wildcards, see PathParts::match
+    if (path && std::all_of(path.begin(), path.end(),
+        [](const PathPart& part) {
+            return part.type == PathPart::Type::Value;
+        }))
+    {
+        match(Root, path, 0, out);
+    }
+
+    return out;
+}
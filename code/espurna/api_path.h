@@ -9,6 +9,8 @@ Copyright (C) 2021 by Maxim Prokhorov <prokhorov dot max at outlook dot com>
 #pragma once
 
 #include <Arduino.h>
+
+#include <limits>
 #include <vector>
 
 #include "types.h"
@@ -127,3 +129,47 @@ private:
     Parts _parts;
     bool _ok { false };
 };
+
+// Set of patterns stored as a tree of their parts, where patterns with the same prefix also share the nodes.
+// Instead of trying every pattern in turn, path is matched by walking the tree once. Single-level '+' and
+// multi-level '#' nodes are followed together with the exact values, and when more than one pattern
+// matches the path, the one that was added first is returned.
+// Pattern strings are referenced and not copied, they must outlive the tree.
+
+struct PathTrie {
+    using Id = size_t;
+    static constexpr Id None { std::numeric_limits<Id>::max() };
+
+    PathTrie();
+
+    // false when pattern is invalid or already exists
+    bool add(const PathParts& pattern, Id id);
+
+    // None when there is no match
+    Id match(const PathParts& path) const;
+    Id match(espurna::StringView path) const {
+        return match(PathParts(path));
+    }
+
+    size_t size() const {
+        return _nodes.size();
+    }
+
+private:
+    using Index = size_t;
+    static constexpr Index Root { 0 };
+    static constexpr Index Empty { std::numeric_limits<Index>::max() };
+
+    struct Node {
+        PathPart::Type type;
+        espurna::StringView value;
+        Index child;
+        Index sibling;
+        Id id;
+    };
+
+    Index emplace(Index parent, PathPart::Type type, espurna::StringView value);
+    void match(Index node, const PathParts& path, size_t part, Id& out) const;
+
+    std::vector<Node> _nodes;
+};
@@ -0,0 +1,277 @@
+/*
+
+Part of the API MODULE
+
+Copyright (C) 2020-2021 by Maxim Prokhorov <prokhorov dot max at outlook dot com>
+
+*/
+
+#include "espurna.h"
+
+#if API_SUPPORT && API_STATE_SUPPORT
+
+#include "api.h"
+#include "relay.h"
+#include "sensor.h"
+#include "system.h"
+#include "web.h"
+
+#if LIGHT_PROVIDER != LIGHT_PROVIDER_NONE
+#include "light.h"
+#endif
+
+// Snapshot of the device state as a single response, instead of polling every relay, magnitude
+// and light endpoint separately. Output is generated twice; first time to calculate the version
+// tag, second time directly into the response stream (and only when tag did not match)
+// System stats change on every request, so they are only sent when asked for and without the tag
+//
+// GET /api/state?fields=relays,magnitudes
+// {"relays":[1,0],"magnitudes":[{"topic":"temperature/0","value":"21.5","units":"°C","error":0}]}
+
+namespace espurna {
+namespace api {
+namespace state {
+namespace build {
+namespace {
+
+constexpr bool relaySupport() {
+    return 1 == RELAY_SUPPORT;
+}
+
+constexpr bool sensorSupport() {
+    return 1 == SENSOR_SUPPORT;
+}
+
+} // namespace
+} // namespace build
+
+namespace {
+
+enum Field : uint8_t {
+    FieldRelays = 1 << 0,
+    FieldMagnitudes = 1 << 1,
+    FieldLight = 1 << 2,
+    FieldSystem = 1 << 3,
+    FieldState = FieldRelays | FieldMagnitudes | FieldLight,
+};
+
+struct FieldName {
+    StringView name;
+    Field field;
+};
+
+STRING_VIEW_INLINE(Relays, "relays");
+STRING_VIEW_INLINE(Magnitudes, "magnitudes");
+STRING_VIEW_INLINE(Light, "light");
+STRING_VIEW_INLINE(System, "system");
+
+constexpr FieldName FieldNames[] {
+    {Relays, FieldRelays},
+    {Magnitudes, FieldMagnitudes},
+    {Light, FieldLight},
+    {System, FieldSystem},
+};
+
+// Comma-separated list of names, unknown ones are ignored
+// Missing or empty list selects everything except the system stats
+uint8_t parse_fields(StringView value) {
+    if (!value.length()) {
+        return FieldState;
+    }
+
+    uint8_t out { 0 };
+
+    auto split = SplitStringView(value, ',');
+    while (split.next()) {
+        const auto current = split.current();
+        for (const auto& entry : FieldNames) {
+            if (current == entry.name) {
+                out |= entry.field;
+                break;
+            }
+        }
+    }
+
+    return out;
+}
+
+// FNV-1a of everything that was printed
+class Digest : public Print {
+public:
+    static constexpr uint32_t Basis { 2166136261ul };
+    static constexpr uint32_t Prime { 16777619ul };
+
+    size_t write(uint8_t c) override {
+        _value = (_value ^ c) * Prime;
+        return 1;
+    }
+
+    size_t write(const uint8_t* data, size_t size) override {
+        for (size_t index = 0; index < size; ++index) {
+            write(data[index]);
+        }
+
+        return size;
+    }
+
+    uint32_t value() const {
+        return _value;
+    }
+
+private:
+    uint32_t _value { Basis };
+};
+
+void print_key(Print& out, bool& first, StringView key) {
+    if (!first) {
+        out.print(',');
+    }
+
+    first = false;
+
+    out.print('"');
+    out.print(FPSTR(key.c_str()));
+    out.print(F("\":"));
+}
+
+void print_relays(Print& out) {
+    out.print('[');
+    for (size_t index = 0; index < relayCount(); ++index) {
+        if (index) {
+            out.print(',');
+        }
+        out.print(relayStatusTarget(index) ? '1' : '0');
+    }
+    out.print(']');
+}
+
+void print_magnitudes(Print& out) {
+    out.print('[');
+
+    for (size_t index = 0; index < magnitudeCount(); ++index) {
+        if (index) {
+            out.print(',');
+        }
+
+        const auto value = magnitudeValue(index);
+        const auto units = magnitudeUnitsName(value.units);
+
+        out.printf_P(
+            PSTR("{\"topic\":\"%s\",\"value\":\"%s\",\"units\":\"%s\",\"error\":%hhu}"),
+            value.topic.c_str(), value.repr.c_str(), units.c_str(), magnitudeError(index));
+    }
+
+    out.print(']');
+}
+
+#if LIGHT_PROVIDER != LIGHT_PROVIDER_NONE
+void print_light(Print& out) {
+    out.printf_P(PSTR("{\"state\":%d,\"brightness\":%ld,\"channels\":["),
+        lightState() ? 1 : 0, lightBrightness());
+
+    for (size_t index = 0; index < lightChannels(); ++index) {
+        if (index) {
+            out.print(',');
+        }
+        out.print(lightChannel(index));
+    }
+
+    out.print(F("]}"));
+}
+#endif
+
+void print_system(Print& out) {
+    out.printf_P(PSTR("{\"uptime\":%u,\"heap\":%u,\"loadaverage\":%lu,\"rssi\":%d}"),
+        systemUptime().count(), systemFreeHeap(), systemLoadAverage(), WiFi.RSSI());
+}
+
+void print(Print& out, uint8_t fields) {
+    bool first { true };
+    out.print('{');
+
+    if (build::relaySupport() && (fields & FieldRelays)) {
+        print_key(out, first, Relays);
+        print_relays(out);
+    }
+
+    if (build::sensorSupport() && (fields & FieldMagnitudes)) {
+        print_key(out, first, Magnitudes);
+        print_magnitudes(out);
+    }
+
+#if LIGHT_PROVIDER != LIGHT_PROVIDER_NONE
+    if (fields & FieldLight) {
+        print_key(out, first, Light);
+        print_light(out);
+    }
+#endif
+
+    if (fields & FieldSystem) {
+        print_key(out, first, System);
+        print_system(out);
+    }
+
+    out.print('}');
+}
+
+STRING_VIEW_INLINE(ETag, "ETag");
+STRING_VIEW_INLINE(IfNoneMatch, "If-None-Match");
+
+// Request may send back more than one tag, any one of them matching is enough
+bool matches(AsyncWebServerRequest* request, const String& tag) {
+    auto* header = request->getHeader(IfNoneMatch.toString());
+    return header && (header->value().indexOf(tag) >= 0);
+}
+
+void handler(AsyncWebServerRequest* request, uint8_t fields) {
+    if (fields & FieldSystem) {
+        auto* response = request->beginResponseStream(F("application/json"));
+        print(*response, fields);
+        request->send(response);
+        return;
+    }
+
+    Digest digest;
+    print(digest, fields);
+
+    char buffer[16];
+    snprintf_P(buffer, sizeof(buffer), PSTR("\"%08x\""), digest.value());
+
+    const String tag(buffer);
+    if (matches(request, tag)) {
+        auto* response = request->beginResponse(304);
+        response->addHeader(ETag.toString(), tag);
+        request->send(response);
+        return;
+    }
+
+    auto* response = request->beginResponseStream(F("application/json"));
+    response->addHeader(ETag.toString(), tag);
+    print(*response, fields);
+    request->send(response);
+}
+
+void setup() {
+    apiRegister(F("state"),
+        [](ApiRequest& request, JsonObject&) {
+            STRING_VIEW_INLINE(Fields, "fields");
+            const auto fields = parse_fields(request.param(Fields.toString()));
+            request.handle([&](AsyncWebServerRequest* ptr) {
+                handler(ptr, fields);
+            });
+            return true;
+        },
+        nullptr
+    );
+}
+
+} // namespace
+} // namespace state
+} // namespace api
+} // namespace espurna
+
+void apiStateSetup() {
+    espurna::api::state::setup();
+}
+
+#endif // API_SUPPORT && API_STATE_SUPPORT
@@ -433,6 +433,13 @@
 #define RELAY_SAVE_DELAY            1000
 #endif
 
+// Time (in ms) to collect relay status changes before notifying mqtt, websocket and other modules
+// Only the latest status of each relay is reported, or both edges of a pulse shorter than the window
+// Disabled by default, every change is reported right away
+#ifndef RELAY_REPORT_WINDOW
+#define RELAY_REPORT_WINDOW         0
+#endif
+
 // Configure the MQTT payload for ON, OFF and TOGGLE
 #ifndef RELAY_MQTT_OFF
 #define RELAY_MQTT_OFF              "0"
@@ -710,6 +717,10 @@
 #define WS_UPDATE_INTERVAL          30          // Time (in seconds) between periodic status updates sent out to every client
 #endif
 
+#ifndef WS_DELTA_RESYNC_INTERVAL
+#define WS_DELTA_RESYNC_INTERVAL    60          // Time (in seconds) after which unchanged values of the delta updates are sent again
+#endif
+
 // -----------------------------------------------------------------------------
 // API
 // -----------------------------------------------------------------------------
@@ -736,10 +747,27 @@
 #define API_JSON_BUFFER_SIZE        256         // Size of the (de)serializer buffer.
 #endif
 
+#ifndef API_JSON_BODY_SIZE
+#define API_JSON_BODY_SIZE          4096        // Maximum size of the JSON request body. Stored in small chunks,
+                                                // which are allocated as the data arrives
+#endif
+
 #ifndef API_BASE_PATH
 #define API_BASE_PATH               "/api/"
 #endif
 
+#ifndef API_STATE_SUPPORT
+#define API_STATE_SUPPORT           API_SUPPORT // Relays, magnitudes, light and system stats as a single JSON response
+#endif
+
+#ifndef API_EVENTS_SUPPORT
+#define API_EVENTS_SUPPORT          API_SUPPORT // Relay, magnitude and light updates as Server-Sent Events stream
+#endif
+
+#ifndef API_EVENTS_CLIENTS_MAX
+#define API_EVENTS_CLIENTS_MAX      2           // Maximum number of concurrent event streams
+#endif
+
 // -----------------------------------------------------------------------------
 // MDNS / LLMNR / NETBIOS / SSDP
 // -----------------------------------------------------------------------------
@@ -1238,6 +1266,10 @@
 #define LIGHT_TRANSITION_TIME   500         // Time in millis from color to color
 #endif
 
+#ifndef LIGHT_TRANSITION_CURVE
+#define LIGHT_TRANSITION_CURVE  0           // Shape of the transition (0 - linear, 1 - ease-in, 2 - ease-out, 3 - ease-in-out, 4 - perceptual)
+#endif
+
 // -----------------------------------------------------------------------------
 // DOMOTICZ
 // -----------------------------------------------------------------------------
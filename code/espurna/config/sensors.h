@@ -57,6 +57,18 @@
                                                             // Warning: this might wear out flash fast!
 #endif
 
+#ifndef SENSOR_ENERGY_JOURNAL_SECTORS
+#define SENSOR_ENERGY_JOURNAL_SECTORS       2               // Flash sectors used to store energy totals, placed right below the EEPROM sectors
+                                                            // Records are appended and a sector is only erased after the whole journal is filled
+                                                            // 0 to store totals in the settings instead
+                                                            // Without the FS area (1MB flash), totals are moved back to the settings when OTA starts
+#endif
+
+#ifndef SENSOR_IMMEDIATE_READ_INTERVAL
+#define SENSOR_IMMEDIATE_READ_INTERVAL      1000            // (ms) Minimum time between on-demand reads of the same sensor
+                                                            // (through `read/<ID>` API and MQTT topics, or the MAGNITUDES.READ command)
+#endif
+
 #ifndef SENSOR_PUBLISH_ADDRESSES
 #define SENSOR_PUBLISH_ADDRESSES            0               // Publish sensor addresses
 #endif
@@ -460,6 +472,29 @@
 #define EMON_FILTER_SPEED               512         // Mobile average filter speed
 #endif
 
+#ifndef EMON_FIXED_POINT
+#define EMON_FIXED_POINT                0           // Use integer math when sampling (instead of doubles)
+#endif
+
+#ifndef EMON_BACKGROUND_SAMPLING
+#define EMON_BACKGROUND_SAMPLING        0           // Capture samples from the timer instead of blocking the loop when reading
+                                                    // (only for the internal ADC, EMON_ANALOG_SUPPORT)
+#endif
+
+#ifndef EMON_BACKGROUND_INTERVAL
+#define EMON_BACKGROUND_INTERVAL        7           // Sampling timer interval (in ms, min is 5)
+                                                    // Should not divide the mains period (20ms or 16.6ms), otherwise
+                                                    // samples are always taken at the same phase and RMS is biased
+#endif
+
+#ifndef EMON_BACKGROUND_SAMPLES
+#define EMON_BACKGROUND_SAMPLES         16          // Samples captured per sampling timer callback
+#endif
+
+#ifndef EMON_BACKGROUND_BUFFER_SIZE
+#define EMON_BACKGROUND_BUFFER_SIZE     128         // Size of each half of the samples buffer
+#endif
+
 #ifndef EMON_REFERENCE_VOLTAGE
 #define EMON_REFERENCE_VOLTAGE          3.3         // Reference voltage of the ADC
 #endif
@@ -1016,8 +1051,12 @@
 #endif
 
 #ifndef PZEM004T_READ_INTERVAL
-#define PZEM004T_READ_INTERVAL          1000    // (ms) Minimum interval between device readings. When there are more than one device, interval will be shared
-                                                // between devices and each reading will happen after 'interval value' multiplied by the number of devices
+#define PZEM004T_READ_INTERVAL          1000    // (ms) Minimum interval between device readings. Requests to multiple devices are sent
+                                                // back-to-back, so every device is read once per interval
+#endif
+
+#ifndef PZEM004T_READ_TIMEOUT
+#define PZEM004T_READ_TIMEOUT           1000    // (ms) Time to wait for the device reply
 #endif
 
 #ifndef PZEM004T_DEVICES_MAX
@@ -1054,6 +1093,12 @@
 #define PZEM004TV30_ADDRESS                0xF8    // Default: factory value
 #endif
 
+#ifndef PZEM004TV30_DEVICES_MAX
+#define PZEM004TV30_DEVICES_MAX            8      // Maximum number of devices on the same port
+                                                  // First device address is `pzemv30Addr`, others are `pzemv30Addr1`, `pzemv30Addr2`, etc.
+                                                  // (every device needs an unique address, see `PZ.ADDRESS`)
+#endif
+
 #ifndef PZEM004TV30_PORT
 #define PZEM004TV30_PORT                   1      // By default, use the first port
                                                   // (needs `UART[1-3]_BAUDRATE 9600`)
@@ -1456,6 +1501,20 @@
 #define I2C_PERFORM_SCAN                1       // Perform a bus scan on boot
 #endif
 
+#ifndef I2C_QUEUE_SIZE
+#define I2C_QUEUE_SIZE                  16      // Maximum number of pending queued transactions
+#endif
+
+#ifndef I2C_QUEUE_LOOP_BUDGET
+#define I2C_QUEUE_LOOP_BUDGET           2000UL  // Time (in microseconds) the queue is allowed to use in a single loop() call
+                                                // Transactions for the same device are always processed together, regardless of the budget
+#endif
+
+#ifndef I2C_QUEUE_MERGE_SIZE
+#define I2C_QUEUE_MERGE_SIZE            32      // Sequential reads of adjacent registers of the same device are merged up to this many bytes
+                                                // Should not exceed Wire buffer length
+#endif
+
 // -----------------------------------------------------------------------------
 // OneWire
 // -----------------------------------------------------------------------------
@@ -399,7 +399,9 @@ void send(unsigned char index, const espurna::sensor::Value& value) {
     // https://github.com/domoticz/domoticz/blob/6027b1d9e3b6588a901de42d82f3a6baf1374cd1/hardware/I2C.cpp#L1092-L1193
     // For now, just send invalid value. Consider simplifying sampling function and adding it here, with custom sampling time (3 hours, 6 hours, 12 hours etc.)
     if (MAGNITUDE_PRESSURE == value.type) {
-        mqtt::send(idx, 0, (value.repr + F(";-1")).c_str());
+        auto svalue = value.repr;
+        svalue += STRING_VIEW(";-1");
+        mqtt::send(idx, 0, svalue.c_str());
     // Special case to allow us to use it with switches directly
     } else if (MAGNITUDE_DIGITAL == value.type) {
         mqtt::send(idx, (*value.repr.c_str() == '1') ? 1 : 0, value.repr.c_str());
@@ -436,6 +438,9 @@ namespace {
 
 STRING_VIEW_INLINE(Prefix, "dcz");
 
+// settings panel has a different name
+STRING_VIEW_INLINE(Panel, "domoticz");
+
 bool onKeyCheck(espurna::StringView key, const JsonVariant&) {
     return key.startsWith(Prefix);
 }
@@ -481,7 +486,7 @@ void onConnected(JsonObject& root) {
 void setup() {
     wsRegister()
         .onVisible(onVisible)
-        .onConnected(onConnected)
+        .onConnected(Panel, onConnected)
         .onKeyCheck(onKeyCheck);
 }
 
@@ -81,6 +81,7 @@ static struct {
 static uint32_t pwm_period = 0;
 static uint32_t pwm_period_ticks = 0;
 static uint32_t pwm_duty[PWM_MAX_CHANNELS] = {0};
+static uint8_t pwm_dirty = 0;
 static uint16_t gpio_mask[PWM_MAX_CHANNELS] = {0};
 static uint8_t pwm_channels = {0};
 
@@ -361,6 +362,7 @@ void ICACHE_FLASH_ATTR
 pwm_start(void)
 {
 	pwm_phase_array* pwm = &pwm_phases[0];
+	pwm_dirty = 0;
 
 	if ((*pwm == pwm_state.next_set) ||
 	    (*pwm == pwm_state.current_set))
@@ -408,6 +410,21 @@ pwm_start(void)
 	pwm_state.next_set = *pwm;
 }
 
+/* Duty and period values are only staged by pwm_set_duty and pwm_set_period,
+ * the phase set is computed here once for all of them and is picked up by the
+ * interrupt routine at the start of the next period. Nothing is computed
+ * when none of the values were changed since the last pwm_start
+ */
+bool ICACHE_FLASH_ATTR
+pwm_commit(void)
+{
+	if (!pwm_dirty)
+		return false;
+
+	pwm_start();
+	return true;
+}
+
 void ICACHE_FLASH_ATTR
 pwm_set_duty(uint32_t duty, uint8_t channel)
 {
@@ -417,7 +434,10 @@ pwm_set_duty(uint32_t duty, uint8_t channel)
 	if (duty > PWM_MAX_DUTY)
 		duty = PWM_MAX_DUTY;
 
-	pwm_duty[channel] = duty;
+	if (pwm_duty[channel] != duty) {
+		pwm_duty[channel] = duty;
+		pwm_dirty = 1;
+	}
 }
 
 uint32_t ICACHE_FLASH_ATTR
@@ -437,6 +457,7 @@ pwm_set_period(uint32_t period)
 		pwm_period = PWM_MAX_PERIOD;
 
 	pwm_period_ticks = PWM_PERIOD_TO_TICKS(period);
+	pwm_dirty = 1;
 }
 
 uint32_t ICACHE_FLASH_ATTR
@@ -68,4 +68,13 @@ void espurnaRegisterOnceUnique(espurna::Callback::Type);
 espurna::duration::Milliseconds espurnaLoopDelay();
 void espurnaLoopDelay(espurna::duration::Milliseconds);
 
+// Time spent running the loop callbacks since boot
+struct LoopStats {
+    uint32_t iterations { 0 };
+    espurna::duration::Microseconds total { 0 };
+    espurna::duration::Microseconds max { 0 };
+};
+
+LoopStats espurnaLoopStats();
+
 void extraSetup();
@@ -1511,7 +1511,7 @@ void setup() {
     wsRegister()
         .onAction(web::onAction)
         .onVisible(web::onVisible)
-        .onConnected(web::onConnected)
+        .onConnected(settings::query::Prefix, web::onConnected)
         .onKeyCheck(web::onKeyCheck);
 #endif
 
@@ -20,6 +20,8 @@ Copyright (C) 2017-2019 by Xose Pérez <xose dot perez at gmail dot com>
 
 #include <cstring>
 #include <bitset>
+#include <iterator>
+#include <vector>
 
 // -----------------------------------------------------------------------------
 // Private
@@ -86,6 +88,18 @@ constexpr bool performScanOnBoot() {
     return I2C_PERFORM_SCAN == 1;
 }
 
+constexpr size_t queueSize() {
+    return I2C_QUEUE_SIZE;
+}
+
+constexpr duration::Microseconds queueBudget() {
+    return duration::Microseconds(I2C_QUEUE_LOOP_BUDGET);
+}
+
+constexpr size_t queueMergeSize() {
+    return I2C_QUEUE_MERGE_SIZE;
+}
+
 #if I2C_USE_BRZO
 constexpr unsigned long cst() {
     return I2C_CLOCK_STRETCH_TIME;
@@ -288,6 +302,233 @@ int clear(const Bus& bus) {
     return clear(bus.sda, bus.scl);
 }
 
+// Single bus transaction, both command and data are sent in one go
+uint8_t transfer(uint8_t address,
+        const uint8_t* command, size_t command_size,
+        const uint8_t* write, size_t write_size,
+        uint8_t* read, size_t read_size)
+{
+#if I2C_USE_BRZO
+    i2c::brzo_i2c_start_transaction(address);
+    if (command_size) {
+        brzo_i2c_write(const_cast<uint8_t*>(command), command_size, (write_size > 0) || (read_size > 0));
+    }
+
+    if (write_size) {
+        brzo_i2c_write(const_cast<uint8_t*>(write), write_size, read_size > 0);
+    }
+
+    if (read_size) {
+        brzo_i2c_read(read, read_size, false);
+    }
+
+    return brzo_i2c_end_transaction();
+#else
+    uint8_t status { 0 };
+    if (command_size || write_size) {
+        Wire.beginTransmission(address);
+        Wire.write(command, command_size);
+        Wire.write(write, write_size);
+        status = Wire.endTransmission();
+    }
+
+    if (!status && read_size) {
+        // aka 'other error', device did not send everything we asked for
+        if (read_size != Wire.requestFrom(address, read_size)) {
+            return 4;
+        }
+
+        for (size_t index = 0; index < read_size; ++index) {
+            read[index] = Wire.read();
+        }
+    }
+
+    return status;
+#endif
+}
+
+// Transactions are submitted by the sensors (or anything else) and are processed in the order they came in.
+// Sequential reads of adjacent registers of the same device are merged into a single bus transaction.
+namespace queue {
+
+struct Stats {
+    size_t max_depth;
+    uint32_t submitted;
+    uint32_t dropped;
+    uint32_t completed;
+    uint32_t merged;
+    uint32_t transfers;
+    uint32_t errors;
+    duration::Microseconds busy;
+};
+
+namespace internal {
+
+// Callbacks are allowed to submit new transactions, which are always placed in the 'pending'
+// list. Only the 'active' one is processed. Both are pre-allocated, and swapped on every loop
+std::vector<I2CTransaction> pending;
+std::vector<I2CTransaction> active;
+
+Stats stats{};
+time::SystemClock::time_point since;
+
+} // namespace internal
+
+bool submit(I2CTransaction&& transaction) {
+    if (internal::pending.size() >= build::queueSize()) {
+        ++internal::stats.dropped;
+        return false;
+    }
+
+    internal::pending.push_back(std::move(transaction));
+    internal::stats.max_depth = std::max(
+        internal::stats.max_depth, internal::pending.size());
+    ++internal::stats.submitted;
+
+    return true;
+}
+
+size_t pending() {
+    return internal::pending.size() + internal::active.size();
+}
+
+const Stats& stats() {
+    return internal::stats;
+}
+
+duration::Microseconds uptime() {
+    return time::micros() - internal::since;
+}
+
+bool sequential_read(const I2CTransaction& transaction) {
+    return transaction.sequential
+        && (transaction.command_size == 1)
+        && (transaction.write_size == 0)
+        && (transaction.read_size > 0);
+}
+
+// Number of transactions that can be done as one, starting at the offset
+size_t mergeable(const std::vector<I2CTransaction>& transactions, size_t offset) {
+    const auto& first = transactions[offset];
+    if (!sequential_read(first)) {
+        return 1;
+    }
+
+    size_t out { 1 };
+    size_t size { first.read_size };
+
+    for (auto it = transactions.begin() + offset + 1; it != transactions.end(); ++it) {
+        if (((*it).address != first.address)
+            || !sequential_read(*it)
+            || ((*it).command[0] != (first.command[0] + size))
+            || ((size + (*it).read_size) > build::queueMergeSize()))
+        {
+            break;
+        }
+
+        size += (*it).read_size;
+        ++out;
+    }
+
+    return out;
+}
+
+size_t process(std::vector<I2CTransaction>& transactions, size_t offset) {
+    const auto start = time::micros();
+
+    const auto& first = transactions[offset];
+    const auto count = mergeable(transactions, offset);
+
+    uint8_t status;
+    if (count > 1) {
+        uint8_t buffer[build::queueMergeSize()];
+
+        size_t size { 0 };
+        for (size_t index = offset; index < offset + count; ++index) {
+            size += transactions[index].read_size;
+        }
+
+        status = transfer(first.address,
+            first.command, first.command_size,
+            nullptr, 0, buffer, size);
+
+        if (!status) {
+            const auto* ptr = &buffer[0];
+            for (size_t index = offset; index < offset + count; ++index) {
+                auto& transaction = transactions[index];
+                std::memcpy(transaction.read, ptr, transaction.read_size);
+                ptr += transaction.read_size;
+            }
+        }
+
+        internal::stats.merged += count - 1;
+    } else {
+        status = transfer(first.address,
+            first.command, first.command_size,
+            first.write, first.write_size,
+            first.read, first.read_size);
+    }
+
+    internal::stats.busy += time::micros() - start;
+    internal::stats.completed += count;
+    ++internal::stats.transfers;
+    if (status) {
+        ++internal::stats.errors;
+    }
+
+    for (size_t index = offset; index < offset + count; ++index) {
+        auto& transaction = transactions[index];
+        if (transaction.callback) {
+            transaction.callback(status);
+        }
+    }
+
+    return count;
+}
+
+// Every transaction for the same device is processed at once. Otherwise, stop when the time budget
+// runs out and leave the rest for the next loop. Unprocessed transactions keep their original order.
+void loop() {
+    if (internal::pending.empty()) {
+        return;
+    }
+
+    auto& active = internal::active;
+    std::swap(internal::pending, active);
+
+    const auto start = time::micros();
+
+    size_t offset { 0 };
+    while (offset < active.size()) {
+        if (offset
+            && (active[offset].address != active[offset - 1].address)
+            && (time::micros() - start) > build::queueBudget())
+        {
+            break;
+        }
+
+        offset += process(active, offset);
+    }
+
+    if (offset < active.size()) {
+        internal::pending.insert(internal::pending.begin(),
+            std::make_move_iterator(active.begin() + offset),
+            std::make_move_iterator(active.end()));
+    }
+
+    active.clear();
+}
+
+void setup() {
+    internal::pending.reserve(build::queueSize());
+    internal::active.reserve(build::queueSize());
+    internal::since = time::micros();
+
+    espurnaRegisterLoop(loop);
+}
+
+} // namespace queue
+
 int clear() {
     return clear(internal::bus);
 }
@@ -351,10 +592,36 @@ void clear(::terminal::CommandContext&& ctx) {
     terminalOK(ctx);
 }
 
+PROGMEM_STRING(Stats, "I2C.STATS");
+
+void stats(::terminal::CommandContext&& ctx) {
+    const auto& stats = queue::stats();
+
+    ctx.output.printf_P(PSTR("queue: pending %zu, max %zu, dropped %u\n"),
+        queue::pending(), stats.max_depth, stats.dropped);
+    ctx.output.printf_P(PSTR("transactions: submitted %u, completed %u, merged %u\n"),
+        stats.submitted, stats.completed, stats.merged);
+    ctx.output.printf_P(PSTR("bus: transfers %u, errors %u\n"),
+        stats.transfers, stats.errors);
+
+    // 1/100th of a percent, 64bit to avoid overflowing with long uptime
+    const auto uptime = queue::uptime().count();
+    const auto usage = uptime
+        ? static_cast<uint32_t>((stats.busy.count() * 10000) / uptime)
+        : 0;
+
+    ctx.output.printf_P(PSTR("busy: %u (ms), utilisation %u.%02u%%\n"),
+        static_cast<uint32_t>(stats.busy.count() / 1000),
+        usage / 100, usage % 100);
+
+    terminalOK(ctx);
+}
+
 static constexpr ::terminal::Command Commands[] PROGMEM {
     {Locked, locked},
     {Scan, scan},
     {Clear, clear},
+    {Stats, stats},
 };
 
 void setup() {
@@ -578,6 +845,56 @@ void i2cUnlock(uint8_t address) {
     espurna::i2c::lock::reset(address);
 }
 
+bool i2cSubmit(I2CTransaction&& transaction) {
+    return espurna::i2c::queue::submit(std::move(transaction));
+}
+
+bool i2cSubmitRead(uint8_t address, uint8_t reg, uint8_t* buffer, size_t size, I2CTransaction::Callback callback) {
+    return i2cSubmit(I2CTransaction{
+        .address = address,
+        .command = {reg},
+        .command_size = 1,
+        .write = nullptr,
+        .write_size = 0,
+        .read = buffer,
+        .read_size = size,
+        .sequential = false,
+        .callback = std::move(callback),
+    });
+}
+
+bool i2cSubmitRead(uint8_t address, uint8_t* buffer, size_t size, I2CTransaction::Callback callback) {
+    return i2cSubmit(I2CTransaction{
+        .address = address,
+        .command = {},
+        .command_size = 0,
+        .write = nullptr,
+        .write_size = 0,
+        .read = buffer,
+        .read_size = size,
+        .sequential = false,
+        .callback = std::move(callback),
+    });
+}
+
+bool i2cSubmitWrite(uint8_t address, const uint8_t* buffer, size_t size, I2CTransaction::Callback callback) {
+    return i2cSubmit(I2CTransaction{
+        .address = address,
+        .command = {},
+        .command_size = 0,
+        .write = buffer,
+        .write_size = size,
+        .read = nullptr,
+        .read_size = 0,
+        .sequential = false,
+        .callback = std::move(callback),
+    });
+}
+
+size_t i2cPending() {
+    return espurna::i2c::queue::pending();
+}
+
 uint8_t i2cFind(uint8_t address) {
     return espurna::i2c::find(address);
 }
@@ -592,6 +909,7 @@ uint8_t i2cFindAndLock(const uint8_t* begin, const uint8_t* end) {
 
 void i2cSetup() {
     espurna::i2c::init();
+    espurna::i2c::queue::setup();
 
 #if TERMINAL_SUPPORT
     espurna::i2c::terminal::setup();
@@ -10,6 +10,7 @@ Copyright (C) 2017-2019 by Xose Pérez <xose dot perez at gmail dot com>
 
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 
 void i2c_wakeup(uint8_t address);
 uint8_t i2c_write_buffer(uint8_t address, uint8_t * buffer, size_t len);
@@ -30,6 +31,45 @@ void i2c_read_buffer(uint8_t address, uint8_t* buffer, size_t len);
 uint32_t i2c_read_uint(uint8_t address, uint16_t reg, size_t len, bool stop);
 void i2c_write_uint(uint8_t address, uint16_t reg, uint32_t input, size_t len);
 
+// Queued transactions are executed from the main loop, instead of blocking the caller.
+// 'command' (usually, the register address) and 'write' data are sent first, 'read' buffer is filled afterwards.
+// Command is stored inline, both buffers must stay valid until the callback is called with the resulting
+// status code (same as the synchronous functions above, 0 means success)
+// Only when the device auto-increments register address, 'sequential' reads of adjacent registers
+// may be merged into a single bus transfer.
+struct I2CTransaction {
+    using Callback = std::function<void(uint8_t status)>;
+
+    uint8_t address;
+
+    uint8_t command[4];
+    size_t command_size;
+
+    const uint8_t* write;
+    size_t write_size;
+
+    uint8_t* read;
+    size_t read_size;
+
+    bool sequential;
+
+    Callback callback;
+};
+
+// Returns false when the queue is full, callback is not called in that case
+bool i2cSubmit(I2CTransaction&&);
+
+// Read 'size' bytes starting at the register 'reg'
+bool i2cSubmitRead(uint8_t address, uint8_t reg, uint8_t* buffer, size_t size, I2CTransaction::Callback);
+
+// Read 'size' bytes, without sending anything to the device first
+bool i2cSubmitRead(uint8_t address, uint8_t* buffer, size_t size, I2CTransaction::Callback);
+
+// Write the buffer as-is
+bool i2cSubmitWrite(uint8_t address, const uint8_t* buffer, size_t size, I2CTransaction::Callback);
+
+size_t i2cPending();
+
 uint8_t i2cFind(uint8_t);
 
 bool i2cLock(uint8_t address);
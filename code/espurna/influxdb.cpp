@@ -312,7 +312,7 @@ void idbSetup() {
     #if WEB_SUPPORT
         wsRegister()
             .onVisible(_idbWebSocketOnVisible)
-            .onConnected(_idbWebSocketOnConnected)
+            .onConnected(IdbPrefix, _idbWebSocketOnConnected)
             .onKeyCheck(_idbWebSocketOnKeyCheck);
     #endif
 
@@ -1084,7 +1084,7 @@ void setup() {
 #if WEB_SUPPORT
         ::wsRegister()
             .onVisible(web::onVisible)
-            .onConnected(web::onConnected)
+            .onConnected(settings::Prefix, web::onConnected)
             .onKeyCheck(web::onKeyCheck);
 #endif
 #if RELAY_SUPPORT
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -34,6 +35,9 @@ struct pwm_pin_info {
 void pwm_init(uint32_t period, uint32_t *duty, uint32_t pwm_channel_num, struct pwm_pin_info *pin_info_list);
 void pwm_start(void);
 
+/* same as pwm_start, but only when duty or period were changed */
+bool pwm_commit(void);
+
 void pwm_set_duty(uint32_t duty, uint8_t channel);
 uint32_t pwm_get_duty(uint8_t channel);
 void pwm_set_period(uint32_t period);
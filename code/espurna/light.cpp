@@ -22,9 +22,11 @@ Copyright (C) 2019-2021 by Maxim Prokhorov <prokhorov dot max at outlook dot com
 
 #include <array>
 #include <cstring>
+#include <limits>
 #include <vector>
 
 #include "libs/fs_math.h"
+#include "light_common.ipp"
 
 #if LIGHT_PROVIDER == LIGHT_PROVIDER_MY92XX
 #include <my92xx.h>
@@ -97,6 +99,14 @@ constexpr espurna::duration::Milliseconds transitionStep() {
     return espurna::duration::Milliseconds(LIGHT_TRANSITION_STEP);
 }
 
+constexpr Curve transitionCurve() {
+    return static_cast<Curve>(LIGHT_TRANSITION_CURVE);
+}
+
+constexpr espurna::duration::Milliseconds channelTransitionTime() {
+    return espurna::duration::Milliseconds(0);
+}
+
 constexpr bool save() {
     return 1 == LIGHT_SAVE_ENABLED;
 }
@@ -197,6 +207,44 @@ constexpr unsigned char my92xxChannel(size_t channel) {
 #endif
 
 } // namespace build
+} // namespace
+} // namespace light
+
+// Curve is also written to settings, serialize() should be visible before the setSetting() calls below
+namespace settings {
+namespace internal {
+namespace {
+
+PROGMEM_STRING(CurveLinear, "linear");
+PROGMEM_STRING(CurveEaseIn, "ease-in");
+PROGMEM_STRING(CurveEaseOut, "ease-out");
+PROGMEM_STRING(CurveEaseInOut, "ease-in-out");
+PROGMEM_STRING(CurvePerceptual, "perceptual");
+
+static constexpr std::array<options::Enumeration<light::Curve>, 5> CurveOptions PROGMEM {
+    {{light::Curve::Linear, CurveLinear},
+     {light::Curve::EaseIn, CurveEaseIn},
+     {light::Curve::EaseOut, CurveEaseOut},
+     {light::Curve::EaseInOut, CurveEaseInOut},
+     {light::Curve::Perceptual, CurvePerceptual}}
+};
+
+} // namespace
+
+template <>
+light::Curve convert(const String& value) {
+    return convert(CurveOptions, value, light::build::transitionCurve());
+}
+
+String serialize(light::Curve value) {
+    return serialize(CurveOptions, value);
+}
+
+} // namespace internal
+} // namespace settings
+
+namespace light {
+namespace {
 
 namespace settings {
 
@@ -339,6 +387,26 @@ void transitionStep(espurna::duration::Milliseconds value) {
     setSetting("ltStep", value.count());
 }
 
+Curve transitionCurve() {
+    return getSetting("ltCurve", build::transitionCurve());
+}
+
+void transitionCurve(Curve value) {
+    setSetting("ltCurve", value);
+}
+
+espurna::duration::Milliseconds channelTransitionTime(size_t index) {
+    return getSetting({"ltChTime", index}, build::channelTransitionTime());
+}
+
+void channelTransitionTime(size_t index, espurna::duration::Milliseconds value) {
+    if (value.count()) {
+        setSetting({"ltChTime", index}, value.count());
+    } else {
+        delSetting({"ltChTime", index});
+    }
+}
+
 bool save() {
     return getSetting("ltSave", build::save());
 }
@@ -370,226 +438,25 @@ public:
 
 #endif
 
-namespace {
-
-template <typename T>
-long _lightChainedValue(long input, const T& process) {
-    return process(input);
-}
-
-template <typename T, typename... Args>
-long _lightChainedValue(long input, const T& process, Args&&... args) {
-    return _lightChainedValue(process(input), std::forward<Args>(args)...);
-}
-
-} // namespace
-
-struct LightChannel {
-    LightChannel() = default;
-
-    LightChannel(bool inverse, bool gamma) :
-        inverse(inverse),
-        gamma(gamma)
-    {}
-
-    LightChannel& operator=(long input) {
-        inputValue = std::clamp(input, espurna::light::ValueMin, espurna::light::ValueMax);
-        return *this;
-    }
-
-    void apply() {
-        value = inputValue;
-    }
-
-    template <typename T>
-    void apply(const T& process) {
-        value = std::clamp(process(inputValue), espurna::light::ValueMin, espurna::light::ValueMax);
-    }
-
-    template <typename T, typename... Args>
-    void apply(const T& process, Args&&... args) {
-        value = std::clamp(
-            _lightChainedValue(process(inputValue), std::forward<Args>(args)...),
-            espurna::light::ValueMin, espurna::light::ValueMax);
-    }
-
-    bool inverse { false };                // re-map the value from [ValueMin:ValueMax] to [ValueMax:ValueMin]
-    bool gamma { false };                  // apply gamma correction to the target value
-
-    // TODO: remove in favour of global control, since relays are no longer bound to a single channel?
-    bool state { true };                   // is the channel ON
+// Channel values are converted into the provider output through the pre-generated table
+// (see _lightOutputTable()), which is sized for every possible input value
+#if LIGHT_PROVIDER == LIGHT_PROVIDER_DIMMER
+using LightOutputValue = uint32_t;
+#elif LIGHT_PROVIDER == LIGHT_PROVIDER_MY92XX
+using LightOutputValue = uint16_t;
+#elif LIGHT_PROVIDER == LIGHT_PROVIDER_CUSTOM
+using LightOutputValue = float;
+#endif
 
-    long inputValue { espurna::light::ValueMin };   // raw, without the brightness
-    long value { espurna::light::ValueMin };        // normalized, including brightness
-    long target { espurna::light::ValueMin };       // resulting value that will be given to the provider
+using LightOutputTable = espurna::light::output::Table<
+    LightOutputValue, espurna::light::ValueMin, espurna::light::ValueMax>;
 
-    float current { espurna::light::ValueMin };     // interim between input and target, used by the transition handler
-};
+using LightChannel = espurna::light::Channel<LightOutputTable>;
 
 using LightChannels = std::vector<LightChannel>;
 LightChannels _light_channels;
 
 namespace espurna {
-namespace light {
-namespace {
-
-struct Pointers {
-    using Type = LightChannels::pointer;
-    using Data = std::array<Type, 5>;
-
-    Pointers() = default;
-    explicit Pointers(LightChannels&);
-
-    Pointers(const Pointers&) = default;
-    Pointers& operator=(const Pointers&) = default;
-
-    Pointers(Pointers&&) = default;
-    Pointers& operator=(Pointers&&) = default;
-
-    Pointers& operator=(LightChannels& channels) {
-        _data.fill(nullptr);
-        reset(channels);
-        return *this;
-    }
-
-    LightChannel* red() const {
-        return _data[0];
-    }
-
-    LightChannel* green() const {
-        return _data[1];
-    }
-
-    LightChannel* blue() const {
-        return _data[2];
-    }
-
-    LightChannel* warm() const {
-        return _data[3];
-    }
-
-    LightChannel* cold() const {
-        return _data[4];
-    }
-
-private:
-    void reset(LightChannels& channels);
-
-    Data _data{};
-};
-
-void Pointers::reset(LightChannels& channels) {
-    switch (channels.size()) {
-    case 0:
-        break;
-    case 1:
-        _data[3] = &channels[0];
-        break;
-    case 2:
-        _data[3] = &channels[0];
-        _data[4] = &channels[1];
-        break;
-    case 3:
-        _data[0] = &channels[0];
-        _data[1] = &channels[1];
-        _data[2] = &channels[2];
-        break;
-    case 4:
-        _data[0] = &channels[0];
-        _data[1] = &channels[1];
-        _data[2] = &channels[2];
-        _data[3] = &channels[3];
-        break;
-    case 5:
-        _data[0] = &channels[0];
-        _data[1] = &channels[1];
-        _data[2] = &channels[2];
-        _data[3] = &channels[3];
-        _data[4] = &channels[4];
-        break;
-    }
-}
-
-Pointers::Pointers(LightChannels& channels) {
-    reset(channels);
-}
-
-struct Mapping {
-    void reset() {
-        _pointers = Pointers();
-    }
-
-    template <typename T>
-    Mapping operator=(T&& other) {
-        _pointers = std::forward<T>(other);
-        return *this;
-    }
-
-    long red() const {
-        return get(_pointers.red());
-    }
-
-    void red(long value) {
-        set(_pointers.red(), value);
-    }
-
-    long green() const {
-        return get(_pointers.green());
-    }
-
-    void green(long value) {
-        set(_pointers.green(), value);
-    }
-
-    long blue() const {
-        return get(_pointers.blue());
-    }
-
-    void blue(long value) {
-        set(_pointers.blue(), value);
-    }
-
-    long cold() const {
-        return get(_pointers.cold());
-    }
-
-    void cold(long value) {
-        set(_pointers.cold(), value);
-    }
-
-    long warm() const {
-        return get(_pointers.warm());
-    }
-
-    void warm(long value) {
-        set(_pointers.warm(), value);
-    }
-
-    const Pointers& pointers() const {
-        return _pointers;
-    }
-
-private:
-    static long get(LightChannel* ptr) {
-        if (ptr) {
-            return ptr->target;
-        }
-
-        return espurna::light::ValueMin;
-    }
-
-    static void set(LightChannel* ptr, long value) {
-        if (ptr) {
-            *ptr = value;
-        }
-    }
-
-    Pointers _pointers;
-};
-
-} // namespace
-} // namespace light
-
 namespace settings {
 namespace internal {
 
@@ -621,7 +488,7 @@ my92xx_model_t convert(const String& value) {
 
 namespace {
 
-espurna::light::Mapping _light_mapping;
+espurna::light::Mapping<LightChannel> _light_mapping;
 
 void _lightUpdateMapping(LightChannels& channels) {
     _light_mapping = channels;
@@ -686,52 +553,8 @@ bool _light_use_gamma = false;
 
 bool _light_state = false;
 
-struct LightBrightness {
-    LightBrightness() = default;
-    explicit LightBrightness(long value) :
-        _value(clamp(value))
-    {}
-
-    LightBrightness& operator=(long value) {
-        this->value(value);
-        return *this;
-    }
-
-    long value() const {
-        return _value;
-    }
-
-    void value(long value) {
-        _value = clamp(value);
-    }
-
-    long percent() const {
-        return (_value * 100l) / espurna::light::BrightnessMax;
-    }
-
-    void percent(long value) {
-        const auto Fixed = std::clamp(value, 0l, 100l);
-        const auto Ratio = espurna::light::BrightnessMax * Fixed;
-        this->value(Ratio / 100l);
-    }
-
-    long operator()(long input) const {
-        return (input * _value) / espurna::light::BrightnessMax;
-    }
-
-    String toString() const {
-        return String(_value, 10);
-    }
-
-private:
-    long clamp(long value) {
-        return std::clamp(value,
-            espurna::light::BrightnessMin,
-            espurna::light::BrightnessMax);
-    }
-
-    long _value { espurna::light::BrightnessMax };
-};
+using LightBrightness = espurna::light::process::Brightness<
+    espurna::light::BrightnessMin, espurna::light::BrightnessMax>;
 
 LightBrightness _light_brightness;
 
@@ -765,10 +588,7 @@ struct LightTemperature {
     }
 
     float factor() const {
-        const auto Mireds = static_cast<float>(_value);
-        const auto Cold = static_cast<float>(_cold);
-        const auto Warm = static_cast<float>(_warm);
-        return (Mireds - Cold) / (Warm - Cold);
+        return espurna::light::color::factor(_value, _cold, _warm);
     }
 
     espurna::light::TemperatureRange range() const {
@@ -849,287 +669,29 @@ long _lightBrightnessPercent() {
 }
 
 // After the channel value was updated through the API (i.e. through changing the `inputValue`),
-// these functions are expected to be called. Which one is chosen is based on the current settings values.
-
-// Basic brightness application; default when all other processing options are disabled
+// these functions are expected to be called. See light_common.ipp for the details of each one.
 
 void _lightValuesWithBrightness(LightChannels& channels) {
-    const auto Brightness = _light_brightness;
-    for (auto& channel : channels) {
-        channel.apply(Brightness);
-    }
+    espurna::light::values::brightness(channels, _light_brightness);
 }
 
-// Maintain compatibility with older versions, limit brightness application to the RGB when using 'color mode'.
-
 void _lightValuesWithBrightnessExceptWhite(LightChannels& channels) {
-    auto ptr = espurna::light::Pointers(channels);
-    const auto Brightness = _light_brightness;
-
-    (*ptr.red()).apply(Brightness);
-    (*ptr.green()).apply(Brightness);
-    (*ptr.blue()).apply(Brightness);
-
-    if (ptr.warm()) {
-        (*ptr.warm()).apply();
-    }
-
-    if (ptr.cold()) {
-        (*ptr.cold()).apply();
-    }
+    espurna::light::values::brightness_except_white(channels, _light_brightness);
 }
 
-// Reset inputValue directly in the expression
-// Ignores all previous values, should only be used at the beginning
-
-struct LightResetInput {
-    LightResetInput() = delete;
-    explicit LightResetInput(long value) :
-        _value(value)
-    {}
-
-    long operator()(long) const {
-        return _value;
-    }
-
-    // 0.0 is the 'coldest', 1.0 is the 'warmest'
-    static LightResetInput forWarm(float factor) {
-        return LightResetInput(factor * espurna::light::ValueMax);
-    }
-
-    // opposite value of `forWarm` for the given factor
-    static LightResetInput forCold(float factor) {
-        return LightResetInput((1.0f - factor) * espurna::light::ValueMax);
-    }
-
-private:
-    long _value;
-};
-
-// With `useCCT`, balance the value between Warm and Cold channels based on the current `mireds`.
-
-struct LightScaledWhite {
-    static auto constexpr Default = espurna::light::build::WhiteFactor;
-
-    LightScaledWhite() = default;
-    explicit LightScaledWhite(float factor) :
-        _factor(factor)
-    {}
-
-    static LightScaledWhite with(float factor) {
-        return LightScaledWhite{factor * Default};
-    }
-
-    long operator()(long input) const {
-        return std::lround(static_cast<float>(input) * _factor);
-    }
-
-private:
-    float _factor { Default };
-};
-
 void _lightValuesWithCct(LightChannels& channels) {
-    const auto Brightness = _light_brightness;
-    const auto CctFactor = _light_temperature.factor();
-    const auto White = LightScaledWhite();
-
-    auto ptr = espurna::light::Pointers(channels);
-    (*ptr.warm()).apply(
-        LightResetInput::forWarm(CctFactor), White, Brightness);
-    (*ptr.cold()).apply(
-        LightResetInput::forCold(CctFactor), White, Brightness);
-
-    if (ptr.red() && ptr.green() && ptr.blue()) {
-        (*ptr.red()).apply(
-            LightResetInput{espurna::light::ValueMin});
-        (*ptr.green()).apply(
-            LightResetInput{espurna::light::ValueMin});
-        (*ptr.blue()).apply(
-            LightResetInput{espurna::light::ValueMin});
-    }
+    espurna::light::values::cct(channels, _light_brightness,
+        _light_temperature.factor(), espurna::light::build::WhiteFactor);
 }
 
-// To handle both 4 and 5 channels, allow to 'adjust' internal factor calculation after construction
-// When processing the channel values, this is the expected sequence:
-// [250,150,0] -> [200,100,0,50] -> [250,125,0,63], factor is 1.25
-//
-// XXX: before 1.15.0:
-// - factor for the example above is 1 b/c of integer division, meaning the sequence is instead:
-// [250,150,0] -> [200,100,0,50] -> [200,100,0,50]
-// - when modified, white channels(s) `inputValue` is always equal to the output `value`
-
-struct LightRgbWithoutWhite {
-    LightRgbWithoutWhite() = delete;
-    explicit LightRgbWithoutWhite(espurna::light::Rgb rgb) :
-        _common(makeCommon(rgb)),
-        _factor(makeFactor(_common)),
-        _luminance(makeLuminance(_common))
-    {}
-
-    explicit LightRgbWithoutWhite(const LightChannels& channels) :
-        LightRgbWithoutWhite{makeRgb(channels)}
-    {}
-
-    long operator()(long input) const {
-        return std::lround(static_cast<float>(input - _common.inputMin) * _factor);
-    }
-
-    template <typename... Args>
-    void adjustOutput(Args&&... args) {
-        _common.outputMax = std::max({
-            _common.outputMax,
-            std::forward<Args>(args)...
-        });
-        _factor = makeFactor(_common);
-        _luminance = makeLuminance(_common);
-    }
-
-    long inputMin() const {
-        return _common.inputMin;
-    }
-
-    float factor() const {
-        return _factor;
-    }
-
-    float luminance() const {
-        return _luminance;
-    }
-
-private:
-    struct Common {
-        long inputMin;
-        long inputMax;
-        long outputMax;
-    };
-
-    static float makeLuminance(Common common) {
-        const auto raw = (common.inputMin + common.inputMax) / 2;
-        return static_cast<float>(raw) / espurna::light::ValueMax;
-    }
-
-    static float makeFactor(Common common) {
-        const auto inputMax = static_cast<float>(common.inputMax);
-        const auto outputMax = static_cast<float>(common.outputMax);
-        return (outputMax > 0.0f)
-            ? (inputMax / outputMax)
-            : 0.0f;
-    }
-
-    static espurna::light::Rgb makeRgb(const LightChannels& channels) {
-        return {
-            channels[0].inputValue,
-            channels[1].inputValue,
-            channels[2].inputValue,
-        };
-    }
-
-    static Common makeCommon(espurna::light::Rgb rgb) {
-        Common out;
-        out.inputMax = std::max({rgb.red(), rgb.green(), rgb.blue()});
-        out.inputMin = std::min({rgb.red(), rgb.green(), rgb.blue()});
-        out.outputMax = std::max({
-            rgb.red() - out.inputMin,
-            rgb.green() - out.inputMin,
-            rgb.blue() - out.inputMin
-        });
-
-        return out;
-    }
-
-    Common _common;
-    float _factor;
-    float _luminance;
-};
-
-// When `useWhite` is enabled, warm white channel is 'detached' from the processing and its value depends on the input RGB.
-// Common calculation is to subtract 'white value' from the RGB based on the minimum channel value, e.g. [250, 150, 50] becomes [200, 100, 0, 50]
-//
-// General case when `useCCT` is disabled, but there are 4 channels.
-// Keeps 5th channel as-is, without applying the brightness scale or resetting the value to 0
-
 void _lightValuesWithRgbWhite(LightChannels& channels) {
-    auto rgb = LightRgbWithoutWhite{channels};
-    rgb.adjustOutput(rgb.inputMin());
-
-    const auto Brightness = _light_brightness;
-
-    auto ptr = espurna::light::Pointers(channels);
-    (*ptr.red()).apply(rgb, Brightness);
-    (*ptr.green()).apply(rgb, Brightness);
-    (*ptr.blue()).apply(rgb, Brightness);
-
-    (*ptr.warm()).apply(
-        LightResetInput{rgb.inputMin()},
-        LightScaledWhite::with(rgb.factor()),
-        Brightness);
-
-    if (ptr.cold()) {
-        (*ptr.cold()).apply();
-    }
-}
-
-// Kelvin to RGB approximation algorithm by Tanner Helland
-// * https://tannerhelland.com/2012/09/18/convert-temperature-rgb-algorithm-code.html
-// Original code for RGB lights from AiLight library by Sacha Telgenhof (@
-// * https://github.com/stelgenhof/AiLight/blob/develop/lib/AiLight/AiLight.cpp
-
-// Instead of the above, use `mireds` value as a range for warm and cold channels, based on the calculated rgb common values
-// Every value is also scaled by `brightness` after applying all of the previous steps
-// Notice that we completely ignore inputs and reset them to either kelvin'ized or hardcoded ValueMin or ValueMax
-
-// Heavily depends on the used temperature range; by default (153...500), we stay on the 'warm side'
-// of the scale and effectively never enable blue. Setting cold mireds to 100 will use the whole range.
-
-espurna::light::Rgb _lightKelvinRgb(espurna::light::Kelvin kelvin) {
-    kelvin.value /= 100;
-    const auto red = ((kelvin.value <= 66)
-        ? espurna::light::ValueMax
-        : std::lround(329.698727446 * fs_pow(static_cast<double>(kelvin.value - 60), -0.1332047592)));
-    const auto green = ((kelvin.value <= 66)
-        ? std::lround(99.4708025861 * fs_log(kelvin.value) - 161.1195681661)
-        : std::lround(288.1221695283 * fs_pow(static_cast<double>(kelvin.value), -0.0755148492)));
-    const auto blue = ((kelvin.value >= 66)
-        ? espurna::light::ValueMax
-        : ((kelvin.value <= 19)
-            ? espurna::light::ValueMin
-            : std::lround(138.5177312231 * fs_log(static_cast<double>(kelvin.value - 10)) - 305.0447927307)));
-
-    return {red, green, blue};
+    espurna::light::values::rgb_white(channels, _light_brightness,
+        espurna::light::build::WhiteFactor);
 }
 
 void _lightValuesWithRgbCct(LightChannels& channels) {
-    const auto Temperature = _light_temperature;
-
-    const auto Kelvin = Temperature.kelvin();
-    const auto RgbFromKelvin = _lightKelvinRgb(Kelvin);
-
-    auto rgb = LightRgbWithoutWhite{RgbFromKelvin};
-    rgb.adjustOutput(rgb.inputMin());
-
-    const auto Brightness = _light_brightness;
-    auto ptr = espurna::light::Pointers(channels);
-
-    (*ptr.red()).apply(
-        LightResetInput{RgbFromKelvin.red()},
-        rgb, Brightness);
-    (*ptr.green()).apply(
-        LightResetInput{RgbFromKelvin.green()},
-        rgb, Brightness);
-    (*ptr.blue()).apply(
-        LightResetInput{RgbFromKelvin.blue()},
-        rgb, Brightness);
-
-    const auto White = LightScaledWhite(rgb.factor());
-    if (ptr.warm() || ptr.cold()) {
-        if (ptr.warm()) {
-            (*ptr.warm()).apply(White, Brightness);
-        }
-
-        if (ptr.cold()) {
-            (*ptr.cold()).apply(White, Brightness);
-        }
-    }
+    espurna::light::values::rgb_cct(channels, _light_brightness,
+        _light_temperature.kelvin().value);
 }
 
 // UI hints about channel distribution
@@ -1186,45 +748,9 @@ const char* _lightDesc(size_t channels, size_t index) {
 
 namespace {
 
-void _lightFromHexPayload(espurna::StringView payload) {
-    const bool JustRgb { (payload.length() == 6) };
-    const bool WithBrightness { (payload.length() == 8) };
-    if (!JustRgb && !WithBrightness) {
-        return;
-    }
-
-    uint8_t values[4] {0, 0, 0, 0};
-    if (hexDecode(payload.begin(), payload.length(), values, sizeof(values))) {
-        _light_mapping.red(values[0]);
-        _light_mapping.green(values[1]);
-        _light_mapping.blue(values[2]);
-        if (WithBrightness) {
-            lightBrightness(values[3]);
-        }
-    }
-}
-
 void _lightFromCommaSeparatedPayload(espurna::StringView payload, decltype(_light_channels.end()) end) {
-    auto it = _light_channels.begin();
-    if (it == end) {
-        return;
-    }
-
-    // every channel value is separated by a comma
-    auto split = espurna::SplitStringView(payload, ',');
-    while (split.next()) {
-        if (it == end) {
-            break;
-        }
-
-        const auto result = parseUnsigned(split.current(), 10);
-        if (!result.ok) {
-            break;
-        }
-
-        (*it) = result.value;
-        ++it;
-    }
+    auto it = espurna::light::payload::decimals(
+        payload, _light_channels.begin(), end);
 
     // fill the rest with zeroes
     while (it != end) {
@@ -1242,52 +768,14 @@ void _lightFromRgbPayload(espurna::StringView payload) {
         return;
     }
 
-    if (!payload.length() || (payload[0] == '\0')) {
-        return;
-    }
-
-    // HEX value is always prefixed, like CSS
-    // - #AABBCC
-    // Extra byte is interpreted like RGB + brightness
-    // - #AABBCCDD
-    if (payload[0] == '#') {
-        _lightFromHexPayload(
-            espurna::StringView(payload.begin() + 1, payload.end()));
-        return;
-    }
-
-    // Otherwise, assume comma-separated decimal values
-    _lightFromCommaSeparatedPayload(payload, _light_channels.begin() + 3);
+    espurna::light::payload::rgb(payload, _light_mapping, _light_brightness);
 }
 
 espurna::light::Hsv _lightHsvFromPayload(espurna::StringView payload) {
     espurna::light::Hsv::Array values;
-    auto it = std::begin(values);
-
-    // HSV string is expected to be "H,S,V", where:
-    // - H [0...360]
-    // - S [0...100]
-    // - V [0...100]
-    const auto end = std::end(values);
-
-    auto split = espurna::SplitStringView(payload, ',');
-    while (split.next()) {
-        if (it == end) {
-            break;
-        }
-
-        const auto result = parseUnsigned(split.current(), 10);
-        if (!result.ok) {
-            break;
-        }
-
-        (*it) = result.value;
-        ++it;
-    }
 
-    // discard partial or uneven payloads
     espurna::light::Hsv out;
-    if (split.remaining().length() || (it != end)) {
+    if (!espurna::light::payload::hsv(payload, values)) {
         return out;
     }
 
@@ -1380,68 +868,11 @@ String _lightRgbPayload() {
     return _lightRgbPayload(_lightToInputRgb());
 }
 
-// HSV to RGB transformation
-//
-// INPUT: [0,100,57]
-// IS: [145,0,0]
-// SHOULD: [255,0,0]
-
 espurna::light::Rgb _lightRgb(espurna::light::Hsv hsv) {
-    constexpr auto ValueMin = static_cast<double>(espurna::light::ValueMin);
-    double r { ValueMin };
-    double g { ValueMin };
-    double b { ValueMin };
-
-    static constexpr auto Scale = 100.0;
-    auto v = static_cast<double>(hsv.value()) / Scale;
-
-    if (hsv.saturation()) {
-        auto h = hsv.hue();
-        if (h < 0) {
-            h = 0;
-        } else if (h >= 360) {
-            h = 359;
-        }
-
-        auto s = static_cast<double>(hsv.saturation()) / Scale;
-
-        auto c = v * s;
-
-        auto hmod2 = fs_fmod(static_cast<double>(h) / 60.0, 2.0);
-        auto x = c * (1.0 - std::abs(hmod2 - 1.0));
-
-        auto m = v - c;
-
-        if ((0 <= h) && (h < 60)) {
-            r = c;
-            g = x;
-        } else if ((60 <= h) && (h < 120)) {
-            r = x;
-            g = c;
-        } else if ((120 <= h) && (h < 180)) {
-            g = c;
-            b = x;
-        } else if ((180 <= h) && (h < 240)) {
-            g = x;
-            b = c;
-        } else if ((240 <= h) && (h < 300)) {
-            r = x;
-            b = c;
-        } else if ((300 <= h) && (h < 360)) {
-            r = c;
-            b = x;
-        }
-
-        constexpr auto ValueMax = static_cast<double>(espurna::light::ValueMax);
-        r = (r + m) * ValueMax;
-        g = (g + m) * ValueMax;
-        b = (b + m) * ValueMax;
-    }
-
-    return {
-        static_cast<long>(std::nearbyint(r)),
-        static_cast<long>(std::nearbyint(g)),
-        static_cast<long>(std::nearbyint(b))};
+    const auto values = espurna::light::color::rgb<
+        espurna::light::ValueMin, espurna::light::ValueMax>(
+            hsv.hue(), hsv.saturation(), hsv.value());
+    return {values[0], values[1], values[2]};
 }
 
 espurna::light::Hsv _lightHsv(espurna::light::Rgb rgb) {
@@ -1566,229 +997,43 @@ void _lightAdjustMireds(espurna::StringView payload) {
 
 namespace {
 
-// Gamma Correction lookup table (8 bit, ~2.2)
-// TODO: input value modifier, instead of a transition-only thing?
-// TODO: calculate on the fly instead of limiting this to an 8bit value?
-
-static constexpr long LightGammaMin { 0 };
-static constexpr long LightGammaMax { 255 };
-
-long _lightGammaValue(size_t index) {
-    static const std::array<uint8_t, 256> Gamma PROGMEM {
-        0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
-        1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,
-        3,   3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,
-        6,   7,   7,   7,   7,   8,   8,   8,   9,   9,   9,   10,  10,  11,  11,  11,
-        12,  12,  13,  13,  14,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,
-        19,  20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,
-        29,  30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,
-        41,  42,  43,  43,  44,  45,  46,  47,  48,  49,  50,  50,  51,  52,  53,  54,
-        55,  56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  71,
-        72,  73,  74,  75,  76,  77,  78,  80,  81,  82,  83,  84,  86,  87,  88,  89,
-        91,  92,  93,  94,  96,  97,  98,  100, 101, 102, 104, 105, 106, 108, 109, 110,
-        112, 113, 115, 116, 118, 119, 121, 122, 123, 125, 126, 128, 130, 131, 133, 134,
-        136, 137, 139, 140, 142, 144, 145, 147, 149, 150, 152, 154, 155, 157, 159, 160,
-        162, 164, 166, 167, 169, 171, 173, 175, 176, 178, 180, 182, 184, 186, 187, 189,
-        191, 193, 195, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
-        223, 225, 227, 229, 231, 233, 235, 238, 240, 242, 244, 246, 248, 251, 253, 255
-    };
+using LightTransitionHandler = espurna::light::transition::Handler<
+    LightChannel, LightTransition, espurna::time::CoreClock>;
 
-    if (index < Gamma.size()) {
-        return pgm_read_byte(&Gamma[index]);
-    }
+// Curves are generated at compile time and are only ever read from flash
+const espurna::light::easing::Points& _lightTransitionPoints(espurna::light::Curve curve) {
+    using namespace espurna::light::easing;
 
-    return 0;
-}
+    static constexpr Points Linear PROGMEM = make(linear);
+    static constexpr Points EaseIn PROGMEM = make(in);
+    static constexpr Points EaseOut PROGMEM = make(out);
+    static constexpr Points EaseInOut PROGMEM = make(in_out);
+    static constexpr Points Perceptual PROGMEM = make(perceptual);
 
-long _lightGammaMap(long value) {
-    static_assert(espurna::light::ValueMin >= 0, "");
-    static_assert(espurna::light::ValueMax >= 0, "");
-
-    constexpr auto Divisor = (espurna::light::ValueMax - espurna::light::ValueMin);
-    if (Divisor != 0l) {
-        const long Scaled {
-            (value - espurna::light::ValueMin) * (LightGammaMax - LightGammaMin) / Divisor + LightGammaMin };
-        return _lightGammaValue(static_cast<size_t>(Scaled));
+    switch (curve) {
+    case espurna::light::Curve::Linear:
+        break;
+    case espurna::light::Curve::EaseIn:
+        return EaseIn;
+    case espurna::light::Curve::EaseOut:
+        return EaseOut;
+    case espurna::light::Curve::EaseInOut:
+        return EaseInOut;
+    case espurna::light::Curve::Perceptual:
+        return Perceptual;
     }
 
-    return espurna::light::ValueMin;
+    return Linear;
 }
 
-class LightTransitionHandler {
-public:
-    // internal calculations are done in floats, so hard-limit target & step time to a certain value
-    // that can be representend precisely when casting milliseconds times back and forth
-    static constexpr espurna::duration::Milliseconds TimeMin { 10 };
-    static constexpr espurna::duration::Milliseconds TimeMax { 1ul << 24ul };
-
-    struct Transition {
-        float& value;
-        long target;
-        float step;
-        size_t count;
-    };
-
-    using Transitions = std::vector<Transition>;
-
-    LightTransitionHandler() = delete;
-
-    LightTransitionHandler(LightChannels& channels, LightTransition transition, bool state) :
-        _transition(clamp(transition)),
-        _state(state)
-    {
-        prepare(channels, transition, state);
-    }
-
-    template <typename StateFunc, typename ValueFunc, typename UpdateFunc>
-    bool run(StateFunc&& state, ValueFunc&& value, UpdateFunc&& update) {
-        bool next { false };
-
-        if (!_state_notified && _state) {
-            _state_notified = true;
-            state(_state);
-        }
-
-        for (size_t index = 0; index < _prepared.size(); ++index) {
-            auto& transition = _prepared[index];
-            if (!transition.count) {
-                continue;
-            }
-
-            if (--transition.count) {
-                transition.value += transition.step;
-                next = true;
-            } else {
-                transition.value = transition.target;
-            }
-
-            value(index, transition.value);
-        }
-
-        if (!_state_notified && !next && !_state) {
-            _state_notified = true;
-            state(_state);
-        }
-
-        update();
-
-        return next;
-    }
-
-    const Transitions& prepared() const {
-        return _prepared;
-    }
-
-    bool state() const {
-        return _state;
-    }
-
-    espurna::duration::Milliseconds time() const {
-        return _transition.time;
-    }
-
-    espurna::duration::Milliseconds step() const {
-        return _transition.step;
-    }
-
-private:
-    void minimalTime() {
-        _transition.time = TimeMin;
-        _transition.step = TimeMin;
-    }
-
-    void prepare(LightChannels& channels, LightTransition transition, bool state) {
-        // generate a single transitions list for all the channels that had changed
-        // after that, provider loop will run() the list and assign intermediate target value(s)
-        bool delayed { false };
-        for (auto& channel : channels) {
-            if (prepare(channel, transition, state)) {
-                delayed = true;
-            }
-        }
-
-        // target values are already assigned, next provider loop will apply them
-        if (!delayed) {
-            minimalTime();
-        }
-    }
-
-    bool prepare(LightChannel& channel, const LightTransition& transition, bool state) {
-        long target = (state && channel.state)
-            ? channel.value
-            : espurna::light::ValueMin;
-
-        channel.target = target;
-        if (channel.gamma) {
-            target = _lightGammaMap(target);
-        }
-
-        if (channel.inverse) {
-            target = espurna::light::ValueMax - target;
-        }
-
-        const float Diff { static_cast<float>(target) - channel.current };
-        if (!isImmediate(transition, Diff)) {
-            pushGradual(transition, channel.current, target, Diff);
-            return true;
-        }
-
-        pushImmediate(channel.current, target, Diff);
-        return false;
-    }
-
-    void push(float& current, long target, float diff, size_t count) {
-        _prepared.push_back(
-            Transition{
-                .value = current,
-                .target = target,
-                .step = diff,
-                .count = count,
-            });
-    }
-
-    void pushImmediate(float& current, long target, float diff) {
-        push(current, target, diff, 1);
-    }
-
-    void pushGradual(const LightTransition& transition, float& current, long target, float diff) {
-        const auto TotalTime = static_cast<float>(transition.time.count());
-        const auto StepTime = static_cast<float>(transition.step.count());
-
-        constexpr float BaseStep { 1.0f };
-        const float Diff { std::abs(diff) };
-        const float Every { TotalTime / Diff };
-
-        float step { (diff > 0.0f) ? BaseStep : -BaseStep };
-        if (Every < StepTime) {
-            step *= (StepTime / Every);
-        }
-
-        const float Count { std::floor(Diff / std::abs(step)) };
-        push(current, target, step, static_cast<size_t>(Count));
-    }
-
-    static bool isImmediate(const LightTransition& transition, float diff) {
-        return !transition.time.count()
-            || (transition.step >= transition.time)
-            || (std::abs(diff) <= std::numeric_limits<float>::epsilon());
-    }
-
-    static LightTransition clamp(LightTransition value) {
-        LightTransition out;
-        out.time = std::min(value.time, TimeMax);
-        out.step = std::min(value.step, TimeMax);
-        return out;
-    }
-
-    Transitions _prepared;
-    bool _state_notified { false };
-
-    LightTransition _transition;
-    bool _state;
-};
-
-constexpr espurna::duration::Milliseconds LightTransitionHandler::TimeMin;
-constexpr espurna::duration::Milliseconds LightTransitionHandler::TimeMax;
+// Decreasing values use reverse() of the perceptual curve, so dimming also has even steps of perceived brightness
+std::unique_ptr<LightTransitionHandler> _lightTransitionHandler(LightChannels& channels, LightTransition transition, bool state) {
+    return std::make_unique<LightTransitionHandler>(
+        channels, transition,
+        _lightTransitionPoints(transition.curve),
+        transition.curve == espurna::light::Curve::Perceptual,
+        state);
+}
 
 struct LightUpdate {
     LightTransition transition;
@@ -1900,15 +1145,11 @@ std::unique_ptr<LightTransitionHandler> _light_transition;
 
 auto _light_transition_time = espurna::light::build::transitionTime();
 auto _light_transition_step = espurna::light::build::transitionStep();
+auto _light_transition_curve = espurna::light::build::transitionCurve();
 bool _light_use_transitions = false;
 
 static_assert((espurna::light::ValueMax - espurna::light::ValueMin) != 0, "");
 
-template <typename T>
-constexpr T _lightValueMap(long value, T min, T max) {
-    return (value - espurna::light::ValueMin) * (max - min) / (espurna::light::ValueMax - espurna::light::ValueMin) + min;
-}
-
 #if LIGHT_PROVIDER == LIGHT_PROVIDER_DIMMER
 
 uint32_t _light_pwm_min;
@@ -1918,15 +1159,18 @@ uint32_t _light_pwm_max;
 void _lightProviderHandleState(bool) {
 }
 
-// Automatically scale from our value to the internal one used by the PWM
-// Currently, both u32 and float variants are almost the same precision
-// Slight difference would be the amount of generated code; one variant
-// needs to call float division, the other one is to simply truncate it
-// using two external values which are then used in integer divison
-// TODO: actually check call speed?
-// TODO: any difference between __fixsfsi and lround?
-void _lightProviderHandleValue(size_t channel, float value) {
-    pwmDuty(channel, _lightValueMap(value, _light_pwm_min, _light_pwm_max));
+LightOutputTable::Options _lightProviderOutputRange() {
+    return LightOutputTable::Options{
+        .gamma = false,
+        .inverse = false,
+        .min = _light_pwm_min,
+        .max = _light_pwm_max,
+    };
+}
+
+// Value is already scaled to the internal one used by the PWM
+void _lightProviderHandleValue(size_t channel, LightOutputValue value) {
+    pwmDuty(channel, value);
 }
 
 void _lightProviderHandleUpdate() {
@@ -1956,10 +1200,19 @@ constexpr unsigned int _my92xx_value_min = 0;
 constexpr unsigned int _my92xx_value_max =
         _lightMy92xxValueMax(espurna::light::build::my92xxCommand());
 
-void _lightProviderHandleValue(size_t channel, float value) {
-    _my92xx->setChannel(
-        _light_my92xx_channel_map[channel],
-        _lightValueMap(value, _my92xx_value_min, _my92xx_value_max));
+static_assert(_my92xx_value_max <= std::numeric_limits<LightOutputValue>::max(), "");
+
+LightOutputTable::Options _lightProviderOutputRange() {
+    return LightOutputTable::Options{
+        .gamma = false,
+        .inverse = false,
+        .min = static_cast<LightOutputValue>(_my92xx_value_min),
+        .max = static_cast<LightOutputValue>(_my92xx_value_max),
+    };
+}
+
+void _lightProviderHandleValue(size_t channel, LightOutputValue value) {
+    _my92xx->setChannel(_light_my92xx_channel_map[channel], value);
 }
 
 void _lightProviderHandleUpdate() {
@@ -1976,7 +1229,17 @@ void _lightProviderHandleState(bool state) {
     _light_provider->state(state);
 }
 
-void _lightProviderHandleValue(size_t channel, float value) {
+// Custom provider receives the value in the same range as the input
+LightOutputTable::Options _lightProviderOutputRange() {
+    return LightOutputTable::Options{
+        .gamma = false,
+        .inverse = false,
+        .min = static_cast<float>(espurna::light::ValueMin),
+        .max = static_cast<float>(espurna::light::ValueMax),
+    };
+}
+
+void _lightProviderHandleValue(size_t channel, LightOutputValue value) {
     _light_provider->channel(channel, value);
 }
 
@@ -1986,6 +1249,27 @@ void _lightProviderHandleUpdate() {
 
 #endif
 
+// Output is the same for every channel with the same gamma & inverse flags, so there are at most
+// 4 tables shared between all of the channels. Existing tables are re-generated in-place, since
+// the currently running transition might still be using them
+std::array<std::unique_ptr<LightOutputTable>, 4> _light_output_tables;
+
+const LightOutputTable* _lightOutputTable(bool gamma, bool inverse) {
+    auto options = _lightProviderOutputRange();
+    options.gamma = gamma;
+    options.inverse = inverse;
+
+    auto& table = _light_output_tables[(gamma ? 2 : 0) + (inverse ? 1 : 0)];
+    if (!table) {
+        table = std::make_unique<LightOutputTable>();
+        table->reset(options);
+    } else if (!(table->options() == options)) {
+        table->reset(options);
+    }
+
+    return table.get();
+}
+
 void _lightProviderUpdate() {
     if (!_light_provider_update) {
         return;
@@ -2211,6 +1495,31 @@ bool _lightApiTransition(espurna::StringView payload) {
     return false;
 }
 
+bool _lightApiChannelTransition(size_t id, espurna::StringView payload) {
+    const auto result = parseUnsigned(payload, 10);
+    if (result.ok) {
+        lightChannelTransitionTime(id,
+            espurna::duration::Milliseconds(result.value));
+        return true;
+    }
+
+    return false;
+}
+
+bool _lightApiCurve(espurna::StringView payload) {
+    using espurna::settings::internal::CurveOptions;
+
+    const auto value = payload.toString();
+    for (const auto& option : CurveOptions) {
+        if (option == value) {
+            lightTransitionCurve(option.value());
+            return true;
+        }
+    }
+
+    return false;
+}
+
 int _lightMqttReportMask() {
     return espurna::light::Report::Default & ~(mqttForward() ? espurna::light::Report::None : espurna::light::Report::Mqtt);
 }
@@ -2249,6 +1558,8 @@ void _lightMqttCallback(unsigned int type, espurna::StringView topic, espurna::S
     if (type == MQTT_CONNECT_EVENT) {
 
         mqttSubscribe(MQTT_TOPIC_TRANSITION);
+        mqttSubscribe(MQTT_TOPIC_TRANSITION "/+");
+        mqttSubscribe(MQTT_TOPIC_CURVE);
 
         mqttSubscribe(MQTT_TOPIC_CHANNEL "/+");
         mqttSubscribe(MQTT_TOPIC_BRIGHTNESS);
@@ -2314,6 +1625,21 @@ void _lightMqttCallback(unsigned int type, espurna::StringView topic, espurna::S
             return;
         }
 
+        // Per-channel transition setting (persist)
+        if (t.startsWith(MQTT_TOPIC_TRANSITION "/")) {
+            size_t id;
+            if (_lightTryParseChannel(t, id)) {
+                _lightApiChannelTransition(id, payload);
+            }
+            return;
+        }
+
+        // Transition curve setting (persist)
+        if (t.equals(MQTT_TOPIC_CURVE)) {
+            _lightApiCurve(payload);
+            return;
+        }
+
         // Brightness
         if (t.equals(MQTT_TOPIC_BRIGHTNESS)) {
             _lightAdjustBrightness(payload);
@@ -2473,6 +1799,30 @@ void _lightApiSetup() {
         }
     );
 
+    apiRegister(F(MQTT_TOPIC_TRANSITION "/+"),
+        [](ApiRequest& request) {
+            return _lightApiTryHandle(request, [&](size_t id) {
+                request.send(String(lightChannelTransitionTime(id).count()));
+                return true;
+            });
+        },
+        [](ApiRequest& request) {
+            return _lightApiTryHandle(request, [&](size_t id) {
+                return _lightApiChannelTransition(id, request.param(F("value")));
+            });
+        }
+    );
+
+    apiRegister(F(MQTT_TOPIC_CURVE),
+        [](ApiRequest& request) {
+            request.send(espurna::settings::internal::serialize(lightTransitionCurve()));
+            return true;
+        },
+        [](ApiRequest& request) {
+            return _lightApiCurve(request.param(F("value")));
+        }
+    );
+
     apiRegister(F(MQTT_TOPIC_BRIGHTNESS),
         [](ApiRequest& request) {
             request.send(_light_brightness.toString());
@@ -2559,6 +1909,52 @@ void _lightWebSocketStatus(JsonObject& root) {
     light["state"] = _light_state;
 }
 
+// Same as 'light', color is formatted by the webui
+espurna::web::ws::BinaryFrame _lightWebSocketBinary() {
+    static_assert(espurna::light::ValueMax <= 255, "");
+    static_assert(espurna::light::BrightnessMax <= 255, "");
+
+    using espurna::web::ws::BinaryFrame;
+
+    uint8_t flags = _light_state ? 1 : 0;
+    if (_light_use_cct) {
+        flags |= 1 << 1;
+    }
+
+    if (_light_use_color) {
+        flags |= _light_use_rgb ? (1 << 2) : (1 << 3);
+    }
+
+    BinaryFrame out(BinaryFrame::Type::Light, 3 + _light_channels.size() + 6);
+    out.u8(flags);
+    out.u8(_light_brightness.value());
+
+    out.u8(_light_channels.size());
+    for (auto& channel : _light_channels) {
+        out.u8(channel.inputValue);
+    }
+
+    if (_light_use_cct) {
+        out.u16(_light_temperature.mireds().value);
+    }
+
+    if (_light_use_color) {
+        const auto rgb = _lightToInputRgb();
+        if (_light_use_rgb) {
+            out.u8(rgb.red());
+            out.u8(rgb.green());
+            out.u8(rgb.blue());
+        } else {
+            const auto hsv = _lightHsv(rgb);
+            out.u16(hsv.hue());
+            out.u8(hsv.saturation());
+            out.u8(_lightBrightnessPercent());
+        }
+    }
+
+    return out;
+}
+
 void _lightWebSocketOnVisible(JsonObject& root) {
     wsPayloadModule(root, PrefixLightLong);
 
@@ -2593,6 +1989,7 @@ void _lightWebSocketOnConnected(JsonObject& root) {
     root["ltSaveDelay"] = _light_save_delay.count();
     root["ltTime"] = _light_transition_time.count();
     root["ltStep"] = _light_transition_step.count();
+    root["ltCurve"] = espurna::settings::internal::serialize(_light_transition_curve);
 }
 
 void _lightWebSocketOnAction(uint32_t client_id, const char* action, JsonObject& data) {
@@ -2822,7 +2219,7 @@ static void _lightCommandChannel(::terminal::CommandContext&& ctx) {
                 _light_channels[channel].inputValue,
                 _light_channels[channel].value,
                 _light_channels[channel].target,
-                String(_light_channels[channel].current, 2).c_str());
+                String(espurna::light::transition::fraction(_light_channels[channel].current), 2).c_str());
     };
 
     if (ctx.argv.size() > 2) {
@@ -2972,8 +2369,7 @@ void lightHs(long hue, long saturation) {
 }
 
 void lightHsv(espurna::light::Hsv hsv) {
-    lightHs(hsv.hue(), hsv.saturation());
-    lightBrightnessPercent(hsv.value());
+    espurna::light::payload::hsv(_light_mapping, _light_brightness, hsv.asArray());
 }
 
 espurna::light::Hsv lightHsv() {
@@ -3001,7 +2397,7 @@ void _lightReport(int report) {
 
 #if WEB_SUPPORT
     if (report & espurna::light::Report::Web) {
-        wsPost(_lightWebSocketStatus);
+        wsPostTelemetry(_lightWebSocketStatus, _lightWebSocketBinary);
     }
 #endif
 
@@ -3021,10 +2417,10 @@ void _lightUpdateDebug(const LightTransitionHandler& handler) {
     }
 
     for (auto& transition : handler.prepared()) {
-        if (transition.count > 1) {
-            DEBUG_MSG_P(PSTR("[LIGHT] Transition from %s to %ld (step %s, %u times)\n"),
-                    String(transition.value, 2).c_str(), transition.target,
-                    String(transition.step, 2).c_str(), transition.count);
+        if (transition.gradual) {
+            DEBUG_MSG_P(PSTR("[LIGHT] Transition from %s to %s\n"),
+                String(espurna::light::transition::fraction(transition.start), 2).c_str(),
+                String(espurna::light::transition::fraction(transition.target), 2).c_str());
         }
     }
 }
@@ -3095,7 +2491,7 @@ void _lightUpdate() {
     _light_update.run([](LightTransition transition, int report, bool save) {
         // Channel output values will be set by the handler class and the specified provider
         // We either set the values immediately or schedule an ongoing transition
-        _light_transition = std::make_unique<LightTransitionHandler>(_light_channels, transition, _light_state);
+        _light_transition = _lightTransitionHandler(_light_channels, transition, _light_state);
         _light_provider_update.start(_light_transition->step());
         _lightUpdateDebug(*_light_transition);
 
@@ -3338,7 +2734,39 @@ espurna::duration::Milliseconds lightTransitionStep() {
 }
 
 LightTransition lightTransition() {
-    return {lightTransitionTime(), lightTransitionStep()};
+    return LightTransition{
+        .time = lightTransitionTime(),
+        .step = lightTransitionStep(),
+        .curve = _light_transition_curve,
+        .channels = _light_use_transitions,
+    };
+}
+
+espurna::light::Curve lightTransitionCurve() {
+    return _light_transition_curve;
+}
+
+void lightTransitionCurve(espurna::light::Curve curve) {
+    _light_transition_curve = curve;
+    espurna::light::settings::transitionCurve(curve);
+    saveSettings();
+}
+
+espurna::duration::Milliseconds lightChannelTransitionTime(size_t id) {
+    if (id < _light_channels.size()) {
+        return _light_channels[id].time;
+    }
+
+    return espurna::duration::Milliseconds(0);
+}
+
+void lightChannelTransitionTime(size_t id, espurna::duration::Milliseconds time) {
+    if (id < _light_channels.size()) {
+        time = std::min(time, LightTransitionHandler::TimeMax);
+        _light_channels[id].time = time;
+        espurna::light::settings::channelTransitionTime(id, time);
+        saveSettings();
+    }
 }
 
 void lightTransition(espurna::duration::Milliseconds time, espurna::duration::Milliseconds step) {
@@ -3422,6 +2850,7 @@ void _lightConfigure() {
     _light_use_transitions = espurna::light::settings::transition();
     _light_transition_time = espurna::light::settings::transitionTime();
     _light_transition_step = espurna::light::settings::transitionStep();
+    _light_transition_curve = espurna::light::settings::transitionCurve();
 
     _light_save = espurna::light::settings::save();
     _light_save_delay = espurna::light::settings::saveDelay();
@@ -3433,6 +2862,11 @@ void _lightConfigure() {
 #endif
         _light_channels[index].inverse = espurna::light::settings::inverse(index);
         _light_channels[index].gamma = (_light_has_color && _light_use_gamma) && _lightUseGamma(Channels, index);
+        _light_channels[index].output = _lightOutputTable(
+            _light_channels[index].gamma, _light_channels[index].inverse);
+        _light_channels[index].time = std::min(
+            espurna::light::settings::channelTransitionTime(index),
+            LightTransitionHandler::TimeMax);
     }
 
     const auto last_process_input_values = _light_process_input_values;
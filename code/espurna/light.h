@@ -18,6 +18,7 @@
 #define MQTT_TOPIC_MIRED            "mired"
 #define MQTT_TOPIC_KELVIN           "kelvin"
 #define MQTT_TOPIC_TRANSITION       "transition"
+#define MQTT_TOPIC_CURVE            "curve"
 
 namespace espurna {
 namespace light {
@@ -38,6 +39,15 @@ constexpr long BrightnessMax { LIGHT_MAX_BRIGHTNESS };
 constexpr long MiredsCold { LIGHT_COLDWHITE_MIRED };
 constexpr long MiredsWarm { LIGHT_WARMWHITE_MIRED };
 
+// How the value changes over the course of the transition
+enum class Curve {
+    Linear,
+    EaseIn,
+    EaseOut,
+    EaseInOut,
+    Perceptual,     // equal steps of perceived brightness, ease-in when going up and ease-out when going down
+};
+
 struct Report {
     static constexpr int None = 0;
     static constexpr int Web = 1 << 0;
@@ -182,6 +192,8 @@ public:
 struct LightTransition {
     espurna::duration::Milliseconds time;
     espurna::duration::Milliseconds step;
+    espurna::light::Curve curve { espurna::light::Curve::Linear };
+    bool channels { false };        // use per-channel time instead of the one above, when it is set
 };
 
 size_t lightChannels();
@@ -191,6 +203,13 @@ LightTransition lightTransition();
 espurna::duration::Milliseconds lightTransitionTime();
 espurna::duration::Milliseconds lightTransitionStep();
 
+espurna::light::Curve lightTransitionCurve();
+void lightTransitionCurve(espurna::light::Curve);
+
+// Zero duration resets the channel back to the global transition time
+espurna::duration::Milliseconds lightChannelTransitionTime(size_t id);
+void lightChannelTransitionTime(size_t id, espurna::duration::Milliseconds);
+
 // Transition from current state to the previously prepared one
 // (using any of functions declared down below which modify global state, channel values or their state)
 void lightTransition(espurna::duration::Milliseconds time, espurna::duration::Milliseconds step);
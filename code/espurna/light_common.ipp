@@ -0,0 +1,1234 @@
+/*
+
+Part of LIGHT MODULE
+
+Channel processing, output mapping and transition curves shared between the firmware and the host tests
+
+Copyright (C) 2020-2025 by Maxim Prokhorov <prokhorov dot max at outlook dot com>
+
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "libs/fs_math.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace espurna {
+namespace light {
+namespace {
+namespace output {
+
+// Gamma Correction lookup table (8 bit, ~2.2)
+constexpr long GammaMin { 0 };
+constexpr long GammaMax { 255 };
+
+inline long gamma_value(size_t index) {
+    static const std::array<uint8_t, 256> Gamma PROGMEM {
+        0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+        1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,
+        3,   3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,
+        6,   7,   7,   7,   7,   8,   8,   8,   9,   9,   9,   10,  10,  11,  11,  11,
+        12,  12,  13,  13,  14,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,
+        19,  20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,
+        29,  30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,
+        41,  42,  43,  43,  44,  45,  46,  47,  48,  49,  50,  50,  51,  52,  53,  54,
+        55,  56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  71,
+        72,  73,  74,  75,  76,  77,  78,  80,  81,  82,  83,  84,  86,  87,  88,  89,
+        91,  92,  93,  94,  96,  97,  98,  100, 101, 102, 104, 105, 106, 108, 109, 110,
+        112, 113, 115, 116, 118, 119, 121, 122, 123, 125, 126, 128, 130, 131, 133, 134,
+        136, 137, 139, 140, 142, 144, 145, 147, 149, 150, 152, 154, 155, 157, 159, 160,
+        162, 164, 166, 167, 169, 171, 173, 175, 176, 178, 180, 182, 184, 186, 187, 189,
+        191, 193, 195, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+        223, 225, 227, 229, 231, 233, 235, 238, 240, 242, 244, 246, 248, 251, 253, 255
+    };
+
+    if (index < Gamma.size()) {
+        return pgm_read_byte(&Gamma[index]);
+    }
+
+    return 0;
+}
+
+// Value from [min:max] is scaled to the table size first
+inline long gamma(long value, long min, long max) {
+    const auto divisor = max - min;
+    if (divisor != 0l) {
+        const long scaled {
+            (value - min) * (GammaMax - GammaMin) / divisor + GammaMin };
+        return gamma_value(static_cast<size_t>(scaled));
+    }
+
+    return min;
+}
+
+// Automatically scale from our value to the one used by the provider
+template <typename T>
+constexpr T map(long value, long min, long max, T out_min, T out_max) {
+    return (value - min) * (out_max - out_min) / (max - min) + out_min;
+}
+
+// Every possible input value mapped to the provider output, with gamma correction and inverse
+// already applied. Generated once when channels are configured, so updating the output value
+// (e.g. in the middle of a transition) is just a single lookup
+template <typename T, long Min, long Max>
+class Table {
+public:
+    static_assert(Max > Min, "");
+    static constexpr size_t Size = static_cast<size_t>(Max - Min + 1);
+
+    static constexpr long InputMin { Min };
+    static constexpr long InputMax { Max };
+
+    struct Options {
+        bool gamma;
+        bool inverse;
+        T min;
+        T max;
+
+        bool operator==(const Options& other) const {
+            return (gamma == other.gamma)
+                && (inverse == other.inverse)
+                && (min == other.min)
+                && (max == other.max);
+        }
+    };
+
+    static T value(long input, const Options& options) {
+        if (options.gamma) {
+            input = output::gamma(input, Min, Max);
+        }
+
+        if (options.inverse) {
+            input = Max - input;
+        }
+
+        return map(input, Min, Max, options.min, options.max);
+    }
+
+    void reset(const Options& options) {
+        _options = options;
+        for (size_t index = 0; index < Size; ++index) {
+            _values[index] = value(Min + static_cast<long>(index), options);
+        }
+    }
+
+    const Options& options() const {
+        return _options;
+    }
+
+    T operator[](long input) const {
+        return _values[static_cast<size_t>(std::clamp(input, Min, Max) - Min)];
+    }
+
+private:
+    Options _options {};
+    std::array<T, Size> _values {};
+};
+
+template <typename T, long Min, long Max>
+constexpr size_t Table<T, Min, Max>::Size;
+
+template <typename T, long Min, long Max>
+constexpr long Table<T, Min, Max>::InputMin;
+
+template <typename T, long Min, long Max>
+constexpr long Table<T, Min, Max>::InputMax;
+
+} // namespace output
+
+namespace easing {
+
+// Transition progress as a fraction of the total time
+constexpr uint32_t ProgressBits { 16 };
+constexpr uint32_t ProgressMax { 1ul << ProgressBits };
+
+// Curves are approximated by a number of straight segments, values in-between
+// the points are interpolated. Lookup is a shift, a mask and a multiplication
+constexpr uint32_t SegmentBits { 6 };
+constexpr uint32_t SegmentShift { ProgressBits - SegmentBits };
+constexpr uint32_t SegmentSize { 1ul << SegmentShift };
+
+using Points = std::array<uint32_t, (1ul << SegmentBits) + 1>;
+
+constexpr double linear(double x) {
+    return x;
+}
+
+constexpr double in(double x) {
+    return x * x;
+}
+
+constexpr double out(double x) {
+    return x * (2.0 - x);
+}
+
+constexpr double in_out(double x) {
+    return x * x * (3.0 - 2.0 * x);
+}
+
+// CIE 1976 lightness to the relative luminance. Progress is treated as lightness, so
+// equal steps in time produce (approximately) equal steps of perceived brightness
+constexpr double perceptual(double x) {
+    return (x > 0.08)
+        ? ((x * 100.0 + 16.0) / 116.0)
+            * ((x * 100.0 + 16.0) / 116.0)
+            * ((x * 100.0 + 16.0) / 116.0)
+        : (x * 100.0 / 903.3);
+}
+
+template <typename T>
+constexpr Points make(T func) {
+    Points out{};
+    for (size_t index = 0; index < out.size(); ++index) {
+        const auto x = static_cast<double>(index) / static_cast<double>(out.size() - 1);
+        out[index] = static_cast<uint32_t>(func(x) * static_cast<double>(ProgressMax) + 0.5);
+    }
+
+    return out;
+}
+
+inline uint32_t point(const Points& points, size_t index) {
+    return pgm_read_dword(&points[index]);
+}
+
+// Every curve must only ever go up, both for the value and the reverse()
+inline uint32_t value(const Points& points, uint32_t progress) {
+    if (progress >= ProgressMax) {
+        return ProgressMax;
+    }
+
+    const auto index = static_cast<size_t>(progress >> SegmentShift);
+    const auto offset = progress & (SegmentSize - 1);
+
+    const auto lhs = point(points, index);
+    const auto rhs = point(points, index + 1);
+
+    return lhs + (((rhs - lhs) * offset) >> SegmentShift);
+}
+
+// Curve rotated around the center point, e.g. in -> out
+inline uint32_t reverse(const Points& points, uint32_t progress) {
+    if (progress >= ProgressMax) {
+        return ProgressMax;
+    }
+
+    return ProgressMax - value(points, ProgressMax - progress);
+}
+
+} // namespace easing
+
+namespace transition {
+
+// Channel values are interpolated as fixed-point numbers, lower bits are the fractional part
+constexpr long FractionBits { 8 };
+
+constexpr long fixed(long value) {
+    return value << FractionBits;
+}
+
+constexpr long integral(long value) {
+    return value >> FractionBits;
+}
+
+inline float fraction(long value) {
+    return static_cast<float>(value) / static_cast<float>(1l << FractionBits);
+}
+
+inline long interpolate(long start, long target, uint32_t progress) {
+    return start + static_cast<long>(
+        (static_cast<int64_t>(target - start) * static_cast<int64_t>(progress)) >> easing::ProgressBits);
+}
+
+// Progress is a fraction of the channel transition time. Instead of dividing by the time on every
+// step, each channel keeps the progress rate per millisecond (also fixed-point) calculated once
+constexpr uint32_t RateBits { 16 };
+
+inline uint32_t rate(uint64_t time) {
+    const auto out = (static_cast<uint64_t>(easing::ProgressMax) << RateBits) / time;
+    return static_cast<uint32_t>(std::min(out,
+        static_cast<uint64_t>(std::numeric_limits<uint32_t>::max())));
+}
+
+inline uint32_t progress(uint64_t elapsed, uint64_t time, uint32_t rate) {
+    if (elapsed >= time) {
+        return easing::ProgressMax;
+    }
+
+    const auto out = (elapsed * rate) >> RateBits;
+    return static_cast<uint32_t>(std::min(out,
+        static_cast<uint64_t>(easing::ProgressMax)));
+}
+
+} // namespace transition
+
+// Channel input value processing. Every processing step is a callable object, combined
+// by the channel apply() into a chain that produces the channel value from its input
+
+namespace process {
+
+template <typename T>
+long chained(long input, const T& process) {
+    return process(input);
+}
+
+template <typename T, typename... Args>
+long chained(long input, const T& process, Args&&... args) {
+    return chained(process(input), std::forward<Args>(args)...);
+}
+
+template <long Min, long Max>
+class Brightness {
+public:
+    Brightness() = default;
+    explicit Brightness(long value) :
+        _value(clamp(value))
+    {}
+
+    Brightness& operator=(long value) {
+        this->value(value);
+        return *this;
+    }
+
+    long value() const {
+        return _value;
+    }
+
+    void value(long value) {
+        _value = clamp(value);
+    }
+
+    long percent() const {
+        return (_value * 100l) / Max;
+    }
+
+    void percent(long value) {
+        const auto Fixed = std::clamp(value, 0l, 100l);
+        const auto Ratio = Max * Fixed;
+        this->value(Ratio / 100l);
+    }
+
+    long operator()(long input) const {
+        return (input * _value) / Max;
+    }
+
+    String toString() const {
+        return String(_value, 10);
+    }
+
+private:
+    static long clamp(long value) {
+        return std::clamp(value, Min, Max);
+    }
+
+    long _value { Max };
+};
+
+// Reset inputValue directly in the expression
+// Ignores all previous values, should only be used at the beginning
+template <long Max>
+struct ResetInput {
+    ResetInput() = delete;
+    explicit ResetInput(long value) :
+        _value(value)
+    {}
+
+    long operator()(long) const {
+        return _value;
+    }
+
+    // 0.0 is the 'coldest', 1.0 is the 'warmest'
+    static ResetInput forWarm(float factor) {
+        return ResetInput(factor * Max);
+    }
+
+    // opposite value of `forWarm` for the given factor
+    static ResetInput forCold(float factor) {
+        return ResetInput((1.0f - factor) * Max);
+    }
+
+private:
+    long _value;
+};
+
+// Scale white channel(s) value, e.g. when white LEDs are much brighter than the RGB ones
+struct ScaledWhite {
+    ScaledWhite() = delete;
+    explicit ScaledWhite(float factor) :
+        _factor(factor)
+    {}
+
+    long operator()(long input) const {
+        return std::lround(static_cast<float>(input) * _factor);
+    }
+
+private:
+    float _factor;
+};
+
+// To handle both 4 and 5 channels, allow to 'adjust' internal factor calculation after construction
+// When processing the channel values, this is the expected sequence:
+// [250,150,0] -> [200,100,0,50] -> [250,125,0,63], factor is 1.25
+//
+// XXX: before 1.15.0:
+// - factor for the example above is 1 b/c of integer division, meaning the sequence is instead:
+// [250,150,0] -> [200,100,0,50] -> [200,100,0,50]
+// - when modified, white channels(s) `inputValue` is always equal to the output `value`
+template <long Max>
+struct RgbWithoutWhite {
+    RgbWithoutWhite() = delete;
+    RgbWithoutWhite(long red, long green, long blue) :
+        _common(makeCommon(red, green, blue)),
+        _factor(makeFactor(_common)),
+        _luminance(makeLuminance(_common))
+    {}
+
+    long operator()(long input) const {
+        return std::lround(static_cast<float>(input - _common.inputMin) * _factor);
+    }
+
+    template <typename... Args>
+    void adjustOutput(Args&&... args) {
+        _common.outputMax = std::max({
+            _common.outputMax,
+            std::forward<Args>(args)...
+        });
+        _factor = makeFactor(_common);
+        _luminance = makeLuminance(_common);
+    }
+
+    long inputMin() const {
+        return _common.inputMin;
+    }
+
+    float factor() const {
+        return _factor;
+    }
+
+    float luminance() const {
+        return _luminance;
+    }
+
+private:
+    struct Common {
+        long inputMin;
+        long inputMax;
+        long outputMax;
+    };
+
+    static float makeLuminance(Common common) {
+        const auto raw = (common.inputMin + common.inputMax) / 2;
+        return static_cast<float>(raw) / Max;
+    }
+
+    static float makeFactor(Common common) {
+        const auto inputMax = static_cast<float>(common.inputMax);
+        const auto outputMax = static_cast<float>(common.outputMax);
+        return (outputMax > 0.0f)
+            ? (inputMax / outputMax)
+            : 0.0f;
+    }
+
+    static Common makeCommon(long red, long green, long blue) {
+        Common out;
+        out.inputMax = std::max({red, green, blue});
+        out.inputMin = std::min({red, green, blue});
+        out.outputMax = std::max({
+            red - out.inputMin,
+            green - out.inputMin,
+            blue - out.inputMin
+        });
+
+        return out;
+    }
+
+    Common _common;
+    float _factor;
+    float _luminance;
+};
+
+} // namespace process
+
+namespace color {
+
+using Values = std::array<long, 3>;
+
+// HSV to RGB transformation, hue is [0...360], saturation and value are [0...100]
+//
+// INPUT: [0,100,57]
+// IS: [145,0,0]
+// SHOULD: [255,0,0]
+template <long Min, long Max>
+Values rgb(long hue, long saturation, long value) {
+    double r { static_cast<double>(Min) };
+    double g { static_cast<double>(Min) };
+    double b { static_cast<double>(Min) };
+
+    static constexpr auto Scale = 100.0;
+    auto v = static_cast<double>(value) / Scale;
+
+    if (saturation) {
+        auto h = hue;
+        if (h < 0) {
+            h = 0;
+        } else if (h >= 360) {
+            h = 359;
+        }
+
+        auto s = static_cast<double>(saturation) / Scale;
+
+        auto c = v * s;
+
+        auto hmod2 = fs_fmod(static_cast<double>(h) / 60.0, 2.0);
+        auto x = c * (1.0 - std::abs(hmod2 - 1.0));
+
+        auto m = v - c;
+
+        if ((0 <= h) && (h < 60)) {
+            r = c;
+            g = x;
+        } else if ((60 <= h) && (h < 120)) {
+            r = x;
+            g = c;
+        } else if ((120 <= h) && (h < 180)) {
+            g = c;
+            b = x;
+        } else if ((180 <= h) && (h < 240)) {
+            g = x;
+            b = c;
+        } else if ((240 <= h) && (h < 300)) {
+            r = x;
+            b = c;
+        } else if ((300 <= h) && (h < 360)) {
+            r = c;
+            b = x;
+        }
+
+        constexpr auto ScaleMax = static_cast<double>(Max);
+        r = (r + m) * ScaleMax;
+        g = (g + m) * ScaleMax;
+        b = (b + m) * ScaleMax;
+    }
+
+    return {
+        static_cast<long>(std::nearbyint(r)),
+        static_cast<long>(std::nearbyint(g)),
+        static_cast<long>(std::nearbyint(b))};
+}
+
+// Kelvin to RGB approximation algorithm by Tanner Helland
+// * https://tannerhelland.com/2012/09/18/convert-temperature-rgb-algorithm-code.html
+// Original code for RGB lights from AiLight library by Sacha Telgenhof (@
+// * https://github.com/stelgenhof/AiLight/blob/develop/lib/AiLight/AiLight.cpp
+template <long Min, long Max>
+Values kelvin(long kelvin) {
+    kelvin /= 100;
+    const auto red = ((kelvin <= 66)
+        ? Max
+        : std::lround(329.698727446 * fs_pow(static_cast<double>(kelvin - 60), -0.1332047592)));
+    const auto green = ((kelvin <= 66)
+        ? std::lround(99.4708025861 * fs_log(kelvin) - 161.1195681661)
+        : std::lround(288.1221695283 * fs_pow(static_cast<double>(kelvin), -0.0755148492)));
+    const auto blue = ((kelvin >= 66)
+        ? Max
+        : ((kelvin <= 19)
+            ? Min
+            : std::lround(138.5177312231 * fs_log(static_cast<double>(kelvin - 10)) - 305.0447927307)));
+
+    return {red, green, blue};
+}
+
+// Position of the color temperature in the [cold:warm] range
+// 0.0 is the 'coldest', 1.0 is the 'warmest'
+inline float factor(long mireds, long cold, long warm) {
+    const auto Mireds = static_cast<float>(mireds);
+    const auto Cold = static_cast<float>(cold);
+    const auto Warm = static_cast<float>(warm);
+    return (Mireds - Cold) / (Warm - Cold);
+}
+
+} // namespace color
+
+namespace payload {
+
+// RGB as hex string, without the '#' prefix. Extra byte is brightness
+// Returns the number of decoded values, or zero when payload is invalid
+inline size_t hex(StringView payload, std::array<uint8_t, 4>& out) {
+    const bool JustRgb { (payload.length() == 6) };
+    const bool WithBrightness { (payload.length() == 8) };
+    if (!JustRgb && !WithBrightness) {
+        return 0;
+    }
+
+    if (!hexDecode(payload.begin(), payload.length(), out.data(), out.size())) {
+        return 0;
+    }
+
+    return WithBrightness ? 4 : 3;
+}
+
+// Every value is separated by a comma, stops at the first invalid one
+// Returns the position right after the last assigned value
+template <typename T>
+T decimals(StringView payload, T begin, T end) {
+    auto it = begin;
+
+    auto split = SplitStringView(payload, ',');
+    while (split.next()) {
+        if (it == end) {
+            break;
+        }
+
+        const auto result = parseUnsigned(split.current(), 10);
+        if (!result.ok) {
+            break;
+        }
+
+        (*it) = result.value;
+        ++it;
+    }
+
+    return it;
+}
+
+// HSV string is expected to be "H,S,V", where:
+// - H [0...360]
+// - S [0...100]
+// - V [0...100]
+// Partial or uneven payloads are discarded
+inline bool hsv(StringView payload, color::Values& out) {
+    auto it = std::begin(out);
+    const auto end = std::end(out);
+
+    auto split = SplitStringView(payload, ',');
+    while (split.next()) {
+        if (it == end) {
+            break;
+        }
+
+        const auto result = parseUnsigned(split.current(), 10);
+        if (!result.ok) {
+            break;
+        }
+
+        (*it) = result.value;
+        ++it;
+    }
+
+    return !split.remaining().length() && (it == end);
+}
+
+} // namespace payload
+
+// Channel value range is the same as the one of its output table
+template <typename Output>
+struct Channel {
+    static constexpr long ValueMin { Output::InputMin };
+    static constexpr long ValueMax { Output::InputMax };
+
+    Channel() = default;
+
+    Channel(bool inverse, bool gamma) :
+        inverse(inverse),
+        gamma(gamma)
+    {}
+
+    Channel& operator=(long input) {
+        inputValue = std::clamp(input, ValueMin, ValueMax);
+        return *this;
+    }
+
+    void apply() {
+        value = inputValue;
+    }
+
+    template <typename T>
+    void apply(const T& process) {
+        value = std::clamp(process(inputValue), ValueMin, ValueMax);
+    }
+
+    template <typename T, typename... Args>
+    void apply(const T& process, Args&&... args) {
+        value = std::clamp(
+            process::chained(process(inputValue), std::forward<Args>(args)...),
+            ValueMin, ValueMax);
+    }
+
+    bool inverse { false };                // re-map the value from [ValueMin:ValueMax] to [ValueMax:ValueMin]
+    bool gamma { false };                  // apply gamma correction to the target value
+
+    duration::Milliseconds time { 0 };     // transition time override, zero when using the global one
+
+    // TODO: remove in favour of global control, since relays are no longer bound to a single channel?
+    bool state { true };                   // is the channel ON
+
+    long inputValue { ValueMin };          // raw, without the brightness
+    long value { ValueMin };               // normalized, including brightness
+    long target { ValueMin };              // resulting value that will be given to the provider
+
+    long current { ValueMin };             // interim between the previous and the new target, used by the transition handler (fixed-point)
+
+    const Output* output { nullptr };      // target -> provider value, with gamma and inverse already applied
+};
+
+template <typename Output>
+constexpr long Channel<Output>::ValueMin;
+
+template <typename Output>
+constexpr long Channel<Output>::ValueMax;
+
+// Channel roles depend on the number of channels, e.g. single channel is always the warm white one
+template <typename T>
+class Pointers {
+public:
+    using Channels = std::vector<T>;
+    using Type = typename Channels::pointer;
+    using Data = std::array<Type, 5>;
+
+    Pointers() = default;
+    explicit Pointers(Channels& channels) {
+        reset(channels);
+    }
+
+    Pointers(const Pointers&) = default;
+    Pointers& operator=(const Pointers&) = default;
+
+    Pointers(Pointers&&) = default;
+    Pointers& operator=(Pointers&&) = default;
+
+    Pointers& operator=(Channels& channels) {
+        _data.fill(nullptr);
+        reset(channels);
+        return *this;
+    }
+
+    T* red() const {
+        return _data[0];
+    }
+
+    T* green() const {
+        return _data[1];
+    }
+
+    T* blue() const {
+        return _data[2];
+    }
+
+    T* warm() const {
+        return _data[3];
+    }
+
+    T* cold() const {
+        return _data[4];
+    }
+
+private:
+    void reset(Channels& channels) {
+        switch (channels.size()) {
+        case 0:
+            break;
+        case 1:
+            _data[3] = &channels[0];
+            break;
+        case 2:
+            _data[3] = &channels[0];
+            _data[4] = &channels[1];
+            break;
+        case 3:
+            _data[0] = &channels[0];
+            _data[1] = &channels[1];
+            _data[2] = &channels[2];
+            break;
+        case 4:
+            _data[0] = &channels[0];
+            _data[1] = &channels[1];
+            _data[2] = &channels[2];
+            _data[3] = &channels[3];
+            break;
+        case 5:
+            _data[0] = &channels[0];
+            _data[1] = &channels[1];
+            _data[2] = &channels[2];
+            _data[3] = &channels[3];
+            _data[4] = &channels[4];
+            break;
+        }
+    }
+
+    Data _data{};
+};
+
+// Access channels by their role. Missing ones are never modified, and read as the minimum value
+template <typename T>
+struct Mapping {
+    void reset() {
+        _pointers = Pointers<T>();
+    }
+
+    template <typename Other>
+    Mapping operator=(Other&& other) {
+        _pointers = std::forward<Other>(other);
+        return *this;
+    }
+
+    long red() const {
+        return get(_pointers.red());
+    }
+
+    void red(long value) {
+        set(_pointers.red(), value);
+    }
+
+    long green() const {
+        return get(_pointers.green());
+    }
+
+    void green(long value) {
+        set(_pointers.green(), value);
+    }
+
+    long blue() const {
+        return get(_pointers.blue());
+    }
+
+    void blue(long value) {
+        set(_pointers.blue(), value);
+    }
+
+    long cold() const {
+        return get(_pointers.cold());
+    }
+
+    void cold(long value) {
+        set(_pointers.cold(), value);
+    }
+
+    long warm() const {
+        return get(_pointers.warm());
+    }
+
+    void warm(long value) {
+        set(_pointers.warm(), value);
+    }
+
+    const Pointers<T>& pointers() const {
+        return _pointers;
+    }
+
+private:
+    static long get(T* ptr) {
+        if (ptr) {
+            return ptr->target;
+        }
+
+        return T::ValueMin;
+    }
+
+    static void set(T* ptr, long value) {
+        if (ptr) {
+            *ptr = value;
+        }
+    }
+
+    Pointers<T> _pointers;
+};
+
+// After the channel value was updated through the API (i.e. through changing the `inputValue`),
+// one of these functions is expected to be called. Which one is chosen is based on the current settings values.
+namespace values {
+
+// Basic brightness application; default when all other processing options are disabled
+template <typename T, typename Brightness>
+void brightness(std::vector<T>& channels, const Brightness& brightness) {
+    for (auto& channel : channels) {
+        channel.apply(brightness);
+    }
+}
+
+// Maintain compatibility with older versions, limit brightness application to the RGB when using 'color mode'.
+template <typename T, typename Brightness>
+void brightness_except_white(std::vector<T>& channels, const Brightness& brightness) {
+    auto ptr = Pointers<T>(channels);
+
+    (*ptr.red()).apply(brightness);
+    (*ptr.green()).apply(brightness);
+    (*ptr.blue()).apply(brightness);
+
+    if (ptr.warm()) {
+        (*ptr.warm()).apply();
+    }
+
+    if (ptr.cold()) {
+        (*ptr.cold()).apply();
+    }
+}
+
+// With `useCCT`, balance the value between Warm and Cold channels based on the current `mireds`.
+// Factor is 0.0 for the 'coldest' and 1.0 for the 'warmest' temperature
+template <typename T, typename Brightness>
+void cct(std::vector<T>& channels, const Brightness& brightness, float factor, float white_factor) {
+    using ResetInput = process::ResetInput<T::ValueMax>;
+    const auto White = process::ScaledWhite(white_factor);
+
+    auto ptr = Pointers<T>(channels);
+    (*ptr.warm()).apply(
+        ResetInput::forWarm(factor), White, brightness);
+    (*ptr.cold()).apply(
+        ResetInput::forCold(factor), White, brightness);
+
+    if (ptr.red() && ptr.green() && ptr.blue()) {
+        (*ptr.red()).apply(ResetInput{T::ValueMin});
+        (*ptr.green()).apply(ResetInput{T::ValueMin});
+        (*ptr.blue()).apply(ResetInput{T::ValueMin});
+    }
+}
+
+// When `useWhite` is enabled, warm white channel is 'detached' from the processing and its value depends on the input RGB.
+// Common calculation is to subtract 'white value' from the RGB based on the minimum channel value, e.g. [250, 150, 50] becomes [200, 100, 0, 50]
+//
+// General case when `useCCT` is disabled, but there are 4 channels.
+// Keeps 5th channel as-is, without applying the brightness scale or resetting the value to 0
+template <typename T, typename Brightness>
+void rgb_white(std::vector<T>& channels, const Brightness& brightness, float white_factor) {
+    using ResetInput = process::ResetInput<T::ValueMax>;
+    using RgbWithoutWhite = process::RgbWithoutWhite<T::ValueMax>;
+
+    auto rgb = RgbWithoutWhite(
+        channels[0].inputValue,
+        channels[1].inputValue,
+        channels[2].inputValue);
+    rgb.adjustOutput(rgb.inputMin());
+
+    auto ptr = Pointers<T>(channels);
+    (*ptr.red()).apply(rgb, brightness);
+    (*ptr.green()).apply(rgb, brightness);
+    (*ptr.blue()).apply(rgb, brightness);
+
+    (*ptr.warm()).apply(
+        ResetInput{rgb.inputMin()},
+        process::ScaledWhite(rgb.factor() * white_factor),
+        brightness);
+
+    if (ptr.cold()) {
+        (*ptr.cold()).apply();
+    }
+}
+
+// Use color temperature as a range for warm and cold channels, based on the calculated rgb common values
+// Every value is also scaled by `brightness` after applying all of the previous steps
+// Notice that we completely ignore inputs and reset them to either kelvin'ized or hardcoded ValueMin or ValueMax
+//
+// Heavily depends on the used temperature range; by default (153...500), we stay on the 'warm side'
+// of the scale and effectively never enable blue. Setting cold mireds to 100 will use the whole range.
+template <typename T, typename Brightness>
+void rgb_cct(std::vector<T>& channels, const Brightness& brightness, long kelvin) {
+    using ResetInput = process::ResetInput<T::ValueMax>;
+    using RgbWithoutWhite = process::RgbWithoutWhite<T::ValueMax>;
+
+    const auto RgbFromKelvin = color::kelvin<T::ValueMin, T::ValueMax>(kelvin);
+
+    auto rgb = RgbWithoutWhite(
+        RgbFromKelvin[0],
+        RgbFromKelvin[1],
+        RgbFromKelvin[2]);
+    rgb.adjustOutput(rgb.inputMin());
+
+    auto ptr = Pointers<T>(channels);
+    (*ptr.red()).apply(
+        ResetInput{RgbFromKelvin[0]},
+        rgb, brightness);
+    (*ptr.green()).apply(
+        ResetInput{RgbFromKelvin[1]},
+        rgb, brightness);
+    (*ptr.blue()).apply(
+        ResetInput{RgbFromKelvin[2]},
+        rgb, brightness);
+
+    const auto White = process::ScaledWhite(rgb.factor());
+    if (ptr.warm()) {
+        (*ptr.warm()).apply(White, brightness);
+    }
+
+    if (ptr.cold()) {
+        (*ptr.cold()).apply(White, brightness);
+    }
+}
+
+} // namespace values
+
+namespace payload {
+
+// HEX value is always prefixed, like CSS
+// - #AABBCC
+// Extra byte is interpreted like RGB + brightness
+// - #AABBCCDD
+// Otherwise, assume comma-separated decimal values. Missing ones are set to zero
+template <typename T, typename Brightness>
+void rgb(StringView payload, Mapping<T>& mapping, Brightness& brightness) {
+    if (!payload.length() || (payload[0] == '\0')) {
+        return;
+    }
+
+    if (payload[0] == '#') {
+        std::array<uint8_t, 4> values {0, 0, 0, 0};
+
+        const auto decoded = hex(
+            StringView(payload.begin() + 1, payload.end()), values);
+        if (decoded) {
+            mapping.red(values[0]);
+            mapping.green(values[1]);
+            mapping.blue(values[2]);
+            if (decoded == values.size()) {
+                brightness = values[3];
+            }
+        }
+
+        return;
+    }
+
+    std::array<long, 3> values {0, 0, 0};
+    decimals(payload, values.begin(), values.end());
+
+    mapping.red(values[0]);
+    mapping.green(values[1]);
+    mapping.blue(values[2]);
+}
+
+// Only hue and saturation are used for RGB, value is applied as the brightness percentage
+// Values are expected to be already clamped, see hsv() above for the ranges
+template <typename T, typename Brightness>
+void hsv(Mapping<T>& mapping, Brightness& brightness, const color::Values& values) {
+    const auto rgb = color::rgb<T::ValueMin, T::ValueMax>(values[0], values[1], 100);
+    mapping.red(rgb[0]);
+    mapping.green(rgb[1]);
+    mapping.blue(rgb[2]);
+
+    brightness.percent(values[2]);
+}
+
+} // namespace payload
+
+namespace transition {
+
+// Values depend on the time elapsed since the start, not on the number of times run() was called.
+// Transition options are expected to have the time, step, curve and per-channel time toggle
+template <typename T, typename Options, typename TimeSource>
+class Handler {
+public:
+    using Channels = std::vector<T>;
+    using Output = typename std::remove_pointer<decltype(T::output)>::type;
+
+    // transition time is used as the divisor when calculating the progress,
+    // hard-limit target & step time to something reasonable
+    static constexpr duration::Milliseconds TimeMin { 10 };
+    static constexpr duration::Milliseconds TimeMax { 1ul << 24ul };
+
+    static constexpr uint32_t ProgressMax { easing::ProgressMax };
+
+    struct Transition {
+        long& value;
+        long start;
+        long target;
+        const Output& output;
+        duration::Milliseconds time;
+        uint32_t rate;
+        bool reverse;
+        bool gradual;
+        bool done;
+    };
+
+    using Transitions = std::vector<Transition>;
+
+    Handler() = delete;
+
+    // Curve points are expected to live in flash. When 'reverse' is set, decreasing values
+    // use the reverse() of the curve
+    Handler(Channels& channels, Options options, const easing::Points& points, bool reverse, bool state) :
+        _options(clamp(options)),
+        _points(points),
+        _reverse(reverse),
+        _state(state),
+        _started(TimeSource::now())
+    {
+        prepare(channels, _options, state);
+    }
+
+    // When the loop is late, the next value is simply further along the way to the target
+    template <typename StateFunc, typename ValueFunc, typename UpdateFunc>
+    bool run(StateFunc&& state, ValueFunc&& value, UpdateFunc&& update) {
+        bool next { false };
+
+        if (!_state_notified && _state) {
+            _state_notified = true;
+            state(_state);
+        }
+
+        const auto elapsed = TimeSource::now() - _started;
+
+        for (size_t index = 0; index < _prepared.size(); ++index) {
+            auto& transition = _prepared[index];
+            if (transition.done) {
+                continue;
+            }
+
+            const auto progress = transition.gradual
+                ? this->progress(transition, elapsed)
+                : ProgressMax;
+
+            if (progress < ProgressMax) {
+                transition.value = interpolate(
+                    transition.start, transition.target,
+                    transition.reverse
+                        ? easing::reverse(_points, progress)
+                        : easing::value(_points, progress));
+                next = true;
+            } else {
+                transition.value = transition.target;
+                transition.done = true;
+            }
+
+            value(index, transition.output[integral(transition.value)]);
+        }
+
+        if (!_state_notified && !next && !_state) {
+            _state_notified = true;
+            state(_state);
+        }
+
+        update();
+
+        return next;
+    }
+
+    const Transitions& prepared() const {
+        return _prepared;
+    }
+
+    bool state() const {
+        return _state;
+    }
+
+    // Longest of the channel transitions
+    duration::Milliseconds time() const {
+        return _options.time;
+    }
+
+    duration::Milliseconds step() const {
+        return _options.step;
+    }
+
+    decltype(Options::curve) curve() const {
+        return _options.curve;
+    }
+
+private:
+    template <typename Duration>
+    static uint32_t progress(const Transition& transition, Duration elapsed) {
+        return transition::progress(
+            elapsed.count(), transition.time.count(), transition.rate);
+    }
+
+    void minimalTime() {
+        _options.time = TimeMin;
+        _options.step = TimeMin;
+    }
+
+    void prepare(Channels& channels, const Options& options, bool state) {
+        // generate a single transitions list for all the channels that had changed
+        // after that, provider loop will run() the list and assign intermediate target value(s)
+        _prepared.reserve(channels.size());
+
+        duration::Milliseconds longest { 0 };
+        for (auto& channel : channels) {
+            const auto time = prepare(channel, options, state);
+            longest = std::max(longest, time);
+        }
+
+        // target values are already assigned, next provider loop will apply them
+        if (!longest.count()) {
+            minimalTime();
+        } else {
+            _options.time = longest;
+        }
+    }
+
+    // Returns the channel transition time, or zero when the value is applied immediately
+    duration::Milliseconds prepare(T& channel, const Options& options, bool state) {
+        long target = (state && channel.state)
+            ? channel.value
+            : T::ValueMin;
+
+        // values are interpolated between inputs, gamma and inverse are part of the output table
+        channel.target = target;
+        target = fixed(target);
+
+        const auto time = (options.channels && channel.time.count())
+            ? std::min(channel.time, TimeMax)
+            : options.time;
+
+        const bool gradual { !isImmediate(time, options.step, channel.current, target) };
+        _prepared.push_back(
+            Transition{
+                .value = channel.current,
+                .start = channel.current,
+                .target = target,
+                .output = *channel.output,
+                .time = time,
+                .rate = gradual ? rate(time.count()) : 0,
+                .reverse = _reverse && (target < channel.current),
+                .gradual = gradual,
+                .done = false,
+            });
+
+        return gradual
+            ? time
+            : duration::Milliseconds(0);
+    }
+
+    static bool isImmediate(duration::Milliseconds time, duration::Milliseconds step, long current, long target) {
+        return !time.count()
+            || (step >= time)
+            || (current == target);
+    }
+
+    static Options clamp(Options value) {
+        Options out{value};
+        out.time = std::min(value.time, TimeMax);
+        out.step = std::min(value.step, TimeMax);
+        return out;
+    }
+
+    Transitions _prepared;
+    bool _state_notified { false };
+
+    Options _options;
+    const easing::Points& _points;
+    bool _reverse;
+    bool _state;
+
+    typename TimeSource::time_point _started;
+};
+
+template <typename T, typename Options, typename TimeSource>
+constexpr duration::Milliseconds Handler<T, Options, TimeSource>::TimeMin;
+
+template <typename T, typename Options, typename TimeSource>
+constexpr duration::Milliseconds Handler<T, Options, TimeSource>::TimeMax;
+
+template <typename T, typename Options, typename TimeSource>
+constexpr uint32_t Handler<T, Options, TimeSource>::ProgressMax;
+
+} // namespace transition
+} // namespace
+} // namespace light
+} // namespace espurna
@@ -73,6 +73,8 @@ espurna::duration::Milliseconds loop_delay { build::LoopDelayMin };
 
 std::forward_list<Callback> once_callbacks;
 
+LoopStats loop_stats;
+
 } // namespace internal
 
 void flag_reload() {
@@ -104,6 +106,10 @@ void loop_delay(duration::Milliseconds value) {
     internal::loop_delay = value;
 }
 
+LoopStats loop_stats() {
+    return internal::loop_stats;
+}
+
 void push_once(Callback callback) {
     internal::once_callbacks.push_front(std::move(callback));
 }
@@ -127,6 +133,8 @@ void push_once_unique(Callback::Type callback) {
 }
 
 void loop() {
+    const auto start = time::SystemClock::now();
+
     // Reload config before running any callbacks
     if (check_reload()) {
         for (const auto& callback : internal::reload_callbacks) {
@@ -152,6 +160,14 @@ void loop() {
         }
     }
 
+    // Only account for the time spent in callbacks, delay is not included
+    const auto elapsed = time::SystemClock::now() - start;
+
+    auto& stats = internal::loop_stats;
+    ++stats.iterations;
+    stats.total += elapsed;
+    stats.max = std::max(stats.max, elapsed);
+
     espurna::time::delay(internal::loop_delay);
 }
 
@@ -245,6 +261,14 @@ void setup() {
         apiSetup();
     #endif
 
+    #if API_SUPPORT && API_STATE_SUPPORT
+        apiStateSetup();
+    #endif
+
+    #if API_SUPPORT && API_EVENTS_SUPPORT
+        apiEventsSetup();
+    #endif
+
     // Run terminal command and send back the result
     #if TERMINAL_WEB_API_SUPPORT
         terminalWebApiSetup();
@@ -413,6 +437,10 @@ void espurnaLoopDelay(espurna::duration::Milliseconds value) {
     espurna::main::loop_delay(value);
 }
 
+LoopStats espurnaLoopStats() {
+    return espurna::main::loop_stats();
+}
+
 void setup() {
     espurna::main::setup();
 }
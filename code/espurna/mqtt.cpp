@@ -1796,6 +1796,12 @@ String mqttTopicSetter(const String& magnitude, size_t index) {
 
 // -----------------------------------------------------------------------------
 
+MqttStats _mqtt_stats;
+
+MqttStats mqttStats() {
+    return _mqtt_stats;
+}
+
 uint16_t mqttSendRaw(const char* topic, const char* message, bool retain, int qos) {
     if (_mqtt.connected()) {
         const unsigned int packetId {
@@ -1823,9 +1829,17 @@ uint16_t mqttSendRaw(const char* topic, const char* message, bool retain, int qo
         }
 #endif
 
+        // zero means client refused the message, e.g. its queue is full or message is too large
+        if (packetId) {
+            ++_mqtt_stats.published;
+        } else {
+            ++_mqtt_stats.dropped;
+        }
+
         return packetId;
     }
 
+    ++_mqtt_stats.dropped;
     return false;
 }
 
@@ -2276,7 +2290,7 @@ void mqttSetup() {
         wsRegister()
             .onVisible(_mqttWebSocketOnVisible)
             .onData(_mqttWebSocketOnData)
-            .onConnected(_mqttWebSocketOnConnected)
+            .onConnected(mqtt::settings::Prefix, _mqttWebSocketOnConnected)
             .onKeyCheck(_mqttWebSocketOnKeyCheck);
 
         mqttRegister([](unsigned int type, espurna::StringView, espurna::StringView) {
@@ -112,5 +112,13 @@ bool mqttForward();
 
 bool mqttConnected();
 
+// Messages passed to the client since boot, and ones that were not sent
+struct MqttStats {
+    uint32_t published { 0 };
+    uint32_t dropped { 0 };
+};
+
+MqttStats mqttStats();
+
 void mqttDisconnect();
 void mqttSetup();
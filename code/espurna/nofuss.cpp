@@ -12,6 +12,7 @@ Copyright (C) 2016-2019 by Xose Pérez <xose dot perez at gmail dot com>
 
 #include "mdns.h"
 #include "nofuss.h"
+#include "ota.h"
 #include "terminal.h"
 #include "wifi.h"
 #include "ws.h"
@@ -146,6 +147,7 @@ void nofussSetup() {
             DEBUG_MSG_P(PSTR("         File System: %s\n"), NoFUSSClient.getNewFileSystem().c_str());
 
             // Disabling EEPROM rotation to prevent writing to EEPROM after the upgrade
+            otaStart();
             eepromRotate(false);
 
             // Force backup right now, because NoFUSS library will immediatly reset on success
@@ -183,7 +185,7 @@ void nofussSetup() {
     #if WEB_SUPPORT
         wsRegister()
             .onVisible(_nofussWebSocketOnVisible)
-            .onConnected(_nofussWebSocketOnConnected)
+            .onConnected(NofussPrefix, _nofussWebSocketOnConnected)
             .onKeyCheck(_nofussWebSocketOnKeyCheck);
     #endif
 
@@ -857,7 +857,7 @@ void setup() {
 #if WEB_SUPPORT
     wsRegister()
         .onVisible(web::onVisible)
-        .onConnected(web::onConnected)
+        .onConnected(settings::Prefix, web::onConnected)
         .onData(web::onData)
         .onKeyCheck(web::onKeyCheck);
 #endif
@@ -16,6 +16,25 @@ OTA MODULE COMMON FUNCTIONS
 
 #include "libs/PrintString.h"
 
+#include <forward_list>
+
+namespace {
+
+std::forward_list<OtaStartCallback> _ota_start_callbacks;
+
+} // namespace
+
+void otaOnStart(OtaStartCallback callback) {
+    _ota_start_callbacks.push_front(callback);
+}
+
+// Some of the updaters block until they are done, callbacks are executed right away
+void otaStart() {
+    for (auto& callback : _ota_start_callbacks) {
+        callback();
+    }
+}
+
 void otaPrintError() {
 #if DEBUG_SUPPORT
     if (Update.hasError()) {
@@ -24,6 +24,12 @@ bool otaVerifyHeader(uint8_t* data, size_t len);
 void otaProgress(size_t bytes, size_t each);
 void otaProgress(size_t bytes);
 
+// Called by every OTA method right before the updater starts writing into the free sketch space
+// (which may also contain module data, e.g. energy journal sectors with the 1MB flash layout)
+using OtaStartCallback = void(*)();
+void otaOnStart(OtaStartCallback);
+void otaStart();
+
 void otaPrintError();
 bool otaFinalize(size_t size, CustomResetReason reason, bool evenIfRemaining);
 bool otaFinalize(size_t size, CustomResetReason reason);
@@ -39,6 +39,7 @@ void loop() {
 void start() {
     // Disabling EEPROM rotation to prevent writing to EEPROM after the upgrade
     // Because ArduinoOTA is synchronous and will block until either success or error, force backup right now instead of waiting for the next loop()
+    otaStart();
     eepromRotate(false);
     eepromBackup(0);
 
@@ -195,6 +195,7 @@ void onConnect(void* arg, AsyncClient*) {
     #endif
 
     // Disabling EEPROM rotation to prevent writing to EEPROM after the upgrade
+    otaStart();
     eepromRotate(false);
 
     DEBUG_MSG_P(PSTR("[OTA] Downloading %s\n"), ota_client->url.path.c_str());
@@ -116,6 +116,8 @@ void upload(Server& server) {
         }
 
         internal::result.reset();
+        otaStart();
+
         const size_t Available { (ESP.getFreeSketchSpace() - 0x1000ul) & 0xfffff000ul };
         if (!Update.begin(Available, U_FLASH)) {
             server.client().stop();
@@ -55,6 +55,7 @@ namespace {
 void run(WiFiClient* client, const String& url) {
     // Disabling EEPROM rotation to prevent writing to EEPROM after the upgrade
     // Must happen right now, since HTTP updater will block until it's done
+    otaStart();
     eepromRotate(false);
 
     DEBUG_MSG_P(PSTR("[OTA] Downloading %s ...\n"), url.c_str());
@@ -102,6 +102,7 @@ void onFile(AsyncWebServerRequest *request, String filename, size_t index, uint8
         }
 
         // Disabling EEPROM rotation to prevent writing to EEPROM after the upgrade
+        otaStart();
         eepromRotate(false);
 
         DEBUG_MSG_P(PSTR("[UPGRADE] Start: %s\n"), filename.c_str());
@@ -13,11 +13,24 @@ Copyright (C) 2020 by Maxim Prokhorov <prokhorov dot max at outlook dot com>
 #include "prometheus.h"
 
 #include "api.h"
+#include "mqtt.h"
 #include "relay.h"
 #include "sensor.h"
 #include "web.h"
+#include "ws.h"
 
-#include <cmath>
+#include <algorithm>
+#include <chrono>
+
+// Text exposition format, every metric is preceded by its description
+// ref. https://prometheus.io/docs/instrumenting/exposition_formats/
+//
+// # HELP espurna_magnitude Sensor magnitude value
+// # TYPE espurna_magnitude gauge
+// espurna_magnitude{type="power",index="0",unit="W"} 12.5
+//
+// Names and descriptions are kept in flash and printed as-is. Values are either numbers or
+// pre-formatted magnitude strings, nothing is allocated besides the response buffer itself
 
 namespace espurna {
 namespace prometheus {
@@ -32,39 +45,191 @@ constexpr bool sensorSupport() {
     return 1 == SENSOR_SUPPORT;
 }
 
-static_assert(relaySupport() || sensorSupport(), "");
-
 } // namespace
 } // namespace build
 
 namespace {
 
-void handler(AsyncWebServerRequest* request) {
+enum class Type {
+    Counter,
+    Gauge,
+};
+
+struct Metric {
+    StringView name;
+    StringView help;
+    Type type;
+};
+
+void print_flash(Print& out, StringView value) {
+    out.print(FPSTR(value.c_str()));
+}
+
+void describe(Print& out, const Metric& metric) {
+    out.print(F("# HELP "));
+    print_flash(out, metric.name);
+    out.print(' ');
+    print_flash(out, metric.help);
+
+    out.print(F("\n# TYPE "));
+    print_flash(out, metric.name);
+    out.print((metric.type == Type::Counter)
+        ? F(" counter\n")
+        : F(" gauge\n"));
+}
+
+template <typename T>
+void print_value(Print& out, T value) {
+    out.print(value);
+}
+
+void print_value(Print& out, double value) {
+    out.print(value, 6);
+}
+
+template <typename T>
+void sample(Print& out, const Metric& metric, T value) {
+    describe(out, metric);
+    print_flash(out, metric.name);
+    out.print(' ');
+    print_value(out, value);
+    out.print('\n');
+}
+
+void relays(Print& out) {
+    STRING_VIEW_INLINE(Name, "espurna_relay_status");
+    STRING_VIEW_INLINE(Help, "Relay status");
+    const Metric metric{Name, Help, Type::Gauge};
+
+    describe(out, metric);
+    for (size_t index = 0; index < relayCount(); ++index) {
+        print_flash(out, metric.name);
+        out.printf_P(PSTR("{index=\"%u\"} %d\n"),
+            index, relayStatus(index) ? 1 : 0);
+    }
+}
+
+void magnitudes(Print& out) {
+    STRING_VIEW_INLINE(Name, "espurna_magnitude");
+    STRING_VIEW_INLINE(Help, "Sensor magnitude value");
+    const Metric metric{Name, Help, Type::Gauge};
+
+    describe(out, metric);
+    for (size_t index = 0; index < magnitudeCount(); ++index) {
+        const auto value = magnitudeValue(index);
+        if (!value) {
+            continue;
+        }
+
+        // topic is always '<type>/<index>', only the type part is needed
+        const auto type = std::find(value.topic.begin(), value.topic.end(), '/');
+
+        print_flash(out, metric.name);
+        out.print(F("{type=\""));
+        out.write(value.topic.c_str(), std::distance(value.topic.begin(), type));
+        out.printf_P(PSTR("\",index=\"%hhu\",unit=\""), value.index);
+        print_flash(out, magnitudeUnitsView(value.units));
+        out.print(F("\"} "));
+        out.write(value.repr.c_str(), value.repr.length());
+        out.print('\n');
+    }
+}
 
-    // TODO: Add more stuff?
+void device(Print& out) {
+    STRING_VIEW_INLINE(UptimeName, "espurna_uptime_seconds");
+    STRING_VIEW_INLINE(UptimeHelp, "Time since boot");
+    sample(out, Metric{UptimeName, UptimeHelp, Type::Counter},
+        systemUptime().count());
+
+    const auto heap = systemHeapStats();
+
+    STRING_VIEW_INLINE(HeapFreeName, "espurna_heap_free_bytes");
+    STRING_VIEW_INLINE(HeapFreeHelp, "Available heap");
+    sample(out, Metric{HeapFreeName, HeapFreeHelp, Type::Gauge},
+        heap.available);
+
+    STRING_VIEW_INLINE(HeapUsableName, "espurna_heap_usable_bytes");
+    STRING_VIEW_INLINE(HeapUsableHelp, "Largest contiguous block of heap");
+    sample(out, Metric{HeapUsableName, HeapUsableHelp, Type::Gauge},
+        heap.usable);
+
+    STRING_VIEW_INLINE(HeapFragmentationName, "espurna_heap_fragmentation_percent");
+    STRING_VIEW_INLINE(HeapFragmentationHelp, "Heap fragmentation");
+    sample(out, Metric{HeapFragmentationName, HeapFragmentationHelp, Type::Gauge},
+        heap.fragmentation);
+
+    STRING_VIEW_INLINE(LoadAverageName, "espurna_load_average_percent");
+    STRING_VIEW_INLINE(LoadAverageHelp, "Load average");
+    sample(out, Metric{LoadAverageName, LoadAverageHelp, Type::Gauge},
+        systemLoadAverage());
+
+    const auto loop = espurnaLoopStats();
+
+    STRING_VIEW_INLINE(LoopIterationsName, "espurna_loop_iterations_total");
+    STRING_VIEW_INLINE(LoopIterationsHelp, "Main loop iterations");
+    sample(out, Metric{LoopIterationsName, LoopIterationsHelp, Type::Counter},
+        loop.iterations);
+
+    STRING_VIEW_INLINE(LoopTimeName, "espurna_loop_time_seconds_total");
+    STRING_VIEW_INLINE(LoopTimeHelp, "Time spent in the main loop callbacks");
+    sample(out, Metric{LoopTimeName, LoopTimeHelp, Type::Counter},
+        std::chrono::duration<double>(loop.total).count());
+
+    STRING_VIEW_INLINE(LoopMaxName, "espurna_loop_time_max_seconds");
+    STRING_VIEW_INLINE(LoopMaxHelp, "Longest main loop iteration");
+    sample(out, Metric{LoopMaxName, LoopMaxHelp, Type::Gauge},
+        std::chrono::duration<double>(loop.max).count());
+
+    STRING_VIEW_INLINE(RssiName, "espurna_wifi_rssi_dbm");
+    STRING_VIEW_INLINE(RssiHelp, "Wi-Fi signal strength");
+    sample(out, Metric{RssiName, RssiHelp, Type::Gauge},
+        WiFi.RSSI());
+}
+
+#if MQTT_SUPPORT
+void mqtt(Print& out) {
+    const auto stats = mqttStats();
+
+    STRING_VIEW_INLINE(PublishedName, "espurna_mqtt_published_total");
+    STRING_VIEW_INLINE(PublishedHelp, "MQTT messages accepted by the client");
+    sample(out, Metric{PublishedName, PublishedHelp, Type::Counter},
+        stats.published);
+
+    STRING_VIEW_INLINE(DroppedName, "espurna_mqtt_dropped_total");
+    STRING_VIEW_INLINE(DroppedHelp, "MQTT messages that could not be sent");
+    sample(out, Metric{DroppedName, DroppedHelp, Type::Counter},
+        stats.dropped);
+}
+#endif
+
+void websocket(Print& out) {
+    STRING_VIEW_INLINE(ClientsName, "espurna_websocket_clients");
+    STRING_VIEW_INLINE(ClientsHelp, "Connected WebUI clients");
+    sample(out, Metric{ClientsName, ClientsHelp, Type::Gauge},
+        wsClients());
+}
+
+void handler(AsyncWebServerRequest* request) {
     // Note: Response 'stream' backing buffer is customizable. Default is 1460 bytes (see ESPAsyncWebServer.h)
     //       In case printf overflows, memory of CurrentSize+N{overflow} will be allocated to replace
     //       the existing buffer. Previous buffer will be copied into the new and destroyed after that.
-    auto *response = request->beginResponseStream("text/plain");
+    auto *response = request->beginResponseStream(F("text/plain; version=0.0.4"));
 
     if (build::relaySupport()) {
-        for (size_t index = 0; index < relayCount(); ++index) {
-            response->printf_P(PSTR("relay%u %d\n"), index, relayStatus(index) ? 1 : 0);
-        }
+        relays(*response);
     }
 
     if (build::sensorSupport()) {
-        for (size_t index = 0; index < magnitudeCount(); ++index) {
-            auto value = magnitudeValue(index);
-            if (value) {
-                value.topic.replace("/", "");
-                response->printf_P(PSTR("%s %s\n"),
-                    value.topic.c_str(), value.repr.c_str());
-            }
-        }
+        magnitudes(*response);
     }
 
-    response->write('\n');
+    device(*response);
+
+#if MQTT_SUPPORT
+    mqtt(*response);
+#endif
+
+    websocket(*response);
 
     request->send(response);
 }
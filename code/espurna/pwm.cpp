@@ -102,6 +102,7 @@ namespace arduino {
 struct Channel {
     uint8_t pin;
     uint32_t duty;
+    bool changed;
 };
 
 namespace scale {
@@ -191,7 +192,14 @@ void update() {
     // Arduino Core updates pins immediately, forcing delayed update
     // b/c of a weird dependency on ::digitalWrite implementation, explicitly stop PWM
     // before writing either zero or maximum duty and simply set pin to LOW or HIGH
-    for (auto channel : internal::channels) {
+    // Waveform of every pin is handled separately, only touch the ones that were changed
+    for (auto& channel : internal::channels) {
+        if (!channel.changed) {
+            continue;
+        }
+
+        channel.changed = false;
+
         const auto duty_range = range();
         if (channel.duty == duty_range.min) {
             internal::stop(channel.pin);
@@ -217,6 +225,7 @@ bool init(const uint8_t* begin, const uint8_t* end) {
             internal::channels.push_back(Channel{
                 .pin = pin,
                 .duty = 0,
+                .changed = true,
             });
         }
 
@@ -231,8 +240,13 @@ bool init(const uint8_t* begin, const uint8_t* end) {
 }
 
 void duty(size_t channel, uint32_t value) {
-    internal::channels[channel].duty =
-        std::min(driver::pwm::internal::duty_limit, value);
+    value = std::min(driver::pwm::internal::duty_limit, value);
+
+    auto& out = internal::channels[channel];
+    if (out.duty != value) {
+        out.duty = value;
+        out.changed = true;
+    }
 }
 
 void duty(size_t channel, float value) {
@@ -363,8 +377,10 @@ Channels prepare(const uint8_t* begin, const uint8_t* end) {
     return out;
 }
 
+// Duty values are staged by the library and applied together at the start of the next period,
+// so that every channel changes at the same time. Timing table is not computed when nothing changed
 void update() {
-    ::pwm_start();
+    ::pwm_commit();
 }
 
 void duty(uint32_t channel, uint32_t value) {
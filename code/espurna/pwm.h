@@ -31,13 +31,15 @@ PwmRange pwmRange();
 // Number of configured PWM channels
 size_t pwmChannels();
 
-// Update specific channel with raw value (see pwmRange())
+// Stage specific channel raw value (see pwmRange())
+// Output is not changed until pwmUpdate()
 void pwmDuty(size_t channel, uint32_t duty);
 
 // Or, using a percentage value
 void pwmDuty(size_t channel, float duty);
 
-// Apply all channel duty values
+// Apply all staged channel duty values at once
+// Nothing happens when none of the values were changed since the last update
 void pwmUpdate();
 
 // Configure driver. Should be called *before* initializing any pins.
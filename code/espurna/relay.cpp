@@ -144,6 +144,10 @@ constexpr espurna::duration::Milliseconds saveDelay() {
     return espurna::duration::Milliseconds(RELAY_SAVE_DELAY);
 }
 
+constexpr espurna::duration::Milliseconds reportWindow() {
+    return espurna::duration::Milliseconds(RELAY_REPORT_WINDOW);
+}
+
 constexpr size_t dummyCount() {
     return DUMMY_RELAY_COUNT;
 }
@@ -1362,6 +1366,87 @@ RelaySaveTimer _relay_save_timer;
 std::forward_list<RelayStatusCallback> _relay_status_notify;
 std::forward_list<RelayStatusCallback> _relay_status_change;
 
+// When enabled, status changes are delivered to the subscribers only after the window expires,
+// starting from the first change. Intermediate ones (e.g. flood of ON / OFF requests) are dropped
+// and counted instead. Relay returning back to the status it had before the window is still
+// delivered as two changes, so the short pulse is visible to the subscribers
+struct RelayReportCoalescer {
+    using TimeSource = espurna::time::CoreClock;
+
+    RelayReportCoalescer() = delete;
+    explicit RelayReportCoalescer(TimeSource::duration window) :
+        _window(window)
+    {}
+
+    bool enabled() const {
+        return _window.count() > 0;
+    }
+
+    void push(size_t id, bool status) {
+        if (_pending[id]) {
+            ++_suppressed;
+            _repeated.set(id);
+        } else {
+            if (_pending.none()) {
+                _since = TimeSource::now();
+            }
+
+            _first.set(id, status);
+        }
+
+        _pending.set(id);
+        _status.set(id, status);
+    }
+
+    template <typename Deliver, typename Done>
+    void flush(size_t size, Deliver&& deliver, Done&& done) {
+        if (_pending.none() || (TimeSource::now() - _since < _window)) {
+            return;
+        }
+
+        // callbacks are allowed to change relays, which would start the next window
+        const auto pending = _pending;
+        const auto repeated = _repeated;
+        const auto first = _first;
+        const auto status = _status;
+        _pending.reset();
+        _repeated.reset();
+
+        // relays might've been removed while waiting
+        for (size_t id = 0; id < std::min(size, pending.size()); ++id) {
+            if (!pending[id]) {
+                continue;
+            }
+
+            // every change flips the status, first one is always different from the status before the window
+            if (repeated[id] && (first[id] != status[id])) {
+                --_suppressed;
+                deliver(id, first[id]);
+            }
+
+            deliver(id, status[id]);
+            done(id);
+        }
+    }
+
+    uint32_t suppressed() const {
+        return _suppressed;
+    }
+
+private:
+    TimeSource::duration _window;
+    TimeSource::time_point _since;
+
+    RelayMask _pending;
+    RelayMask _repeated;
+    RelayMask _first;
+    RelayMask _status;
+
+    uint32_t _suppressed { 0 };
+};
+
+RelayReportCoalescer _relay_report { espurna::relay::build::reportWindow() };
+
 #if WEB_SUPPORT
 
 bool _relay_report_ws { false };
@@ -2138,6 +2223,242 @@ bool relayStatusTarget(size_t id) {
     return _relays[id].target_status;
 }
 
+uint32_t relayReportSuppressed() {
+    return _relay_report.suppressed();
+}
+
+namespace {
+
+static_assert(RelaysMax <= (sizeof(RelayBatch::mask) * 8), "");
+
+RelayMask _relayMaskAll() {
+    RelayMask out;
+    for (size_t id = 0; id < _relays.size(); ++id) {
+        out.set(id);
+    }
+
+    return out;
+}
+
+// Sync mode is applied to the batch as a whole, instead of the usual relay-by-relay
+// resolution. Resulting mask includes every relay that has to be changed.
+// Batch is rejected when it conflicts with the sync mode or some relay is locked
+bool _relayBatchResolve(RelayMask& mask, RelayMask& status) {
+    const auto all = _relayMaskAll();
+    if ((mask & ~all).any()) {
+        return false;
+    }
+
+    status &= mask;
+
+    const auto on = mask & status;
+    const auto off = mask & ~status;
+
+    switch (_relay_sync_mode) {
+    case RelaySync::None:
+        break;
+
+    case RelaySync::All:
+        if (on.any() && off.any()) {
+            return false;
+        }
+
+        if (mask.any()) {
+            mask = all;
+            status = on.any() ? all : RelayMask{};
+        }
+        break;
+
+    case RelaySync::First:
+        if (mask[0]) {
+            const bool first { status[0] };
+            if (first ? off.any() : on.any()) {
+                return false;
+            }
+
+            mask = all;
+            status = first ? all : RelayMask{};
+        }
+        break;
+
+    case RelaySync::ZeroOrOne:
+    case RelaySync::JustOne:
+        if (on.count() > 1) {
+            return false;
+        }
+
+        if (on.any()) {
+            mask = all;
+            status = on;
+        } else if (_relay_sync_mode == RelaySync::JustOne) {
+            bool any { false };
+            for (size_t id = 0; id < _relays.size(); ++id) {
+                if (!mask[id] && _relays[id].target_status) {
+                    any = true;
+                    break;
+                }
+            }
+
+            if (!any) {
+                return false;
+            }
+        }
+        break;
+    }
+
+    for (size_t id = 0; id < _relays.size(); ++id) {
+        const auto lock = _relays[id].lock;
+        if (mask[id] && (lock != RelayLock::None) && ((lock == RelayLock::On) != status[id])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool _relayStatusBatch(RelayMask mask, RelayMask status, bool report, bool group_report) {
+    const auto requested = mask;
+    if (!_relayBatchResolve(mask, status)) {
+        DEBUG_MSG_P(PSTR("[RELAY] Batch %s rejected\n"),
+            RelayMaskHelper(requested).toString().c_str());
+        return false;
+    }
+
+    // Sync was already resolved above, prevent relayStatus(...) from doing it again
+    auto lock = espurna::ReentryLock{ _relay_sync_reent };
+    if (!lock) {
+        return false;
+    }
+
+    const bool interlock {
+        (_relay_sync_mode == RelaySync::ZeroOrOne)
+     || (_relay_sync_mode == RelaySync::JustOne) };
+
+    // Turning OFF goes first, so any relay turning ON could wait for the interlock delay
+    for (size_t id = 0; id < _relays.size(); ++id) {
+        if (mask[id] && !status[id]) {
+            _relayStatus(id, false, report, group_report);
+        }
+    }
+
+    for (size_t id = 0; id < _relays.size(); ++id) {
+        if (!mask[id] || !status[id]) {
+            continue;
+        }
+
+        if (interlock) {
+            for (size_t other = 0; other < _relays.size(); ++other) {
+                if ((other != id) && _relays[other].current_status) {
+                    _relaySyncRelaysDelay(other, id);
+                }
+            }
+        }
+
+        _relayStatus(id, true, report, group_report);
+    }
+
+    if (interlock && mask.any()) {
+        _relaySyncLockAll();
+    }
+
+    return true;
+}
+
+// <TARGET>:<STATUS>[,<TARGET>:<STATUS>...]
+// Target is either relay ID or a binary mask with the 0b prefix, where bit N is relay #N.
+// Status is any of the relay payloads, toggle is resolved from the current target status
+bool _relayParseBatchTarget(espurna::StringView value, RelayMask& out) {
+    if ((value.length() > 2) && (value[0] == '0') && (value[1] == 'b')) {
+        const auto result = parseUnsigned(value);
+        if (!result.ok) {
+            return false;
+        }
+
+        out = RelayMask(result.value);
+        return out.any() && !(out & ~_relayMaskAll()).any();
+    }
+
+    size_t id;
+    if (!_relayTryParseId(value, id)) {
+        return false;
+    }
+
+    out.reset();
+    out.set(id);
+
+    return true;
+}
+
+bool _relayParseBatch(espurna::StringView payload, RelayMask& mask, RelayMask& status) {
+    mask.reset();
+    status.reset();
+
+    espurna::SplitStringView split(payload, ',');
+    while (split.next()) {
+        const auto entry = split.current();
+
+        const auto delim = std::find(entry.begin(), entry.end(), ':');
+        if (delim == entry.end()) {
+            return false;
+        }
+
+        RelayMask targets;
+        if (!_relayParseBatchTarget(espurna::StringView(entry.begin(), delim), targets)) {
+            return false;
+        }
+
+        const auto value = relayParsePayload(espurna::StringView(delim + 1, entry.end()));
+        if (value == PayloadStatus::Unknown) {
+            return false;
+        }
+
+        for (size_t id = 0; id < _relays.size(); ++id) {
+            if (!targets[id]) {
+                continue;
+            }
+
+            mask.set(id);
+            status.set(id,
+                (value == PayloadStatus::Toggle)
+                    ? !_relays[id].target_status
+                    : (value == PayloadStatus::On));
+        }
+    }
+
+    return mask.any();
+}
+
+[[gnu::unused]]
+bool _relayHandleBatchPayload(espurna::StringView payload) {
+    RelayMask mask;
+    RelayMask status;
+    if (!_relayParseBatch(payload, mask, status)) {
+        return false;
+    }
+
+#if MQTT_SUPPORT
+    return _relayStatusBatch(mask, status, mqttForward(), true);
+#else
+    return _relayStatusBatch(mask, status, false, true);
+#endif
+}
+
+} // namespace
+
+bool relayStatusBatch(RelayBatch batch, bool report, bool group_report) {
+    return _relayStatusBatch(
+        RelayMask(batch.mask), RelayMask(batch.status),
+        report, group_report);
+}
+
+bool relayStatusBatch(RelayBatch batch) {
+#if MQTT_SUPPORT
+    return relayStatusBatch(batch, mqttForward(), true);
+#else
+    return relayStatusBatch(batch, false, true);
+#endif
+}
+
 namespace {
 
 RelayMaskHelper _relayMaskCurrent() {
@@ -2402,6 +2723,21 @@ void _relayWebSocketUpdate(JsonObject& root) {
     });
 }
 
+// Same as 'relayState', status and lock packed together
+espurna::web::ws::BinaryFrame _relayWebSocketBinary() {
+    using espurna::web::ws::BinaryFrame;
+
+    BinaryFrame out(BinaryFrame::Type::Relays, 1 + _relays.size());
+    out.u8(_relays.size());
+
+    for (const auto& relay : _relays) {
+        out.u8((relay.target_status ? 1 : 0)
+            | (static_cast<uint8_t>(relay.lock) << 1));
+    }
+
+    return out;
+}
+
 void _relayWebSocketSendRelays(JsonObject& root) {
     if (!_relays.size()) {
         return;
@@ -2452,7 +2788,7 @@ void _relayWebSocketOnAction(uint32_t, const char* action, JsonObject& data) {
 
 void _relayWsReport() {
     if (_relay_report_ws) {
-        wsPost(_relayWebSocketUpdate);
+        wsPostTelemetry(_relayWebSocketUpdate, _relayWebSocketBinary);
         _relay_report_ws = false;
     }
 }
@@ -2517,6 +2853,17 @@ void relaySetupAPI() {
         nullptr
     );
 
+    // Must be registered before the generic relay/+, which would not accept it as ID
+    apiRegister(F(MQTT_TOPIC_RELAY "/batch"),
+        [](ApiRequest& request) {
+            request.send(_relayMaskCurrent().toString());
+            return true;
+        },
+        [](ApiRequest& request) {
+            return _relayHandleBatchPayload(request.param(F("value")));
+        }
+    );
+
     apiRegister(F(MQTT_TOPIC_RELAY "/+"),
         [](ApiRequest& request) {
             return _relayApiTryHandle(request, [&](size_t id) {
@@ -2717,14 +3064,12 @@ void _relayMqttSubscribeCustomTopics() {
     }
 }
 
-void _relayMqttPublishCustomTopic(size_t id) {
+void _relayMqttPublishCustomTopic(size_t id, PayloadStatus status) {
     const auto topic = espurna::relay::settings::mqttTopicPub(id);
     if (!topic.length()) {
         return;
     }
 
-    auto status = _relayPayloadStatus(id);
-
     auto mode = espurna::relay::settings::mqttTopicMode(id);
     if (mode == RelayMqttTopicMode::Inverse) {
         status = _relayInvertStatus(status);
@@ -2733,18 +3078,23 @@ void _relayMqttPublishCustomTopic(size_t id) {
     mqttSendRaw(topic.c_str(), relayPayload(status).begin());
 }
 
-void _relayMqttReport(size_t id) {
+// Coalesced reports may publish status that is different from the current one
+void _relayMqttReport(size_t id, PayloadStatus status) {
     if (_relays[id].report) {
-        _relays[id].report = false;
-        mqttSend(MQTT_TOPIC_RELAY, id, relayPayload(_relayPayloadStatus(id)).c_str()); // TODO FIXED LENGTH
+        mqttSend(MQTT_TOPIC_RELAY, id, relayPayload(status).c_str()); // TODO FIXED LENGTH
     }
 
     if (_relays[id].group_report) {
-        _relays[id].group_report = false;
-        _relayMqttPublishCustomTopic(id);
+        _relayMqttPublishCustomTopic(id, status);
     }
 }
 
+void _relayMqttReport(size_t id) {
+    _relayMqttReport(id, _relayPayloadStatus(id));
+    _relays[id].report = false;
+    _relays[id].group_report = false;
+}
+
 void _relayMqttReportAll() {
     for (unsigned int id=0; id < _relays.size(); id++) {
         mqttSend(MQTT_TOPIC_RELAY, id, relayPayload(_relayPayloadStatus(id)).c_str()); // TODO FIXED LENGTH
@@ -2861,6 +3211,7 @@ struct RelayMqttTopicHandler {
     Handler handler;
 };
 
+PROGMEM_STRING(MqttTopicRelayBatch, MQTT_TOPIC_RELAY "/batch");
 PROGMEM_STRING(MqttTopicRelay, MQTT_TOPIC_RELAY);
 PROGMEM_STRING(MqttTopicPulse, MQTT_TOPIC_PULSE);
 PROGMEM_STRING(MqttTopicTimer, MQTT_TOPIC_TIMER);
@@ -2890,6 +3241,12 @@ void relayMQTTCallback(unsigned int type, espurna::StringView topic, espurna::St
     if (type == MQTT_MESSAGE_EVENT) {
         const auto t = mqttMagnitude(topic);
 
+        // Already subscribed through relay/+
+        if (t.equals(MqttTopicRelayBatch)) {
+            _relayHandleBatchPayload(payload);
+            return;
+        }
+
         for (const auto pair: RelayMqttTopicHandlers) {
             if (t.startsWith(pair.topic)) {
                 size_t id;
@@ -2962,6 +3319,8 @@ PROGMEM_STRING(RelayCommand, "RELAY");
 static void _relayCommand(::terminal::CommandContext&& ctx) {
     if (ctx.argv.size() == 1) {
         _relayPrint(ctx.output, 0, _relays.size());
+        ctx.output.printf_P(PSTR("suppressed %u status change(s)\n"),
+            relayReportSuppressed());
         terminalOK(ctx);
         return;
     }
@@ -2991,6 +3350,39 @@ static void _relayCommand(::terminal::CommandContext&& ctx) {
     terminalOK(ctx);
 }
 
+PROGMEM_STRING(RelayBatchCommand, "RELAY.BATCH");
+
+static void _relayCommandBatch(::terminal::CommandContext&& ctx) {
+    if (ctx.argv.size() < 2) {
+        terminalError(ctx, F("RELAY.BATCH <ID|MASK>:<STATUS> [<ID|MASK>:<STATUS>...]"));
+        return;
+    }
+
+    RelayMask mask;
+    RelayMask status;
+
+    for (size_t index = 1; index < ctx.argv.size(); ++index) {
+        RelayMask entry_mask;
+        RelayMask entry_status;
+        if (!_relayParseBatch(ctx.argv[index], entry_mask, entry_status)) {
+            terminalError(ctx, F("Invalid batch"));
+            return;
+        }
+
+        mask |= entry_mask;
+        status &= ~entry_mask;
+        status |= entry_status;
+    }
+
+    if (!_relayStatusBatch(mask, status, false, true)) {
+        terminalError(ctx, F("Batch conflicts with the relay sync mode or lock"));
+        return;
+    }
+
+    _relayPrint(ctx.output, 0, _relays.size());
+    terminalOK(ctx);
+}
+
 PROGMEM_STRING(PulseCommand, "PULSE");
 
 static void _relayCommandDumpTimers(::terminal::CommandContext&& ctx) {
@@ -3147,6 +3539,7 @@ static void _relayCommandUnlock(::terminal::CommandContext&& ctx) {
 
 static constexpr ::terminal::Command RelayCommands[] PROGMEM {
     {RelayCommand, _relayCommand},
+    {RelayBatchCommand, _relayCommandBatch},
     {PulseCommand, _relayCommandPulse},
     {TimerCommand, _relayCommandTimer},
     {LockCommand, _relayCommandLock},
@@ -3165,19 +3558,37 @@ void _relayCommandsSetup() {
 
 namespace {
 
-void _relayReport(size_t id [[gnu::unused]], bool status [[gnu::unused]]) {
+void _relayReportDeliver(size_t id [[gnu::unused]], bool status [[gnu::unused]]) {
     for (auto& change : _relay_status_change) {
         change(id, status);
     }
 #if MQTT_SUPPORT
-    _relayMqttReport(id);
+    _relayMqttReport(id, status ? PayloadStatus::On : PayloadStatus::Off);
 #endif
 #if WEB_SUPPORT
     _relayScheduleWsReport();
 #endif
 }
 
+void _relayReportDone(size_t id) {
+    _relays[id].report = false;
+    _relays[id].group_report = false;
+}
+
+void _relayReport(size_t id, bool status) {
+    if (!_relay_report.enabled()) {
+        _relayReportDeliver(id, status);
+        _relayReportDone(id);
+        return;
+    }
+
+    _relay_report.push(id, status);
+}
+
 void _relayReport() {
+    _relay_report.flush(_relays.size(),
+        _relayReportDeliver, _relayReportDone);
+
 #if WEB_SUPPORT
     _relayWsReport();
 #endif
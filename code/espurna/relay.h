@@ -50,6 +50,20 @@ bool relayStatus(size_t id, bool status);
 bool relayStatus(size_t id);
 bool relayStatusTarget(size_t id);
 
+// Multiple relays changed at once, as a single request. Sync mode and locks apply
+// to the batch as a whole, nothing is changed when the batch conflicts with either
+struct RelayBatch {
+    uint32_t mask { 0 };        // bit N is set when relay #N is changed
+    uint32_t status { 0 };      // bit N is the requested status of relay #N
+};
+
+bool relayStatusBatch(RelayBatch, bool report, bool group_report);
+bool relayStatusBatch(RelayBatch);
+
+// Number of intermediate status changes that were never reported to the subscribers
+// (see relayOnStatusChange), since they were replaced by the following change
+uint32_t relayReportSuppressed();
+
 void relayToggle(size_t id, bool report, bool group_report);
 void relayToggle(size_t id);
 
@@ -1473,10 +1473,10 @@ void rfbSetup() {
 #if WEB_SUPPORT
     wsRegister()
 #if RELAY_SUPPORT
-        .onData(_rfbWebSocketOnData)
+        .onConnected(espurna::rfbridge::settings::Prefix, _rfbWebSocketOnData)
         .onAction(_rfbWebSocketOnAction)
 #endif
-        .onConnected(_rfbWebSocketOnConnected)
+        .onConnected(espurna::rfbridge::settings::Prefix, _rfbWebSocketOnConnected)
         .onVisible(_rfbWebSocketOnVisible)
         .onKeyCheck(_rfbWebSocketOnKeyCheck);
 #endif
@@ -1106,7 +1106,7 @@ namespace sensor {
 void updateVariables(const espurna::sensor::Value& value) {
     static_assert(std::is_same<decltype(value.value), rpn_float>::value, "");
 
-    auto topic = value.topic;
+    auto topic = value.topic.toString();
     topic.replace("/", "");
 
     rpn_variable_set(internal::context,
@@ -1350,7 +1350,7 @@ void setup() {
 #if WEB_SUPPORT
     wsRegister()
         .onVisible(web::onVisible)
-        .onConnected(web::onConnected)
+        .onConnected(settings::Prefix, web::onConnected)
         .onKeyCheck(web::onKeyCheck);
 #endif
 
@@ -1551,7 +1551,7 @@ void onConnected(JsonObject& root){
 void setup() {
     wsRegister()
         .onVisible(onVisible)
-        .onConnected(onConnected)
+        .onConnected(settings::Prefix, onConnected)
         .onKeyCheck(onKey);
 }
 
@@ -14,10 +14,12 @@ Copyright (C) 2020-2022 by Maxim Prokhorov <prokhorov dot max at outlook dot com
 #include "sensor.h"
 
 #include "api.h"
+#include "datetime.h"
 #include "domoticz.h"
 #include "i2c.h"
 #include "mqtt.h"
 #include "ntp.h"
+#include "ota.h"
 #include "relay.h"
 #include "terminal.h"
 #include "thingspeak.h"
@@ -225,13 +227,8 @@ Copyright (C) 2020-2022 by Maxim Prokhorov <prokhorov dot max at outlook dot com
     #include "sensors/PZEM004TV30Sensor.h"
 #endif
 
-#include "filters/LastFilter.h"
-#include "filters/MaxFilter.h"
-#include "filters/MedianFilter.h"
-#include "filters/MinFilter.h"
-#include "filters/MovingAverageFilter.h"
-#include "filters/SumFilter.h"
-
+#include "sensor_common.ipp"
+#include "sensor_journal.ipp"
 #include "sensor_emon.ipp"
 
 //--------------------------------------------------------------------------------
@@ -310,22 +307,6 @@ void forEachError(T&& callback) {
     }
 }
 
-// minimal subset of Value for internal use
-struct ValuePair {
-    double value;
-    Unit units;
-};
-
-constexpr ValuePair make_value_pair(double value, Unit units) {
-    return ValuePair{
-        .value = value,
-        .units = units,
-    };
-}
-
-constexpr auto DefaultValuePair =
-    make_value_pair(Value::Unknown, Unit::None);
-
 } // namespace
 
 namespace {
@@ -364,8 +345,6 @@ private:
     BaseSensor* _ptr;
 };
 
-using BaseFilterPtr = std::unique_ptr<BaseFilter>;
-
 class Magnitude {
 private:
     static unsigned char _counts[MAGNITUDE_MAX];
@@ -375,6 +354,8 @@ public:
         return _counts[type];
     }
 
+    static bool indexed(unsigned char type);
+
     Magnitude() = delete;
 
     Magnitude(const Magnitude&) = delete;
@@ -446,337 +427,8 @@ bool isAnalog(BaseSensorPtr sensor) {
     return sensor->kind() == BaseAnalogSensor::Kind;
 }
 
-namespace convert {
-namespace temperature {
-
-struct Base {
-    constexpr Base() = default;
-    constexpr explicit Base(double value) :
-        _value(value)
-    {}
-
-    constexpr double value() const {
-        return _value;
-    }
-
-    constexpr operator double() const {
-        return _value;
-    }
-
-private:
-    double _value { 0.0 };
-};
-
-struct Kelvin : public Base {
-    using Base::Base;
-};
-
-struct Farenheit : public Base {
-    using Base::Base;
-};
-
-struct Celcius : public Base {
-    using Base::Base;
-};
-
-static constexpr Celcius AbsoluteZero { -273.15 };
-
-namespace internal {
-
-template <typename To, typename From, typename Same = void>
-struct Converter {
-};
-
-template <typename To, typename From>
-struct Converter<To, From, typename std::enable_if<std::is_same<To, From>::value>::type> {
-    static constexpr To convert(To value) {
-        return value;
-    }
-};
-
-static constexpr double celcius_to_kelvin(double celcius) {
-    return celcius - AbsoluteZero;
-}
-
-static constexpr double celcius_to_farenheit(double celcius) {
-    return (celcius * (9.0 / 5.0)) + 32.0;
-}
-
-static constexpr double farenheit_to_celcius(double farenheit) {
-    return (farenheit - 32.0) * (5.0 / 9.0);
-}
-
-static constexpr double farenheit_to_kelvin(double farenheit) {
-    return celcius_to_kelvin(farenheit_to_celcius(farenheit));
-}
-
-static constexpr double kelvin_to_celcius(double kelvin) {
-    return kelvin + AbsoluteZero;
-}
-
-static constexpr double kelvin_to_farenheit(double kelvin) {
-    return celcius_to_farenheit(kelvin_to_celcius(kelvin));
-}
-
-static_assert(celcius_to_kelvin(kelvin_to_celcius(0.0)) == 0.0, "");
-static_assert(celcius_to_farenheit(farenheit_to_celcius(0.0)) == 0.0, "");
-static_assert(farenheit_to_kelvin(kelvin_to_farenheit(0.0)) == 0.0, "");
-static_assert(farenheit_to_celcius(celcius_to_farenheit(0.0)) == 0.0, "");
-static_assert(kelvin_to_celcius(celcius_to_kelvin(0.0)) == 0.0, "");
-
-// ref. https://en.cppreference.com/w/cpp/types/numeric_limits/epsilon
-static constexpr bool almost_equal(double lhs, double rhs, int ulp) {
-    // the machine epsilon has to be scaled to the magnitude of the values used
-    // and multiplied by the desired precision in ULPs (units in the last place)
-    return __builtin_fabs(lhs - rhs) <= std::numeric_limits<double>::epsilon() * __builtin_fabs(lhs + rhs) * ulp
-        // unless the result is subnormal
-        || __builtin_fabs(lhs - rhs) < std::numeric_limits<double>::min();
-}
-
-static_assert(almost_equal(10.0, kelvin_to_farenheit(farenheit_to_kelvin(10.0)), 3), "");
-
-template <>
-struct Converter<Celcius, Kelvin> {
-    static constexpr Celcius convert(Kelvin kelvin) {
-        return Celcius{ kelvin_to_celcius(kelvin.value()) };
-    }
-};
-
-template <>
-struct Converter<Farenheit, Kelvin> {
-    static constexpr Farenheit convert(Kelvin kelvin) {
-        return Farenheit{ kelvin_to_farenheit(kelvin.value()) };
-    }
-};
-
-template <>
-struct Converter<Kelvin, Celcius> {
-    static constexpr Kelvin convert(Celcius celcius) {
-        return Kelvin{ celcius_to_kelvin(celcius.value()) };
-    }
-};
-
-template <>
-struct Converter<Farenheit, Celcius> {
-    static constexpr Farenheit convert(Celcius celcius) {
-        return Farenheit{ celcius_to_farenheit(celcius.value()) };
-    }
-};
-
-template <>
-struct Converter<Kelvin, Farenheit> {
-    static constexpr Kelvin convert(Farenheit farenheit) {
-        return Kelvin{ farenheit_to_kelvin(farenheit.value()) };
-    }
-};
-
-template <>
-struct Converter<Celcius, Farenheit> {
-    static constexpr Celcius convert(Farenheit farenheit) {
-        return Celcius{ farenheit_to_celcius(farenheit.value()) };
-    }
-};
-
-// just some sanity checks. note that floating point will not always produce exact results
-// (and it might not be a good idea to actually have anything compare with the Farenheit one)
-
-static_assert(Converter<Kelvin, Kelvin>::convert(Kelvin{0.0}) == Kelvin{0.0}, "");
-static_assert(Converter<Kelvin, Celcius>::convert(AbsoluteZero) == Kelvin{0.0}, "");
-static_assert(Converter<Celcius, Celcius>::convert(AbsoluteZero) == AbsoluteZero, "");
-static_assert(Converter<Celcius, Kelvin>::convert(Kelvin{0.0}) == AbsoluteZero, "");
-
-} // namespace internal
-
-template <typename To, typename From>
-constexpr To unit_cast(From value) {
-    return internal::Converter<To, From>::convert(value);
-}
-
-static_assert(unit_cast<Kelvin>(AbsoluteZero).value() == 0.0, "");
-static_assert(unit_cast<Celcius>(AbsoluteZero).value() == AbsoluteZero.value(), "");
-
-constexpr bool supported(Unit unit) {
-    return (unit == Unit::Celcius)
-        || (unit == Unit::Kelvin)
-        || (unit == Unit::Farenheit);
-}
-
-// since the outside api only works with the enumeration, make sure to cast it to our types for conversion
-// a table like this could've also worked
-// > {Unit(from), Unit(to), Converter(double(*)(double))}
-// but, it is ~0.6KiB vs. ~0.1KiB for this one. plus, some obstacles with c++11 implementation
-// although, there may be a way to make this cheaper in both compile-time and runtime
-
-// attempt to convert the input value from one unit to the other
-// will return the input value when units match or there's no known conversion
-constexpr double convert(double value, Unit from, Unit to) {
-#define UNIT_CAST(LHS, RHS) \
-    ((from == Unit::LHS) && (to == Unit::RHS)) \
-        ? (unit_cast<RHS, LHS>(LHS{value})) : \
-    ((from == Unit::RHS) && (to == Unit::LHS)) \
-        ? (unit_cast<LHS, RHS>(RHS{value}))
-
-     return UNIT_CAST(Kelvin, Celcius) :
-        UNIT_CAST(Kelvin, Farenheit) :
-        UNIT_CAST(Celcius, Farenheit) : value;
-
-#undef UNIT_CAST
-}
-
-} // namespace temperature
-
-// right now, limited to plain and kilo values
-// (since we mostly care about a fairly small values)
-// type conversion should only work for related types
-namespace metric {
-
-template <typename __Ratio>
-struct Base {
-    using Type = double;
-    using Ratio = __Ratio;
-
-    constexpr Base() = default;
-    constexpr explicit Base(Type value) :
-        _value(value)
-    {}
-
-    constexpr Type value() const {
-        return _value;
-    }
-
-    constexpr operator Type() const {
-        return _value;
-    }
-
-private:
-    Type _value { 0.0 };
-};
-
-template <typename To, typename From>
-struct convertible_base : std::false_type {
-};
-
-template <typename To, typename From>
-constexpr bool is_convertible_base() {
-    return std::is_same<To, From>::value
-        || std::is_base_of<std::true_type, convertible_base<To, From>>::value
-        || std::is_base_of<std::true_type, convertible_base<From, To>>::value;
-}
-
-template <typename To, typename From>
-using is_convertible = std::enable_if<is_convertible_base<To, From>()>;
-
-template <typename To, typename From,
-          typename Divide = std::ratio_divide<typename From::Ratio, typename To::Ratio>,
-          typename = typename is_convertible<To, From>::type>
-constexpr To unit_cast(From value) {
-    return To(value.value()
-            * static_cast<typename To::Type>(Divide::num)
-            / static_cast<typename To::Type>(Divide::den));
-}
-
-struct Watt : public Base<std::ratio<1, 1>> {
-    using Base::Base;
-};
-
-struct Kilowatt : public Base<std::ratio<1000, 1>> {
-    using Base::Base;
-};
-
-template <>
-struct convertible_base<Watt, Kilowatt> : std::true_type {
-};
-
-struct Voltampere : public Base<std::ratio<1, 1>> {
-    using Base::Base;
-};
-
-struct Kilovoltampere : public Base<std::ratio<1000, 1>> {
-    using Base::Base;
-};
-
-template <>
-struct convertible_base<Voltampere, Kilovoltampere> : std::true_type {
-};
-
-struct VoltampereReactive : public Base<std::ratio<1, 1>> {
-    using Base::Base;
-};
-
-struct KilovoltampereReactive : public Base<std::ratio<1000, 1>> {
-    using Base::Base;
-};
-
-template <>
-struct convertible_base<VoltampereReactive, KilovoltampereReactive> : std::true_type {
-};
-
-struct WattSecond : public Base<std::ratio<1, 1>> {
-    using Base::Base;
-};
-
-using Joule = WattSecond;
-
-struct KilowattHour : public Base<std::ratio<3600000, 1>> {
-    using Base::Base;
-};
-
-template <>
-struct convertible_base<WattSecond, KilowattHour> : std::true_type {
-};
-
-static_assert(is_convertible_base<Voltampere, Kilovoltampere>(), "");
-static_assert(is_convertible_base<Kilovoltampere, Voltampere>(), "");
-
-static_assert(!is_convertible_base<KilovoltampereReactive, Voltampere>(), "");
-static_assert(is_convertible_base<Joule, WattSecond>(), "");
-
-static_assert(unit_cast<Joule>(KilowattHour{0.02}) == 72000.0, "");
-static_assert(unit_cast<Joule>(KilowattHour{3.611111111111111e-05}) == 130.0, "");
-static_assert(unit_cast<KilowattHour>(Joule{1080000.0}) == 0.3, "");
-static_assert(unit_cast<KilowattHour>(Joule{12348000.0}) == 3.43, "");
-static_assert(unit_cast<VoltampereReactive>(KilovoltampereReactive{1234.0}) == 1234000.0, "");
-
-constexpr bool supported(Unit unit) {
-    return (unit == Unit::Voltampere)
-        || (unit == Unit::Kilovoltampere)
-        || (unit == Unit::VoltampereReactive)
-        || (unit == Unit::KilovoltampereReactive)
-        || (unit == Unit::Watt)
-        || (unit == Unit::Kilowatt)
-        || (unit == Unit::Joule)
-        || (unit == Unit::WattSecond)
-        || (unit == Unit::KilowattHour);
-}
-
-// Here we only care about the direct counterparts
-// Plus, we still don't enforce supported() at compile time,
-// only safeguard is unit_cast<> failing for 'incompatible' base types
-
-constexpr double convert(double value, Unit from, Unit to) {
-#define UNIT_CAST(LHS, RHS) \
-    ((from == Unit::LHS) && (to == Unit::RHS)) \
-        ? (unit_cast<RHS, LHS>(LHS{value})) : \
-    ((from == Unit::RHS) && (to == Unit::LHS)) \
-        ? (unit_cast<LHS, RHS>(RHS{value}))
-
-    return UNIT_CAST(Watt, Kilowatt) :
-        UNIT_CAST(Voltampere, Kilovoltampere) :
-        UNIT_CAST(VoltampereReactive, KilovoltampereReactive) :
-        UNIT_CAST(Joule, KilowattHour) :
-        UNIT_CAST(WattSecond, KilowattHour) : value;
-
-#undef UNIT_CAST
-}
-
-} // namespace metric
-} // namespace convert
-
 namespace build {
 
-constexpr double DefaultMinDelta { 0.0 };
-constexpr double DefaultMaxDelta { 0.0 };
-
 constexpr espurna::duration::Seconds initInterval() {
     return espurna::duration::Seconds(SENSOR_INIT_INTERVAL);
 }
@@ -809,6 +461,10 @@ constexpr bool useIndex() {
 
 } // namespace build
 
+bool Magnitude::indexed(unsigned char type) {
+    return build::useIndex() || (_counts[type] > 1);
+}
+
 namespace settings {
 namespace filters {
 
@@ -998,6 +654,7 @@ PROGMEM_STRING(ZeroThreshold, "ZeroThreshold");
 
 PROGMEM_STRING(Mains, "Mains");
 PROGMEM_STRING(Reference, "Reference");
+PROGMEM_STRING(FixedPoint, "FixedPoint");
 
 PROGMEM_STRING(Total, "Total");
 
@@ -1266,15 +923,6 @@ static constexpr double correction(unsigned char type) {
 
 } // namespace build
 
-String format(double value, unsigned char decimals) {
-    // XXX: dtostrf only handles basic floating point values and will never produce scientific notation
-    //      ensure decimals is within some sane limit and the actual value never goes above this buffer size
-    char buffer[64];
-    dtostrf(value, 1, decimals, buffer);
-
-    return buffer;
-}
-
 String format(const Magnitude& magnitude, double value) {
     return format(value, magnitude.decimals);
 }
@@ -1408,144 +1056,13 @@ String name(unsigned char type) {
 }
 
 String topic(unsigned char type) {
-    const char* result = PSTR("unknown");
-
-    switch (type) {
-    case MAGNITUDE_TEMPERATURE:
-        result = PSTR("temperature");
-        break;
-    case MAGNITUDE_HUMIDITY:
-        result = PSTR("humidity");
-        break;
-    case MAGNITUDE_PRESSURE:
-        result = PSTR("pressure");
-        break;
-    case MAGNITUDE_CURRENT:
-        result = PSTR("current");
-        break;
-    case MAGNITUDE_VOLTAGE:
-        result = PSTR("voltage");
-        break;
-    case MAGNITUDE_POWER_ACTIVE:
-        result = PSTR("power");
-        break;
-    case MAGNITUDE_POWER_APPARENT:
-        result = PSTR("apparent");
-        break;
-    case MAGNITUDE_POWER_REACTIVE:
-        result = PSTR("reactive");
-        break;
-    case MAGNITUDE_POWER_FACTOR:
-        result = PSTR("factor");
-        break;
-    case MAGNITUDE_ENERGY:
-        result = PSTR("energy");
-        break;
-    case MAGNITUDE_ENERGY_DELTA:
-        result = PSTR("energy_delta");
-        break;
-    case MAGNITUDE_ANALOG:
-        result = PSTR("analog");
-        break;
-    case MAGNITUDE_DIGITAL:
-        result = PSTR("digital");
-        break;
-    case MAGNITUDE_EVENT:
-        result = PSTR("event");
-        break;
-    case MAGNITUDE_PM1DOT0:
-        result = PSTR("pm1dot0");
-        break;
-    case MAGNITUDE_PM2DOT5:
-        result = PSTR("pm2dot5");
-        break;
-    case MAGNITUDE_PM10:
-        result = PSTR("pm10");
-        break;
-    case MAGNITUDE_CO2:
-        result = PSTR("co2");
-        break;
-    case MAGNITUDE_VOC:
-        result = PSTR("voc");
-        break;
-    case MAGNITUDE_IAQ:
-        result = PSTR("iaq");
-        break;
-    case MAGNITUDE_IAQ_ACCURACY:
-        result = PSTR("iaq_accuracy");
-        break;
-    case MAGNITUDE_IAQ_STATIC:
-        result = PSTR("iaq_static");
-        break;
-    case MAGNITUDE_LUX:
-        result = PSTR("lux");
-        break;
-    case MAGNITUDE_UVA:
-        result = PSTR("uva");
-        break;
-    case MAGNITUDE_UVB:
-        result = PSTR("uvb");
-        break;
-    case MAGNITUDE_UVI:
-        result = PSTR("uvi");
-        break;
-    case MAGNITUDE_DISTANCE:
-        result = PSTR("distance");
-        break;
-    case MAGNITUDE_HCHO:
-        result = PSTR("hcho");
-        break;
-    case MAGNITUDE_GEIGER_CPM:
-        result = PSTR("ldr_cpm"); // local dose rate [Counts per minute]
-        break;
-    case MAGNITUDE_GEIGER_SIEVERT:
-        result = PSTR("ldr_uSvh"); // local dose rate [µSievert per hour]
-        break;
-    case MAGNITUDE_COUNT:
-        result = PSTR("count");
-        break;
-    case MAGNITUDE_NO2:
-        result = PSTR("no2");
-        break;
-    case MAGNITUDE_CO:
-        result = PSTR("co");
-        break;
-    case MAGNITUDE_RESISTANCE:
-        result = PSTR("resistance");
-        break;
-    case MAGNITUDE_PH:
-        result = PSTR("ph");
-        break;
-    case MAGNITUDE_FREQUENCY:
-        result = PSTR("frequency");
-        break;
-    case MAGNITUDE_TVOC:
-        result = PSTR("tvoc");
-        break;
-    case MAGNITUDE_CH2O:
-        result = PSTR("ch2o");
-        break;
-    case MAGNITUDE_NONE:
-    default:
-        break;
-    }
-
-    return String(result);
+    return topic_view(type).toString();
 }
 
 String topic(const Magnitude& magnitude) {
     return topic(magnitude.type);
 }
 
-String topicWithIndex(const Magnitude& magnitude) {
-    auto out = topic(magnitude);
-    if (sensor::build::useIndex() || (Magnitude::counts(magnitude.type) > 1)) {
-        out += '/' + String(magnitude.index_global, 10);
-    }
-
-    return out;
-}
-
 String description(const Magnitude& magnitude) {
     return magnitude.sensor->description(magnitude.slot);
 }
@@ -1574,33 +1091,6 @@ Filter defaultFilter(const Magnitude& magnitude) {
     return defaultFilter(magnitude.type);
 }
 
-BaseFilterPtr makeFilter(Filter filter) {
-    BaseFilterPtr out;
-
-    switch (filter) {
-    case Filter::Last:
-        out = std::make_unique<LastFilter>();
-        break;
-    case Filter::Max:
-        out = std::make_unique<MaxFilter>();
-        break;
-    case Filter::Median:
-        out = std::make_unique<MedianFilter>();
-        break;
-    case Filter::Min:
-        out = std::make_unique<MinFilter>();
-        break;
-    case Filter::MovingAverage:
-        out = std::make_unique<MovingAverageFilter>();
-        break;
-    case Filter::Sum:
-        out = std::make_unique<SumFilter>();
-        break;
-    }
-
-    return out;
-}
-
 // Hardcoded decimals for each magnitude
 unsigned char decimals(Unit unit) {
     switch (unit) {
@@ -1646,31 +1136,6 @@ unsigned char decimals(Unit unit) {
     return 0;
 }
 
-// Process input (sensor) units and convert to the ones that magnitude specifies as output
-ValuePair process(const Magnitude& magnitude, double value, Unit units) {
-    auto out = make_value_pair(value, units);
-
-    if (units != magnitude.units) {
-        using namespace sensor::convert;
-        if (temperature::supported(units) && temperature::supported(magnitude.units)) {
-            out.value = temperature::convert(value, units, magnitude.units);
-        } else if (metric::supported(units) && metric::supported(magnitude.units)) {
-            out.value = metric::convert(value, units, magnitude.units);
-        }
-        out.units = magnitude.units;
-    }
-
-    // Input value might have more decimal points than necessary.
-    out.value = roundTo(out.value, magnitude.decimals);
-
-    return out;
-}
-
-ValuePair process(const Magnitude& magnitude, ValuePair value) {
-    return process(magnitude, value.value,
-        magnitude.sensor->units(magnitude.slot));
-}
-
 namespace internal {
 
 std::vector<Magnitude> magnitudes;
@@ -1775,26 +1240,10 @@ Info info(const Magnitude& magnitude) {
         .index = magnitude.index_global,
         .units = magnitude.units,
         .decimals = magnitude.decimals,
-        .topic = topicWithIndex(magnitude),
-    };
-}
-
-Value value(const Magnitude& magnitude, double value, Unit units) {
-    return Value{
-        .type = magnitude.type,
-        .index = magnitude.index_global,
-        .units = units,
-        .decimals = magnitude.decimals,
-        .topic = topicWithIndex(magnitude),
-        .value = value,
-        .repr = format(magnitude, value),
+        .topic = topicWithIndex(magnitude).toString(),
     };
 }
 
-Value value(const Magnitude& magnitude, ValuePair value) {
-    return magnitude::value(magnitude, value.value, value.units);
-}
-
 template <typename T>
 Value safe_value(size_t index, T&& retrieve) {
     Value out;
@@ -2307,7 +1756,8 @@ void load() {
             return;
         }
 
-        auto serial = std::make_shared<PZEM004TSensor::SerialPort>(port->stream);
+        auto serial = std::make_shared<PZEM004TSensor::SerialPort>(
+            port->stream, PZEM004TSensor::ReadTimeout);
 
         bool initialized { false };
 #if !defined(PZEM004T_ADDRESSES)
@@ -2514,13 +1964,29 @@ void load() {
             return;
         }
 
-        auto* sensor = PZEM004TV30Sensor::make(port->stream,
-            getSetting("pzemv30Addr", PZEM004TV30Sensor::DefaultAddress),
+        auto poller = std::make_shared<SerialPoller>(port->stream,
             getSetting("pzemv30ReadTimeout", PZEM004TV30Sensor::DefaultReadTimeout));
-        sensor->setDebug(
-            getSetting("pzemv30Debug", PZEM004TV30Sensor::DefaultDebug));
+        const auto debug = getSetting("pzemv30Debug", PZEM004TV30Sensor::DefaultDebug);
+
+        // Keep the original key for the first device, other devices are optional
+        for (size_t index = 0; index < PZEM004TV30Sensor::DevicesMax; ++index) {
+            const auto address = (0 == index)
+                ? getSetting("pzemv30Addr", PZEM004TV30Sensor::DefaultAddress)
+                : getSetting({"pzemv30Addr", index}, static_cast<uint8_t>(0));
+            if (!address) {
+                break;
+            }
 
-        add(sensor);
+            auto* sensor = PZEM004TV30Sensor::make(poller, address);
+            if (!sensor) {
+                break;
+            }
+
+            sensor->setDebug(debug);
+            add(sensor);
+        }
+
+        PZEM004TV30Sensor::registerTerminalCommands();
     }
 #endif
 }
@@ -2766,48 +2232,281 @@ String name(Unit unit) {
     return espurna::settings::internal::serialize(unit);
 }
 
+// same as name(), but without making a copy of the string
+StringView view(Unit unit) {
+    for (const auto& option : settings::units::Options) {
+        if (option.value() == unit) {
+            return option.string();
+        }
+    }
+
+    return settings::units::None;
+}
+
 String name(const Magnitude& magnitude) {
     return name(magnitude.units);
 }
 
-void setup(Unit unit) {
-    ++internal::counts[static_cast<underlying_type>(unit)];
-}
+void setup(Unit unit) {
+    ++internal::counts[static_cast<underlying_type>(unit)];
+}
+
+void setup(unsigned char type) {
+    const auto range = units::range(type);
+    for (auto entry : range) {
+        setup(entry);
+    }
+}
+
+} // namespace units
+
+namespace magnitude {
+
+String format_with_units(const Magnitude& magnitude, const ValuePair& pair) {
+    String out;
+
+    if (std::isnan(pair.value)) {
+        out += STRING_VIEW("nan").toString();
+        return out;
+    }
+
+    out += magnitude::format(magnitude, pair.value);
+    if (pair.units != Unit::None) {
+        out += units::name(pair.units);
+    }
+
+    return out;
+}
+
+} // namespace magnitude
+
+// -----------------------------------------------------------------------------
+// Energy persistence
+// -----------------------------------------------------------------------------
+
+namespace energy {
+
+// Dedicated flash area for the energy totals, placed right below the EEPROM sectors
+// (which are already excluded from the usable OTA space on most layouts)
+namespace journal {
+namespace build {
+
+constexpr size_t sectors() {
+    return SENSOR_ENERGY_JOURNAL_SECTORS;
+}
+
+} // namespace build
+
+static_assert(Entries == (sizeof(RtcmemData::energy) / sizeof(RtcmemEnergy)), "");
+
+// Start of the FS area, which also marks the end of the free sketch space used by the updater
+extern "C" uint32_t _FS_start;
+
+uint32_t updater_end() {
+    return (reinterpret_cast<uint32_t>(&_FS_start) - 0x40200000) / SPI_FLASH_SEC_SIZE;
+}
+
+struct FlashStorage {
+    FlashStorage() = default;
+    FlashStorage(uint32_t start, size_t sectors) :
+        _start(start),
+        _sectors(sectors)
+    {}
+
+    uint32_t start() const {
+        return _start;
+    }
+
+    size_t sectors() const {
+        return _sectors;
+    }
+
+    size_t sector_size() const {
+        return SPI_FLASH_SEC_SIZE;
+    }
+
+    bool read(size_t offset, Record& out) {
+        return ESP.flashRead(address(offset),
+            reinterpret_cast<uint32_t*>(&out), sizeof(out));
+    }
+
+    bool write(size_t offset, const Record& record) {
+        return ESP.flashWrite(address(offset),
+            reinterpret_cast<const uint32_t*>(&record), sizeof(record));
+    }
+
+    bool erase(size_t sector) {
+        return ESP.flashEraseSector(_start + sector);
+    }
+
+private:
+    uint32_t address(size_t offset) const {
+        return (_start * SPI_FLASH_SEC_SIZE) + offset;
+    }
+
+    uint32_t _start { 0 };
+    size_t _sectors { 0 };
+};
+
+namespace internal {
+
+FlashStorage storage;
+Journal<FlashStorage> journal(storage);
+
+std::array<Entry, Entries> entries{};
+
+bool ready { false };
+bool recovered { false };
+bool pending { false };
+bool updater { false };
+
+} // namespace internal
+
+bool ready() {
+    return internal::ready;
+}
+
+bool available(size_t index) {
+    return internal::ready && (index < Entries);
+}
+
+bool empty(const Entry& entry) {
+    return !entry.kwh && !entry.ws && !entry.timestamp;
+}
+
+Energy to_energy(const Entry& entry) {
+    return Energy {
+        Energy::Pair {
+            .kwh = KilowattHours(entry.kwh),
+            .ws = WattSeconds(entry.ws),
+        }};
+}
+
+// Only consider entries that were ever written. Settings are still used as a fallback,
+// in case journal was just enabled and the counters were saved by the older version.
+bool get(size_t index, Energy& out) {
+    if (!available(index) || !internal::recovered) {
+        return false;
+    }
+
+    const auto& entry = internal::entries[index];
+    if (empty(entry)) {
+        return false;
+    }
+
+    out = to_energy(entry);
+
+    return true;
+}
+
+uint32_t timestamp(size_t index) {
+    return available(index)
+        ? internal::entries[index].timestamp
+        : 0;
+}
+
+void set(size_t index, const Energy& energy) {
+    const auto pair = energy.pair();
+
+    uint32_t timestamp { 0 };
+#if NTP_SUPPORT
+    if (ntpSynced()) {
+        timestamp = ::time(nullptr);
+    }
+#endif
+
+    internal::entries[index] = Entry{
+        .kwh = pair.kwh.value,
+        .ws = pair.ws.value,
+        .timestamp = timestamp,
+    };
+    internal::pending = true;
+}
+
+void reset(size_t index) {
+    if (!available(index)) {
+        return;
+    }
 
-void setup(unsigned char type) {
-    const auto range = units::range(type);
-    for (auto entry : range) {
-        setup(entry);
+    auto& entry = internal::entries[index];
+    if (!empty(entry)) {
+        entry = Entry{};
+        internal::pending = true;
     }
 }
 
-} // namespace units
+// Every pending change is written as a single record
+void flush() {
+    if (!internal::pending) {
+        return;
+    }
 
-namespace magnitude {
+    internal::pending = false;
+    if (!internal::journal.append(internal::entries)) {
+        DEBUG_MSG_P(PSTR("[ENERGY] Journal write failed at slot %zu\n"),
+            internal::journal.next());
+    }
+}
 
-String format_with_units(const Magnitude& magnitude, const ValuePair& pair) {
-    String out;
+void setup() {
+    if (!build::sectors()) {
+        return;
+    }
 
-    if (std::isnan(pair.value)) {
-        out += STRING_VIEW("nan").toString();
-        return out;
+    // Never overlap with the currently running app
+    const auto app_end = (ESP.getSketchSize() + SPI_FLASH_SEC_SIZE - 1) / SPI_FLASH_SEC_SIZE;
+
+    const auto eeprom_end = EEPROMr.base() + 1 - EEPROMr.size();
+    if (eeprom_end < (app_end + build::sectors())) {
+        DEBUG_MSG_P(PSTR("[ENERGY] Not enough flash space for the journal\n"));
+        return;
     }
 
-    out += magnitude::format(magnitude, pair.value);
-    if (pair.units != Unit::None) {
-        out += units::name(pair.units);
+    internal::storage = FlashStorage(eeprom_end - build::sectors(), build::sectors());
+    internal::ready = true;
+    internal::updater = internal::storage.start() < updater_end();
+
+    Record record;
+    internal::recovered = internal::journal.recover(record);
+    if (internal::recovered) {
+        internal::entries = record.entries;
     }
 
-    return out;
+    DEBUG_MSG_P(PSTR("[ENERGY] Journal sectors %u...%u, %s #%u\n"),
+        internal::storage.start(),
+        internal::storage.start() + internal::storage.sectors() - 1,
+        internal::recovered ? "recovered" : "empty",
+        internal::journal.sequence());
 }
 
-} // namespace magnitude
+// Without the FS area (e.g. 1MB layout), journal sectors are a part of the free sketch space
+// and will be overwritten by the updater. Every total is handed back to the callback (i.e. saved
+// as settings), and the journal is erased. Older records would otherwise be preferred over
+// the settings after the restart, when the update fails before reaching the journal sectors.
+template <typename T>
+void suspend(T&& callback) {
+    if (!internal::ready || !internal::updater) {
+        return;
+    }
 
-// -----------------------------------------------------------------------------
-// Energy persistence
-// -----------------------------------------------------------------------------
+    internal::ready = false;
+    internal::pending = false;
 
-namespace energy {
+    for (size_t index = 0; index < Entries; ++index) {
+        const auto& entry = internal::entries[index];
+        if (!empty(entry)) {
+            callback(index, to_energy(entry));
+        }
+    }
+
+    for (size_t sector = 0; sector < internal::storage.sectors(); ++sector) {
+        internal::storage.erase(sector);
+    }
+
+    DEBUG_MSG_P(PSTR("[ENERGY] Journal suspended, totals are saved to settings\n"));
+}
+
+} // namespace journal
 
 struct Persist {
     Persist(size_t index, Energy energy) :
@@ -2816,6 +2515,11 @@ struct Persist {
     {}
 
     void operator()() const {
+        if (journal::available(_index)) {
+            journal::set(_index, _energy);
+            return;
+        }
+
         setSetting({F("eneTotal"), _index}, _energy.asString());
 #if NTP_SUPPORT
         if (ntpSynced()) {
@@ -2829,6 +2533,13 @@ private:
     Energy _energy;
 };
 
+// Called by the OTA methods, before anything is written into the free sketch space
+void ota_start() {
+    journal::suspend([](size_t index, Energy energy) {
+        Persist(index, energy)();
+    });
+}
+
 struct Tracker {
     using Reference = std::reference_wrapper<const Magnitude>;
 
@@ -3011,7 +2722,7 @@ Energy get(unsigned char index) {
 
     if (rtcmemStatus() && (index < (sizeof(Rtcmem->energy) / sizeof(*Rtcmem->energy)))) {
         result = get_rtcmem(index);
-    } else {
+    } else if (!journal::get(index, result)) {
         result = get_settings(index);
     }
 
@@ -3021,6 +2732,7 @@ Energy get(unsigned char index) {
 void reset(unsigned char index) {
     delSetting({F("eneTotal"), index});
     delSetting({F("eneTime"), index});
+    journal::reset(index);
     if (index < (sizeof(Rtcmem->energy) / sizeof(*Rtcmem->energy))) {
         Rtcmem->energy[index].kwh = 0;
         Rtcmem->energy[index].ws = 0;
@@ -3268,6 +2980,27 @@ void migrate(int version) {
 
 } // namespace settings
 
+// -----------------------------------------------------------------------------
+// On-demand magnitude reads
+// -----------------------------------------------------------------------------
+
+namespace immediate {
+
+enum class Result {
+    Scheduled,
+    NotReady,
+    InvalidMagnitude,
+    Limited,
+};
+
+// Read every magnitude of the sensor providing magnitude #index, outside of the read interval.
+// Read itself happens in the loop(), values are published right after it
+Result request(size_t index);
+
+String result(Result);
+
+} // namespace immediate
+
 // -----------------------------------------------------------------------------
 // WebUI value display and actions
 // -----------------------------------------------------------------------------
@@ -3459,8 +3192,14 @@ void energy(JsonObject& root) {
             out.add(index);
         }},
         {STRING_VIEW("saved"), [](JsonArray& out, size_t index) {
-            if (energy::internal::tracker) {
-                out.add(getSetting({F("eneTime"), magnitude::get(index).index_global}, F("(unknown)")));
+            const auto index_global = magnitude::get(index).index_global;
+            const auto timestamp = energy::journal::timestamp(index_global);
+            if (energy::internal::tracker && timestamp) {
+                out.add(datetime::format_local_tz(static_cast<time_t>(timestamp)));
+            } else if (energy::internal::tracker && !energy::journal::available(index_global)) {
+                out.add(getSetting({F("eneTime"), index_global}, F("(unknown)")));
+            } else if (energy::internal::tracker) {
+                out.add(F("(unknown)"));
             } else {
                 out.add("");
             }
@@ -3493,6 +3232,44 @@ void onData(JsonObject& root) {
     }
 }
 
+void onMagnitudes(JsonObject& root) {
+    if (magnitude::count()) {
+        magnitudes(root);
+    }
+}
+
+void onEnergy(JsonObject& root) {
+    if (magnitude::count()) {
+        energy(root);
+    }
+}
+
+// Same as 'magnitudes', value is formatted by the webui using the 'decimals'
+espurna::web::ws::BinaryFrame binary() {
+    using espurna::web::ws::BinaryFrame;
+
+    const auto count = magnitude::count();
+
+    BinaryFrame out(BinaryFrame::Type::Magnitudes, 1 + (count * 11));
+    out.u8(count);
+
+    for (size_t index = 0; index < count; ++index) {
+        const auto& magnitude = magnitude::get(index);
+        out.f64(magnitude.last.value);
+        out.u8(magnitude.decimals);
+        out.u8(static_cast<uint8_t>(magnitude.last.units));
+        out.u8(magnitude::error(index));
+    }
+
+    return out;
+}
+
+// Only the values are sent as telemetry, energy status changes a lot less often
+void report() {
+    wsPostTelemetry(onMagnitudes, binary);
+    wsPostDelta(onEnergy);
+}
+
 void onAction(uint32_t client_id, const char* action, JsonObject& data) {
     if (STRING_VIEW("emon-expected") == action) {
         auto id = data["id"].as<size_t>();
@@ -3583,7 +3360,7 @@ void setup() {
     wsRegister()
         .onConnected(initial)
         .onConnected(list)
-        .onConnected(settings)
+        .onConnected(STRING_VIEW("sns"), settings)
         .onVisible(onVisible)
         .onData(onData)
         .onAction(onAction)
@@ -3621,7 +3398,7 @@ void setup() {
             JsonArray& magnitudes = root.createNestedArray("magnitudes");
             for (auto& magnitude : magnitude::internal::magnitudes) {
                 JsonArray& data = magnitudes.createNestedArray();
-                data.add(sensor::magnitude::topicWithIndex(magnitude));
+                data.add(sensor::magnitude::topicWithIndex(magnitude).toString());
                 data.add(magnitude.last.value);
                 data.add(magnitude.reported.value);
             }
@@ -3657,6 +3434,22 @@ void setup() {
 
         apiRegister(std::move(pattern), std::move(get), std::move(put));
     });
+
+    apiRegister(F("read/+"),
+        nullptr,
+        [](ApiRequest& request) {
+            size_t index;
+            if (!::tryParseId(request.wildcard(0), magnitude::count(), index)) {
+                return false;
+            }
+
+            const auto result = immediate::request(index);
+            if (immediate::Result::Scheduled != result) {
+                return apiError(request);
+            }
+
+            return apiOk(request);
+        });
 }
 
 } // namespace api
@@ -3684,18 +3477,26 @@ void report(const Value& report, const Magnitude& magnitude) {
 #endif
 }
 
-void callback(unsigned int type, StringView topic, StringView payload) {
-    if (!magnitude::count(MAGNITUDE_ENERGY)) {
-        return;
-    }
+STRING_VIEW_INLINE(ReadTopic, "read");
 
+void callback(unsigned int type, StringView topic, StringView payload) {
+    const auto energy = magnitude::count(MAGNITUDE_ENERGY) > 0;
     static const auto base = magnitude::topic(MAGNITUDE_ENERGY);
 
     switch (type) {
     case MQTT_MESSAGE_EVENT:
     {
         auto t = mqttMagnitude(topic);
-        if (!t.startsWith(base)) {
+        if (t.startsWith(ReadTopic)) {
+            size_t index;
+            if (tryParseIdPath(t, magnitude::count(), index)) {
+                immediate::request(index);
+            }
+
+            break;
+        }
+
+        if (!energy || !t.startsWith(base)) {
             break;
         }
 
@@ -3713,7 +3514,10 @@ void callback(unsigned int type, StringView topic, StringView payload) {
     }
 
     case MQTT_CONNECT_EVENT:
-        mqttSubscribe((base + F("/+")).c_str());
+        mqttSubscribe((ReadTopic.toString() + F("/+")).c_str());
+        if (energy) {
+            mqttSubscribe((base + F("/+")).c_str());
+        }
         break;
 
     }
@@ -3750,6 +3554,25 @@ void magnitudes(::terminal::CommandContext&& ctx) {
     terminalOK(ctx);
 }
 
+PROGMEM_STRING(MagnitudesRead, "MAGNITUDES.READ");
+
+void magnitudes_read(::terminal::CommandContext&& ctx) {
+    if (ctx.argv.size() != 2) {
+        terminalError(ctx, F("MAGNITUDES.READ <ID>"));
+        return;
+    }
+
+    const auto id = espurna::settings::internal::convert<size_t>(ctx.argv[1]);
+
+    const auto result = immediate::request(id);
+    if (immediate::Result::Scheduled != result) {
+        terminalError(ctx, immediate::result(result));
+        return;
+    }
+
+    terminalOK(ctx);
+}
+
 PROGMEM_STRING(Expected, "EXPECTED");
 
 void expected(::terminal::CommandContext&& ctx) {
@@ -3821,6 +3644,7 @@ void energy(::terminal::CommandContext&& ctx) {
 
 static constexpr ::terminal::Command List[] PROGMEM {
     {Magnitudes, commands::magnitudes},
+    {MagnitudesRead, commands::magnitudes_read},
     {Expected, commands::expected},
     {ResetRatios, commands::reset_ratios},
     {Energy, commands::energy},
@@ -3882,6 +3706,12 @@ void configure_magnitude(Magnitude& magnitude) {
         sensor->setReferenceVoltage(getSetting(
             settings::keys::get(magnitude, settings::suffix::Reference),
             sensor->defaultReferenceVoltage()));
+
+        using emon::Kernel;
+        const auto fixed = getSetting(
+            settings::keys::get(magnitude, settings::suffix::FixedPoint),
+            emon::DefaultKernel == Kernel::Fixed);
+        sensor->setKernel(fixed ? Kernel::Fixed : Kernel::Float);
     }
 
     // adjust units based on magnitude's type
@@ -3950,13 +3780,68 @@ void schedule_read() {
     internal::read_flag.stop_wait(internal::read_interval);
 }
 
+namespace emon {
+namespace background {
+namespace internal {
+
+timer::SystemTimer timer;
+std::vector<BaseAnalogEmonSensor*> sensors;
+size_t next { 0 };
+
+} // namespace internal
+
+// Only a single sensor is sampled per callback, keeping the time spent in SYS context short.
+void capture() {
+    internal::sensors[internal::next]->capture();
+    internal::next = (internal::next + 1) % internal::sensors.size();
+}
+
+void start() {
+    if (!internal::sensors.empty()) {
+        internal::timer.repeat(
+            duration::Milliseconds(EMON_BACKGROUND_INTERVAL),
+            capture);
+    }
+}
+
+void stop() {
+    internal::timer.stop();
+}
+
+void setup(const std::vector<BaseSensorPtr>& sensors) {
+    stop();
+
+    internal::sensors.clear();
+    internal::next = 0;
+
+    for (auto& sensor : sensors) {
+        if (!isAnalogEmon(sensor)) {
+            continue;
+        }
+
+        auto* ptr = static_cast<BaseAnalogEmonSensor*>(sensor.get());
+        if (ptr->background()) {
+            internal::sensors.push_back(ptr);
+        }
+    }
+
+    start();
+}
+
+} // namespace background
+} // namespace emon
+
 void suspend() {
+    emon::background::stop();
+
     for (auto& sensor : internal::sensors) {
         sensor->suspend();
     }
 }
 
 void resume() {
+    emon::background::start();
+
     schedule_read();
 
     magnitude::forEachInstance(
@@ -4029,6 +3914,7 @@ bool init() {
 
     if (out) {
         internal::state = State::Ready;
+        emon::background::setup(internal::sensors);
 
         if (sensor::count()) {
             DEBUG_MSG_P(PSTR("[SENSOR] Finished initialization for %zu sensor(s) and %zu magnitude(s)\n"),
@@ -4117,72 +4003,193 @@ void error() {
 #endif
 }
 
-void reset_report(duration::Seconds read_interval, size_t report_every) {
-    internal::read_interval = read_interval;
-    internal::report_every = report_every;
-    internal::read_flag.stop_wait(read_interval);
+// Power and current values are forced to 0 when the only relay is OFF
+bool power_off() {
+#if RELAY_SUPPORT && SENSOR_POWER_CHECK_STATUS
+    return (relayCount() == 1) && (relayStatus(0) == 0);
+#else
+    return false;
+#endif
 }
 
-bool ready_to_read() {
-    return internal::read_flag.wait(internal::read_interval);
+// Value from the sensor as-is
+ValuePair raw_value(const Magnitude& magnitude, bool power_off [[gnu::unused]]) {
+    auto out = ValuePair{
+        .value = magnitude.sensor->value(magnitude.slot),
+        .units = magnitude.sensor->units(magnitude.slot),
+    };
+
+    // Completely remove spurious values if relay is OFF
+#if RELAY_SUPPORT && SENSOR_POWER_CHECK_STATUS
+    switch (magnitude.type) {
+    case MAGNITUDE_POWER_ACTIVE:
+    case MAGNITUDE_POWER_REACTIVE:
+    case MAGNITUDE_POWER_APPARENT:
+    case MAGNITUDE_POWER_FACTOR:
+    case MAGNITUDE_CURRENT:
+    case MAGNITUDE_ENERGY_DELTA:
+        if (power_off) {
+            out.value = 0.0;
+        }
+        break;
+    default:
+        break;
+    }
+#endif
+
+    return out;
 }
 
-bool ready_to_report(ValuePair& out, const ValuePair& processed, const Magnitude& magnitude, bool report) {
-    // Ensure that reported value change is greater or equal to this delta value
-    const bool compare_min_delta { magnitude.min_delta > build::DefaultMinDelta };
-    report = report || compare_min_delta;
+namespace immediate {
+namespace build {
 
-    // Ensure that reported value change is less or equal to this delta value
-    const bool compare_max_delta { magnitude.max_delta > build::DefaultMaxDelta };
-    report = report || compare_max_delta;
+constexpr auto interval() -> duration::Milliseconds {
+    return duration::Milliseconds(SENSOR_IMMEDIATE_READ_INTERVAL);
+}
 
-    // Ensure that reported value is greater than or equal to this value
-    const bool check_min_threshold { !std::isnan(magnitude.min_threshold) };
-    report = report || check_min_threshold;
+} // namespace build
 
-    // Ensure that reported value is less than or equal to this value
-    const bool check_max_threshold { !std::isnan(magnitude.max_threshold) };
-    report = report || check_max_threshold;
+namespace internal {
 
+struct Request {
+    BaseSensorPtr sensor;
+    time::CoreClock::time_point last;
+    bool pending;
+};
 
-    if (report) {
-        if (magnitude.filter->ready()) {
-            out = ValuePair{
-                .value = magnitude.filter->value(),
-                .units = processed.units,
-            };
-            magnitude.filter->restart();
-        } else {
-            out = processed;
-        }
+std::vector<Request> requests;
 
-        // Figure out whether report value should be zero or not
-        if (!std::isnan(magnitude.zero_threshold) && out.value < magnitude.zero_threshold) {
-            out.value = 0.0;
-        }
+} // namespace internal
 
-        const bool previous_report { !std::isnan(magnitude.reported.value) };
+String result(Result result) {
+    StringView out;
 
-        if (report && previous_report && compare_min_delta) {
-            report = std::abs(out.value - magnitude.reported.value)
-                >= magnitude.min_delta;
-        }
+    switch (result) {
+    case Result::Scheduled:
+        out = STRING_VIEW("Scheduled");
+        break;
+    case Result::NotReady:
+        out = STRING_VIEW("Sensors are not ready");
+        break;
+    case Result::InvalidMagnitude:
+        out = STRING_VIEW("Invalid magnitude ID");
+        break;
+    case Result::Limited:
+        out = STRING_VIEW("Sensor was read too recently");
+        break;
+    }
+
+    return out.toString();
+}
+
+// Requests for the same sensor are merged. Since some sensors take a while to read
+// (or have to wait for the conversion), every sensor can only be read once per interval
+Result request(size_t index) {
+    if (State::Reading != sensor::internal::state) {
+        return Result::NotReady;
+    }
+
+    if (index >= magnitude::count()) {
+        return Result::InvalidMagnitude;
+    }
+
+    const auto sensor = magnitude::get(index).sensor;
+
+    auto it = std::find_if(
+        internal::requests.begin(),
+        internal::requests.end(),
+        [&](const internal::Request& request) {
+            return request.sensor.get() == sensor.get();
+        });
+
+    const auto now = time::CoreClock::now();
+    if (it == internal::requests.end()) {
+        internal::requests.push_back(
+            internal::Request{
+                .sensor = sensor,
+                .last = now - build::interval(),
+                .pending = false,
+            });
+        it = internal::requests.end() - 1;
+    }
+
+    if ((*it).pending) {
+        return Result::Scheduled;
+    }
+
+    if (now - (*it).last < build::interval()) {
+        return Result::Limited;
+    }
+
+    (*it).pending = true;
+
+    return Result::Scheduled;
+}
+
+// Same as the regular read, but report counters are left alone. Values still go through the filter,
+// since delta and counter sensors (e.g. energy pulses) reset their internal state after value() is called.
+// Latest value is updated and sent to the read handlers, mqtt and websocket
+void read(BaseSensorPtr sensor) {
+    sensor->pre();
+
+    if (SENSOR_ERROR_OK != sensor->error()) {
+        DEBUG_MSG_P(PSTR("[SENSOR] Could not read from %s - %s\n"),
+            sensor->description().c_str(),
+            error(sensor->error()).c_str());
+        sensor->post();
+        return;
+    }
+
+    const auto off = power_off();
 
-        if (report && previous_report && compare_max_delta) {
-            report = std::abs(out.value - magnitude.reported.value)
-                <= magnitude.max_delta;
+    for (auto& magnitude : magnitude::internal::magnitudes) {
+        if (magnitude.sensor.get() != sensor.get()) {
+            continue;
         }
 
-        if (report && check_min_threshold) {
-            report = out.value >= magnitude.min_threshold;
+        const auto processed = processed_value(
+            magnitude, raw_value(magnitude, off));
+
+        magnitude::feed(magnitude, processed);
+        if (MAGNITUDE_ENERGY == magnitude.type) {
+            energy::update(magnitude, false);
         }
 
-        if (report && check_max_threshold) {
-            report = out.value <= magnitude.max_threshold;
+        const auto value = magnitude::value(magnitude, processed);
+        magnitude::read(value);
+
+#if MQTT_SUPPORT
+        mqtt::report(value, magnitude);
+#endif
+    }
+
+    sensor->post();
+
+#if WEB_SUPPORT
+    web::report();
+#endif
+}
+
+void process() {
+    for (auto& request : internal::requests) {
+        if (request.pending) {
+            request.pending = false;
+            request.last = time::CoreClock::now();
+            read(request.sensor);
         }
     }
+}
+
+} // namespace immediate
+
+void reset_report(duration::Seconds read_interval, size_t report_every) {
+    internal::read_interval = read_interval;
+    internal::report_every = report_every;
+    internal::read_flag.stop_wait(read_interval);
+}
 
-    return report;
+bool ready_to_read() {
+    return internal::read_flag.wait(internal::read_interval);
 }
 
 void loop() {
@@ -4221,11 +4228,12 @@ void loop() {
     // Tick hook, called every loop()
     sensor::tick();
 
+    // Out-of-cycle reads requested through api, mqtt or terminal
+    immediate::process();
+
     if (ready_to_read()) {
         // XXX: Filter out certain magnitude types when relay is turned OFF
-#if RELAY_SUPPORT && SENSOR_POWER_CHECK_STATUS
-        const bool relay_off = (relayCount() == 1) && (relayStatus(0) == 0);
-#endif
+        const bool relay_off = power_off();
 
         // Report every Nth reading
         const auto report_every = reportEvery();
@@ -4251,54 +4259,15 @@ void loop() {
                 continue;
             }
 
-            // Value from the sensor as-is
-            state.raw = ValuePair{
-                .value = magnitude.sensor->value(magnitude.slot),
-                .units = magnitude.sensor->units(magnitude.slot),
-            };
-
-            // Completely remove spurious values if relay is OFF
-#if RELAY_SUPPORT && SENSOR_POWER_CHECK_STATUS
-            switch (magnitude.type) {
-            case MAGNITUDE_POWER_ACTIVE:
-            case MAGNITUDE_POWER_REACTIVE:
-            case MAGNITUDE_POWER_APPARENT:
-            case MAGNITUDE_POWER_FACTOR:
-            case MAGNITUDE_CURRENT:
-            case MAGNITUDE_ENERGY_DELTA:
-                if (relay_off) {
-                    state.raw.value = 0.0;
-                }
-                break;
-            default:
-                break;
-            }
-#endif
-
-            // Apply units and correct number of decimals (directly modifies the double value)
-            state.processed = magnitude::process(magnitude, state.raw);
-
-            // Absolute value correction. *Unconditional*, value is always offset by this amount
-            state.processed.value += magnitude.correction;
-
-            // In case units change occured, make sure filter receives the same unit type
-            if (magnitude.last.units != state.processed.units) {
-                magnitude.filter->reset();
-            }
-
-            magnitude.filter->update(state.processed.value);
+            // Value from the sensor as-is, and with units, decimals and correction applied
+            state.raw = raw_value(magnitude, relay_off);
+            state.processed = processed_value(magnitude, state.raw);
 
-            // Making last reading available in API and for external listeners
-            magnitude.last = state.processed;
+            // Filter the value and make the last reading available in API and for external listeners.
+            // At this point, we should also decide whether this value should be reported.
+            bool report = magnitude::update(magnitude, state.processed, report_every);
             magnitude::read(magnitude::value(magnitude, state.processed));
 
-            // At this point, we should decide whether this value should be reported.
-            // First, increment read counter and check for overflow.
-            const auto read_count = magnitude.read_count;
-            magnitude.read_count = (read_count + 1) % report_every;
-
-            bool report { 0 == magnitude.read_count };
-
             // Special case for energy, save current readings to
             // - RTC memory (always)
             // - Internal flash (optionally, when reporting)
@@ -4342,8 +4311,11 @@ void loop() {
 
         sensor::post();
 
+        // Energy totals are only written once, after every magnitude was processed
+        energy::journal::flush();
+
 #if WEB_SUPPORT
-        wsPost(web::onData);
+        web::report();
 #endif
     }
 }
@@ -4371,6 +4343,10 @@ void setup() {
     // Make sure settings stay up-to-date
     migrateVersion(settings::migrate);
 
+    // Energy totals must be available before any of the sensors are initialized
+    energy::journal::setup();
+    otaOnStart(energy::ota_start);
+
     // Load & initialize magnitudes from available sensors
     sensor::load();
     sensor::try_init();
@@ -4494,12 +4470,22 @@ String magnitudeTopic(unsigned char index) {
     using namespace espurna::sensor;
 
     if (index < magnitude::count()) {
-        return magnitude::topicWithIndex(magnitude::get(index));
+        return magnitude::topicWithIndex(magnitude::get(index)).toString();
     }
 
     return String();
 }
 
+unsigned char magnitudeError(unsigned char index) {
+    using namespace espurna::sensor;
+
+    if (index < magnitude::count()) {
+        return magnitude::get(index).sensor->error();
+    }
+
+    return SENSOR_ERROR_OK;
+}
+
 String magnitudeTypeTopic(unsigned char type) {
     return espurna::sensor::magnitude::topic(type);
 }
@@ -4508,6 +4494,10 @@ String magnitudeUnitsName(espurna::sensor::Unit units) {
     return espurna::sensor::units::name(units);
 }
 
+espurna::StringView magnitudeUnitsView(espurna::sensor::Unit units) {
+    return espurna::sensor::units::view(units);
+}
+
 espurna::sensor::Info magnitudeInfo(unsigned char index) {
     using namespace espurna::sensor;
 
@@ -223,6 +223,13 @@ private:
 
 // '.value' is set to 'Value::Unknown' when index is out of bounds
 // '.value' is undefined when either reading or report hadn't happened yet
+// Both topic and value text are stored inline, creating and copying the Value does not touch the heap
+// Topic is the magnitude type name plus an optional index, e.g. 'temperature/0'
+using Topic = InlineString<31>;
+
+// Fixed notation, up to 9 decimal places. See magnitude::format()
+using Repr = InlineString<31>;
+
 struct Value {
     static constexpr double Unknown {
         std::numeric_limits<double>::quiet_NaN() };
@@ -232,10 +239,10 @@ struct Value {
 
     Unit units;
     unsigned char decimals;
-    String topic;
+    Topic topic;
 
     double value;
-    String repr;
+    Repr repr;
 
     explicit operator bool() const;
 };
@@ -282,6 +289,7 @@ void add_preinit(PreInitPtr);
 
 String magnitudeTypeTopic(unsigned char type);
 String magnitudeUnitsName(espurna::sensor::Unit);
+espurna::StringView magnitudeUnitsView(espurna::sensor::Unit);
 
 using MagnitudeReadHandler = void(*)(const espurna::sensor::Value&);
 
@@ -307,6 +315,9 @@ unsigned char magnitudeIndex(unsigned char index);
 
 String magnitudeTopic(unsigned char index);
 
+// last error of the sensor magnitude belongs to; returns SENSOR_ERROR_OK when index is out of bounds
+unsigned char magnitudeError(unsigned char index);
+
 // Get either last or reported reading; repends on the real-time setting
 espurna::sensor::Value magnitudeValue(unsigned char index);
 
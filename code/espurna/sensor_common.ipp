@@ -0,0 +1,796 @@
+/*
+
+Part of SENSOR MODULE
+
+Value processing shared between the firmware and the host benchmark.
+Magnitude-like objects are sensor.cpp Magnitude, or an equivalent host struct
+
+Copyright (C) 2020-2025 by Maxim Prokhorov <prokhorov dot max at outlook dot com>
+
+*/
+
+#pragma once
+
+#include "config/types.h"
+#include "sensor.h"
+#include "utils.h"
+
+#include "filters/LastFilter.h"
+#include "filters/MaxFilter.h"
+#include "filters/MedianFilter.h"
+#include "filters/MinFilter.h"
+#include "filters/MovingAverageFilter.h"
+#include "filters/SumFilter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <ratio>
+#include <type_traits>
+
+namespace espurna {
+namespace sensor {
+namespace {
+
+// minimal subset of Value for internal use
+struct ValuePair {
+    double value;
+    Unit units;
+};
+
+constexpr ValuePair make_value_pair(double value, Unit units) {
+    return ValuePair{
+        .value = value,
+        .units = units,
+    };
+}
+
+constexpr auto DefaultValuePair =
+    make_value_pair(Value::Unknown, Unit::None);
+
+using BaseFilterPtr = std::unique_ptr<BaseFilter>;
+
+namespace build {
+
+constexpr double DefaultMinDelta { 0.0 };
+constexpr double DefaultMaxDelta { 0.0 };
+
+} // namespace build
+
+namespace convert {
+namespace temperature {
+
+struct Base {
+    constexpr Base() = default;
+    constexpr explicit Base(double value) :
+        _value(value)
+    {}
+
+    constexpr double value() const {
+        return _value;
+    }
+
+    constexpr operator double() const {
+        return _value;
+    }
+
+private:
+    double _value { 0.0 };
+};
+
+struct Kelvin : public Base {
+    using Base::Base;
+};
+
+struct Farenheit : public Base {
+    using Base::Base;
+};
+
+struct Celcius : public Base {
+    using Base::Base;
+};
+
+static constexpr Celcius AbsoluteZero { -273.15 };
+
+namespace internal {
+
+template <typename To, typename From, typename Same = void>
+struct Converter {
+};
+
+template <typename To, typename From>
+struct Converter<To, From, typename std::enable_if<std::is_same<To, From>::value>::type> {
+    static constexpr To convert(To value) {
+        return value;
+    }
+};
+
+static constexpr double celcius_to_kelvin(double celcius) {
+    return celcius - AbsoluteZero;
+}
+
+static constexpr double celcius_to_farenheit(double celcius) {
+    return (celcius * (9.0 / 5.0)) + 32.0;
+}
+
+static constexpr double farenheit_to_celcius(double farenheit) {
+    return (farenheit - 32.0) * (5.0 / 9.0);
+}
+
+static constexpr double farenheit_to_kelvin(double farenheit) {
+    return celcius_to_kelvin(farenheit_to_celcius(farenheit));
+}
+
+static constexpr double kelvin_to_celcius(double kelvin) {
+    return kelvin + AbsoluteZero;
+}
+
+static constexpr double kelvin_to_farenheit(double kelvin) {
+    return celcius_to_farenheit(kelvin_to_celcius(kelvin));
+}
+
+static_assert(celcius_to_kelvin(kelvin_to_celcius(0.0)) == 0.0, "");
+static_assert(celcius_to_farenheit(farenheit_to_celcius(0.0)) == 0.0, "");
+static_assert(farenheit_to_kelvin(kelvin_to_farenheit(0.0)) == 0.0, "");
+static_assert(farenheit_to_celcius(celcius_to_farenheit(0.0)) == 0.0, "");
+static_assert(kelvin_to_celcius(celcius_to_kelvin(0.0)) == 0.0, "");
+
+// ref. https://en.cppreference.com/w/cpp/types/numeric_limits/epsilon
+static constexpr bool almost_equal(double lhs, double rhs, int ulp) {
+    // the machine epsilon has to be scaled to the magnitude of the values used
+    // and multiplied by the desired precision in ULPs (units in the last place)
+    return __builtin_fabs(lhs - rhs) <= std::numeric_limits<double>::epsilon() * __builtin_fabs(lhs + rhs) * ulp
+        // unless the result is subnormal
+        || __builtin_fabs(lhs - rhs) < std::numeric_limits<double>::min();
+}
+
+static_assert(almost_equal(10.0, kelvin_to_farenheit(farenheit_to_kelvin(10.0)), 3), "");
+
+template <>
+struct Converter<Celcius, Kelvin> {
+    static constexpr Celcius convert(Kelvin kelvin) {
+        return Celcius{ kelvin_to_celcius(kelvin.value()) };
+    }
+};
+
+template <>
+struct Converter<Farenheit, Kelvin> {
+    static constexpr Farenheit convert(Kelvin kelvin) {
+        return Farenheit{ kelvin_to_farenheit(kelvin.value()) };
+    }
+};
+
+template <>
+struct Converter<Kelvin, Celcius> {
+    static constexpr Kelvin convert(Celcius celcius) {
+        return Kelvin{ celcius_to_kelvin(celcius.value()) };
+    }
+};
+
+template <>
+struct Converter<Farenheit, Celcius> {
+    static constexpr Farenheit convert(Celcius celcius) {
+        return Farenheit{ celcius_to_farenheit(celcius.value()) };
+    }
+};
+
+template <>
+struct Converter<Kelvin, Farenheit> {
+    static constexpr Kelvin convert(Farenheit farenheit) {
+        return Kelvin{ farenheit_to_kelvin(farenheit.value()) };
+    }
+};
+
+template <>
+struct Converter<Celcius, Farenheit> {
+    static constexpr Celcius convert(Farenheit farenheit) {
+        return Celcius{ farenheit_to_celcius(farenheit.value()) };
+    }
+};
+
+// just some sanity checks. note that floating point will not always produce exact results
+// (and it might not be a good idea to actually have anything compare with the Farenheit one)
+
+static_assert(Converter<Kelvin, Kelvin>::convert(Kelvin{0.0}) == Kelvin{0.0}, "");
+static_assert(Converter<Kelvin, Celcius>::convert(AbsoluteZero) == Kelvin{0.0}, "");
+static_assert(Converter<Celcius, Celcius>::convert(AbsoluteZero) == AbsoluteZero, "");
+static_assert(Converter<Celcius, Kelvin>::convert(Kelvin{0.0}) == AbsoluteZero, "");
+
+} // namespace internal
+
+template <typename To, typename From>
+constexpr To unit_cast(From value) {
+    return internal::Converter<To, From>::convert(value);
+}
+
+static_assert(unit_cast<Kelvin>(AbsoluteZero).value() == 0.0, "");
+static_assert(unit_cast<Celcius>(AbsoluteZero).value() == AbsoluteZero.value(), "");
+
+constexpr bool supported(Unit unit) {
+    return (unit == Unit::Celcius)
+        || (unit == Unit::Kelvin)
+        || (unit == Unit::Farenheit);
+}
+
+// since the outside api only works with the enumeration, make sure to cast it to our types for conversion
+// a table like this could've also worked
+// > {Unit(from), Unit(to), Converter(double(*)(double))}
+// but, it is ~0.6KiB vs. ~0.1KiB for this one. plus, some obstacles with c++11 implementation
+// although, there may be a way to make this cheaper in both compile-time and runtime
+
+// attempt to convert the input value from one unit to the other
+// will return the input value when units match or there's no known conversion
+constexpr double convert(double value, Unit from, Unit to) {
+#define UNIT_CAST(LHS, RHS) \
+    ((from == Unit::LHS) && (to == Unit::RHS)) \
+        ? (unit_cast<RHS, LHS>(LHS{value})) : \
+    ((from == Unit::RHS) && (to == Unit::LHS)) \
+        ? (unit_cast<LHS, RHS>(RHS{value}))
+
+     return UNIT_CAST(Kelvin, Celcius) :
+        UNIT_CAST(Kelvin, Farenheit) :
+        UNIT_CAST(Celcius, Farenheit) : value;
+
+#undef UNIT_CAST
+}
+
+} // namespace temperature
+
+// right now, limited to plain and kilo values
+// (since we mostly care about a fairly small values)
+// type conversion should only work for related types
+namespace metric {
+
+template <typename __Ratio>
+struct Base {
+    using Type = double;
+    using Ratio = __Ratio;
+
+    constexpr Base() = default;
+    constexpr explicit Base(Type value) :
+        _value(value)
+    {}
+
+    constexpr Type value() const {
+        return _value;
+    }
+
+    constexpr operator Type() const {
+        return _value;
+    }
+
+private:
+    Type _value { 0.0 };
+};
+
+template <typename To, typename From>
+struct convertible_base : std::false_type {
+};
+
+template <typename To, typename From>
+constexpr bool is_convertible_base() {
+    return std::is_same<To, From>::value
+        || std::is_base_of<std::true_type, convertible_base<To, From>>::value
+        || std::is_base_of<std::true_type, convertible_base<From, To>>::value;
+}
+
+template <typename To, typename From>
+using is_convertible = std::enable_if<is_convertible_base<To, From>()>;
+
+template <typename To, typename From,
+          typename Divide = std::ratio_divide<typename From::Ratio, typename To::Ratio>,
+          typename = typename is_convertible<To, From>::type>
+constexpr To unit_cast(From value) {
+    return To(value.value()
+            * static_cast<typename To::Type>(Divide::num)
+            / static_cast<typename To::Type>(Divide::den));
+}
+
+struct Watt : public Base<std::ratio<1, 1>> {
+    using Base::Base;
+};
+
+struct Kilowatt : public Base<std::ratio<1000, 1>> {
+    using Base::Base;
+};
+
+template <>
+struct convertible_base<Watt, Kilowatt> : std::true_type {
+};
+
+struct Voltampere : public Base<std::ratio<1, 1>> {
+    using Base::Base;
+};
+
+struct Kilovoltampere : public Base<std::ratio<1000, 1>> {
+    using Base::Base;
+};
+
+template <>
+struct convertible_base<Voltampere, Kilovoltampere> : std::true_type {
+};
+
+struct VoltampereReactive : public Base<std::ratio<1, 1>> {
+    using Base::Base;
+};
+
+struct KilovoltampereReactive : public Base<std::ratio<1000, 1>> {
+    using Base::Base;
+};
+
+template <>
+struct convertible_base<VoltampereReactive, KilovoltampereReactive> : std::true_type {
+};
+
+struct WattSecond : public Base<std::ratio<1, 1>> {
+    using Base::Base;
+};
+
+using Joule = WattSecond;
+
+struct KilowattHour : public Base<std::ratio<3600000, 1>> {
+    using Base::Base;
+};
+
+template <>
+struct convertible_base<WattSecond, KilowattHour> : std::true_type {
+};
+
+static_assert(is_convertible_base<Voltampere, Kilovoltampere>(), "");
+static_assert(is_convertible_base<Kilovoltampere, Voltampere>(), "");
+
+static_assert(!is_convertible_base<KilovoltampereReactive, Voltampere>(), "");
+static_assert(is_convertible_base<Joule, WattSecond>(), "");
+
+static_assert(unit_cast<Joule>(KilowattHour{0.02}) == 72000.0, "");
+static_assert(unit_cast<Joule>(KilowattHour{3.611111111111111e-05}) == 130.0, "");
+static_assert(unit_cast<KilowattHour>(Joule{1080000.0}) == 0.3, "");
+static_assert(unit_cast<KilowattHour>(Joule{12348000.0}) == 3.43, "");
+static_assert(unit_cast<VoltampereReactive>(KilovoltampereReactive{1234.0}) == 1234000.0, "");
+
+constexpr bool supported(Unit unit) {
+    return (unit == Unit::Voltampere)
+        || (unit == Unit::Kilovoltampere)
+        || (unit == Unit::VoltampereReactive)
+        || (unit == Unit::KilovoltampereReactive)
+        || (unit == Unit::Watt)
+        || (unit == Unit::Kilowatt)
+        || (unit == Unit::Joule)
+        || (unit == Unit::WattSecond)
+        || (unit == Unit::KilowattHour);
+}
+
+// Here we only care about the direct counterparts
+// Plus, we still don't enforce supported() at compile time,
+// only safeguard is unit_cast<> failing for 'incompatible' base types
+
+constexpr double convert(double value, Unit from, Unit to) {
+#define UNIT_CAST(LHS, RHS) \
+    ((from == Unit::LHS) && (to == Unit::RHS)) \
+        ? (unit_cast<RHS, LHS>(LHS{value})) : \
+    ((from == Unit::RHS) && (to == Unit::LHS)) \
+        ? (unit_cast<LHS, RHS>(RHS{value}))
+
+    return UNIT_CAST(Watt, Kilowatt) :
+        UNIT_CAST(Voltampere, Kilovoltampere) :
+        UNIT_CAST(VoltampereReactive, KilovoltampereReactive) :
+        UNIT_CAST(Joule, KilowattHour) :
+        UNIT_CAST(WattSecond, KilowattHour) : value;
+
+#undef UNIT_CAST
+}
+
+} // namespace metric
+} // namespace convert
+
+namespace magnitude {
+
+namespace build {
+
+// Fractional part is handled as an integer, 10^9 is the largest power that still fits into u32
+constexpr unsigned char MaxDecimals { 9 };
+
+} // namespace build
+
+// Same output as dtostrf(value, 1, decimals, ...), without the intermediate String
+// and never writing more than the 'size' bytes (including the null terminator).
+// Values that do not fit are replaced with 'ovf', similar to Print::printFloat()
+size_t format(double value, unsigned char decimals, char* out, size_t size) {
+    if (!size) {
+        return 0;
+    }
+
+    const auto text = [&](StringView value) {
+        const auto length = std::min(value.length(), size - 1);
+        memcpy_P(out, value.data(), length);
+        out[length] = '\0';
+        return length;
+    };
+
+    if (std::isnan(value)) {
+        return text(STRING_VIEW("nan"));
+    }
+
+    if (std::isinf(value)) {
+        return text(STRING_VIEW("inf"));
+    }
+
+    decimals = std::min(decimals, build::MaxDecimals);
+
+    const bool negative = value < 0.0;
+    if (negative) {
+        value = -value;
+    }
+
+    uint32_t scale { 1 };
+    for (unsigned char index = 0; index < decimals; ++index) {
+        scale *= 10;
+    }
+
+    // Round half up, just like dtostrf
+    value += 0.5 / static_cast<double>(scale);
+    if (value >= 1e18) {
+        return text(STRING_VIEW("ovf"));
+    }
+
+    const auto integral = static_cast<uint64_t>(value);
+    const auto fraction = std::min(
+        static_cast<uint32_t>((value - static_cast<double>(integral)) * static_cast<double>(scale)),
+        scale - 1);
+
+    // Digits are written in reverse, integral part with at least one digit
+    char buffer[32];
+    size_t length { 0 };
+
+    auto tmp = fraction;
+    for (unsigned char index = 0; index < decimals; ++index) {
+        buffer[length++] = '0' + (tmp % 10);
+        tmp /= 10;
+    }
+
+    if (decimals) {
+        buffer[length++] = '.';
+    }
+
+    auto rest = integral;
+    do {
+        buffer[length++] = '0' + (rest % 10);
+        rest /= 10;
+    } while (rest);
+
+    if (negative) {
+        buffer[length++] = '-';
+    }
+
+    if (length >= size) {
+        return text(STRING_VIEW("ovf"));
+    }
+
+    std::reverse_copy(&buffer[0], &buffer[length], out);
+    out[length] = '\0';
+
+    return length;
+}
+
+Repr repr(double value, unsigned char decimals) {
+    Repr out;
+    out.resize(format(value, decimals, out.data(), out.capacity() + 1));
+    return out;
+}
+
+String format(double value, unsigned char decimals) {
+    return repr(value, decimals).toString();
+}
+
+StringView topic_view(unsigned char type) {
+    const char* result = PSTR("unknown");
+
+    switch (type) {
+    case MAGNITUDE_TEMPERATURE:
+        result = PSTR("temperature");
+        break;
+    case MAGNITUDE_HUMIDITY:
+        result = PSTR("humidity");
+        break;
+    case MAGNITUDE_PRESSURE:
+        result = PSTR("pressure");
+        break;
+    case MAGNITUDE_CURRENT:
+        result = PSTR("current");
+        break;
+    case MAGNITUDE_VOLTAGE:
+        result = PSTR("voltage");
+        break;
+    case MAGNITUDE_POWER_ACTIVE:
+        result = PSTR("power");
+        break;
+    case MAGNITUDE_POWER_APPARENT:
+        result = PSTR("apparent");
+        break;
+    case MAGNITUDE_POWER_REACTIVE:
+        result = PSTR("reactive");
+        break;
+    case MAGNITUDE_POWER_FACTOR:
+        result = PSTR("factor");
+        break;
+    case MAGNITUDE_ENERGY:
+        result = PSTR("energy");
+        break;
+    case MAGNITUDE_ENERGY_DELTA:
+        result = PSTR("energy_delta");
+        break;
+    case MAGNITUDE_ANALOG:
+        result = PSTR("analog");
+        break;
+    case MAGNITUDE_DIGITAL:
+        result = PSTR("digital");
+        break;
+    case MAGNITUDE_EVENT:
+        result = PSTR("event");
+        break;
+    case MAGNITUDE_PM1DOT0:
+        result = PSTR("pm1dot0");
+        break;
+    case MAGNITUDE_PM2DOT5:
+        result = PSTR("pm2dot5");
+        break;
+    case MAGNITUDE_PM10:
+        result = PSTR("pm10");
+        break;
+    case MAGNITUDE_CO2:
+        result = PSTR("co2");
+        break;
+    case MAGNITUDE_VOC:
+        result = PSTR("voc");
+        break;
+    case MAGNITUDE_IAQ:
+        result = PSTR("iaq");
+        break;
+    case MAGNITUDE_IAQ_ACCURACY:
+        result = PSTR("iaq_accuracy");
+        break;
+    case MAGNITUDE_IAQ_STATIC:
+        result = PSTR("iaq_static");
+        break;
+    case MAGNITUDE_LUX:
+        result = PSTR("lux");
+        break;
+    case MAGNITUDE_UVA:
+        result = PSTR("uva");
+        break;
+    case MAGNITUDE_UVB:
+        result = PSTR("uvb");
+        break;
+    case MAGNITUDE_UVI:
+        result = PSTR("uvi");
+        break;
+    case MAGNITUDE_DISTANCE:
+        result = PSTR("distance");
+        break;
+    case MAGNITUDE_HCHO:
+        result = PSTR("hcho");
+        break;
+    case MAGNITUDE_GEIGER_CPM:
+        result = PSTR("ldr_cpm"); // local dose rate [Counts per minute]
+        break;
+    case MAGNITUDE_GEIGER_SIEVERT:
+        result = PSTR("ldr_uSvh"); // local dose rate [µSievert per hour]
+        break;
+    case MAGNITUDE_COUNT:
+        result = PSTR("count");
+        break;
+    case MAGNITUDE_NO2:
+        result = PSTR("no2");
+        break;
+    case MAGNITUDE_CO:
+        result = PSTR("co");
+        break;
+    case MAGNITUDE_RESISTANCE:
+        result = PSTR("resistance");
+        break;
+    case MAGNITUDE_PH:
+        result = PSTR("ph");
+        break;
+    case MAGNITUDE_FREQUENCY:
+        result = PSTR("frequency");
+        break;
+    case MAGNITUDE_TVOC:
+        result = PSTR("tvoc");
+        break;
+    case MAGNITUDE_CH2O:
+        result = PSTR("ch2o");
+        break;
+    case MAGNITUDE_NONE:
+    default:
+        break;
+    }
+
+    return StringView(reinterpret_cast<const __FlashStringHelper*>(result));
+}
+
+// Magnitude-like object is expected to provide static indexed(type), telling whether
+// the topic needs an index suffix (multiple magnitudes of the same type, or forced by the build flag)
+template <typename T>
+Topic topicWithIndex(const T& magnitude) {
+    Topic out(topic_view(magnitude.type));
+    if (T::indexed(magnitude.type)) {
+        char buffer[4];
+        const auto length = snprintf_P(buffer, sizeof(buffer),
+            PSTR("%hhu"), magnitude.index_global);
+
+        out += '/';
+        out += StringView(buffer, length);
+    }
+
+    return out;
+}
+
+// Process input (sensor) units and convert to the ones that magnitude specifies as output
+template <typename T>
+ValuePair process(const T& magnitude, double value, Unit units) {
+    auto out = make_value_pair(value, units);
+
+    if (units != magnitude.units) {
+        using namespace sensor::convert;
+        if (temperature::supported(units) && temperature::supported(magnitude.units)) {
+            out.value = temperature::convert(value, units, magnitude.units);
+        } else if (metric::supported(units) && metric::supported(magnitude.units)) {
+            out.value = metric::convert(value, units, magnitude.units);
+        }
+        out.units = magnitude.units;
+    }
+
+    // Input value might have more decimal points than necessary.
+    out.value = roundTo(out.value, magnitude.decimals);
+
+    return out;
+}
+
+template <typename T>
+ValuePair process(const T& magnitude, ValuePair value) {
+    return process(magnitude, value.value, value.units);
+}
+
+template <typename T>
+Value value(const T& magnitude, double value, Unit units) {
+    return Value{
+        .type = magnitude.type,
+        .index = magnitude.index_global,
+        .units = units,
+        .decimals = magnitude.decimals,
+        .topic = topicWithIndex(magnitude),
+        .value = value,
+        .repr = repr(value, magnitude.decimals),
+    };
+}
+
+template <typename T>
+Value value(const T& magnitude, ValuePair value) {
+    return magnitude::value(magnitude, value.value, value.units);
+}
+
+// Filter receives every processed value, and the last value is made available for the API.
+template <typename T>
+void feed(T& magnitude, ValuePair processed) {
+    // In case units change occured, make sure filter receives the same unit type
+    if (magnitude.last.units != processed.units) {
+        magnitude.filter->reset();
+    }
+
+    magnitude.filter->update(processed.value);
+    magnitude.last = processed;
+}
+
+// Same as the above, but also returns true once every 'report_every' readings
+template <typename T>
+bool update(T& magnitude, ValuePair processed, size_t report_every) {
+    feed(magnitude, processed);
+
+    // Increment read counter and check for overflow
+    const auto read_count = magnitude.read_count;
+    magnitude.read_count = (read_count + 1) % report_every;
+
+    return 0 == magnitude.read_count;
+}
+
+BaseFilterPtr makeFilter(Filter filter) {
+    BaseFilterPtr out;
+
+    switch (filter) {
+    case Filter::Last:
+        out = std::make_unique<LastFilter>();
+        break;
+    case Filter::Max:
+        out = std::make_unique<MaxFilter>();
+        break;
+    case Filter::Median:
+        out = std::make_unique<MedianFilter>();
+        break;
+    case Filter::Min:
+        out = std::make_unique<MinFilter>();
+        break;
+    case Filter::MovingAverage:
+        out = std::make_unique<MovingAverageFilter>();
+        break;
+    case Filter::Sum:
+        out = std::make_unique<SumFilter>();
+        break;
+    }
+
+    return out;
+}
+
+} // namespace magnitude
+
+// Apply units and correct number of decimals (directly modifies the double value)
+// Absolute value correction. *Unconditional*, value is always offset by this amount
+template <typename T>
+ValuePair processed_value(const T& magnitude, ValuePair raw) {
+    auto out = magnitude::process(magnitude, raw);
+    out.value += magnitude.correction;
+    return out;
+}
+
+// Magnitude-like object is expected to provide report settings, filter and the last reported value
+template <typename T>
+bool ready_to_report(ValuePair& out, const ValuePair& processed, const T& magnitude, bool report) {
+    // Ensure that reported value change is greater or equal to this delta value
+    const bool compare_min_delta { magnitude.min_delta > build::DefaultMinDelta };
+    report = report || compare_min_delta;
+
+    // Ensure that reported value change is less or equal to this delta value
+    const bool compare_max_delta { magnitude.max_delta > build::DefaultMaxDelta };
+    report = report || compare_max_delta;
+
+    // Ensure that reported value is greater than or equal to this value
+    const bool check_min_threshold { !std::isnan(magnitude.min_threshold) };
+    report = report || check_min_threshold;
+
+    // Ensure that reported value is less than or equal to this value
+    const bool check_max_threshold { !std::isnan(magnitude.max_threshold) };
+    report = report || check_max_threshold;
+
+
+    if (report) {
+        if (magnitude.filter->ready()) {
+            out = ValuePair{
+                .value = magnitude.filter->value(),
+                .units = processed.units,
+            };
+            magnitude.filter->restart();
+        } else {
+            out = processed;
+        }
+
+        // Figure out whether report value should be zero or not
+        if (!std::isnan(magnitude.zero_threshold) && out.value < magnitude.zero_threshold) {
+            out.value = 0.0;
+        }
+
+        const bool previous_report { !std::isnan(magnitude.reported.value) };
+
+        if (report && previous_report && compare_min_delta) {
+            report = std::abs(out.value - magnitude.reported.value)
+                >= magnitude.min_delta;
+        }
+
+        if (report && previous_report && compare_max_delta) {
+            report = std::abs(out.value - magnitude.reported.value)
+                <= magnitude.max_delta;
+        }
+
+        if (report && check_min_threshold) {
+            report = out.value >= magnitude.min_threshold;
+        }
+
+        if (report && check_max_threshold) {
+            report = out.value <= magnitude.max_threshold;
+        }
+    }
+
+    return report;
+}
+
+} // namespace
+} // namespace sensor
+} // namespace espurna
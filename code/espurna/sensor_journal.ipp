@@ -0,0 +1,211 @@
+/*
+
+Part of SENSOR MODULE
+
+Append-only record storage for the accumulating energy counters
+
+Copyright (C) 2020-2025 by Maxim Prokhorov <prokhorov dot max at outlook dot com>
+
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace espurna {
+namespace sensor {
+namespace energy {
+namespace journal {
+namespace {
+
+// Every record contains *all* of the counters, so only the latest one is needed to restore them.
+// Records are appended to the next free slot, sector is only erased when the journal wraps around
+// and the write position reaches it again. Older records stay in the previous sector(s), so power
+// loss in the middle of a write or an erase always leaves at least one valid record in flash.
+//
+// Layout is word-sized, since flash can only be read and written in 4 byte blocks.
+struct Entry {
+    uint32_t kwh;
+    uint32_t ws;
+    uint32_t timestamp;
+};
+
+constexpr size_t Entries { 4 };
+
+struct Record {
+    uint32_t sequence;
+    std::array<Entry, Entries> entries;
+    uint32_t crc;
+};
+
+static_assert((sizeof(Record) % sizeof(uint32_t)) == 0, "");
+
+// Erased flash reads as 0xff, which is never a valid sequence number
+constexpr uint32_t EmptySequence { 0xffffffff };
+
+// Standard reflected crc32, poly 0xedb88320. Records are small and only written once per
+// N reports, there's no need for a lookup table
+inline uint32_t crc32(const uint8_t* data, size_t size) {
+    uint32_t out { 0xffffffff };
+    for (size_t index = 0; index < size; ++index) {
+        out ^= data[index];
+        for (size_t bit = 0; bit < 8; ++bit) {
+            out = (out >> 1) ^ (0xedb88320 & (0 - (out & 1)));
+        }
+    }
+
+    return ~out;
+}
+
+inline uint32_t crc32(const Record& record) {
+    return crc32(reinterpret_cast<const uint8_t*>(&record), offsetof(Record, crc));
+}
+
+inline bool valid(const Record& record) {
+    return (record.sequence != EmptySequence)
+        && (record.crc == crc32(record));
+}
+
+inline bool empty(const Record& record) {
+    const auto* ptr = reinterpret_cast<const uint8_t*>(&record);
+    for (size_t index = 0; index < sizeof(record); ++index) {
+        if (ptr[index] != 0xff) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Storage is expected to provide the following
+// - size_t sectors() const
+// - size_t sector_size() const
+// - bool read(size_t offset, Record&)
+// - bool write(size_t offset, const Record&)
+// - bool erase(size_t sector)
+// Offsets are relative to the start of the journal area
+template <typename Storage>
+class Journal {
+public:
+    explicit Journal(Storage& storage) :
+        _storage(storage)
+    {}
+
+    size_t slots_per_sector() const {
+        return _storage.sector_size() / sizeof(Record);
+    }
+
+    size_t slots() const {
+        return slots_per_sector() * _storage.sectors();
+    }
+
+    // Slot that will be used by the next append()
+    size_t next() const {
+        return _next;
+    }
+
+    uint32_t sequence() const {
+        return _sequence;
+    }
+
+    size_t erases() const {
+        return _erases;
+    }
+
+    // Find the record with the highest sequence number. Sequence is a 32bit counter, even when
+    // written every second it would take >100 years to overflow, so the wrap-around is not handled
+    bool recover(Record& out) {
+        bool found { false };
+
+        _next = 0;
+        _sequence = 0;
+
+        Record record;
+        for (size_t slot = 0; slot < slots(); ++slot) {
+            if (!_storage.read(offset(slot), record) || !valid(record)) {
+                continue;
+            }
+
+            if (!found || (record.sequence > _sequence)) {
+                found = true;
+                out = record;
+                _sequence = record.sequence;
+                _next = (slot + 1) % slots();
+            }
+        }
+
+        return found;
+    }
+
+    // Sequence and crc are filled automatically
+    bool append(const std::array<Entry, Entries>& entries) {
+        if (!slots()) {
+            return false;
+        }
+
+        Record record;
+        record.sequence = _sequence + 1;
+        record.entries = entries;
+        record.crc = crc32(record);
+
+        // Either this is the start of the sector (which still contains the oldest records), or the
+        // slot has some garbage in it (e.g. partially written record after a power loss, or the
+        // journal was just moved here). Both cases continue with the freshly erased sector
+        auto slot = _next;
+        if (!prepare(slot)) {
+            return false;
+        }
+
+        if (!_storage.write(offset(slot), record)) {
+            return false;
+        }
+
+        _sequence = record.sequence;
+        _next = (slot + 1) % slots();
+
+        return true;
+    }
+
+private:
+    size_t offset(size_t slot) const {
+        const auto sector = slot / slots_per_sector();
+        const auto index = slot % slots_per_sector();
+        return (sector * _storage.sector_size()) + (index * sizeof(Record));
+    }
+
+    bool erase(size_t slot) {
+        ++_erases;
+        return _storage.erase(slot / slots_per_sector());
+    }
+
+    bool prepare(size_t& slot) {
+        if ((slot % slots_per_sector()) == 0) {
+            return erase(slot);
+        }
+
+        Record record;
+        if (_storage.read(offset(slot), record) && empty(record)) {
+            return true;
+        }
+
+        slot = ((slot / slots_per_sector()) + 1) * slots_per_sector();
+        slot %= slots();
+
+        return erase(slot);
+    }
+
+    Storage& _storage;
+
+    uint32_t _sequence { 0 };
+    size_t _next { 0 };
+    size_t _erases { 0 };
+};
+
+} // namespace
+} // namespace journal
+} // namespace energy
+} // namespace sensor
+} // namespace espurna
@@ -127,9 +127,12 @@ class BH1750Sensor : public I2CSensor<> {
 
             _mtreg = mtime_to_reg(sensitivity_to_mtime(_sensitivity));
             _modereg = mode_to_reg(_mode);
+            _reading.ready = false;
+            _refresh = false;
 
             _init();
             _wait();
+            _last_pre = _wait_start;
 
             _ready = true;
             _dirty = false;
@@ -154,22 +157,38 @@ class BH1750Sensor : public I2CSensor<> {
 
         // Loop-like method, call it in your main loop
         virtual void tick() {
-            if (_wait_reading && (TimeSource::now() - _wait_start) > _wait_duration) {
+            const auto now = TimeSource::now();
+            if (_wait_reading && (now - _wait_start) > _wait_duration) {
                 _wait_reading = false;
+                _request();
+                return;
+            }
+
+            // queue might be full, try again on the next tick
+            if (_refresh && (now - _last_pre) >= _refresh_after) {
+                _request();
+                _refresh = !_reading.pending;
             }
         }
 
         // Pre-read hook (usually to populate registers with up-to-date data)
+        // Value is read through the I2C queue. In one-time modes, it is requested after the measurement time.
+        // In continuous modes, sensor keeps measuring by itself and the value is requested one measurement
+        // time before the next pre() is expected, based on the time between the last two calls
         void pre() override {
             _error = SENSOR_ERROR_OK;
-            if (_wait_reading) {
+            if (_wait_reading || !_reading.ready) {
                 _error = SENSOR_ERROR_NOT_READY;
+                if (!_wait_reading) {
+                    _request();
+                }
                 return;
             }
 
-            const auto lux = _read_lux(lockedAddress());
+            const auto lux = _read_lux();
             if (!lux.ok) {
                 _error = SENSOR_ERROR_NOT_READY;
+                _reading.ready = false;
                 _init();
                 _wait();
                 return;
@@ -186,10 +205,12 @@ class BH1750Sensor : public I2CSensor<> {
             case Mode::OneTimeHighRes:
             case Mode::OneTimeHighRes2:
             case Mode::OneTimeLowRes:
+                _reading.ready = false;
                 _init();
                 _wait();
                 break;
             default:
+                _schedule();
                 break;
             }
         }
@@ -255,14 +276,42 @@ class BH1750Sensor : public I2CSensor<> {
             bool ok;
         };
 
-        Lux _read_lux(uint8_t address) {
+        Lux _read_lux() const {
             Lux out;
-            out.value = i2c_read_uint16(address);
-            out.ok = out.value != 0xffff;
+            out.value = (_reading.buffer[0] << 8) | _reading.buffer[1];
+            out.ok = (_reading.status == 0) && (out.value != 0xffff);
 
             return out;
         }
 
+        // Previous reading is kept until the new one is done. When expected time is wrong
+        // (e.g. after an out-of-cycle read), pre() receives an older value instead of none
+        void _schedule() {
+            const auto now = TimeSource::now();
+            const auto interval = now - _last_pre;
+            _last_pre = now;
+
+            _refresh_after = (interval > _wait_duration)
+                ? (interval - _wait_duration)
+                : TimeSource::duration::zero();
+            _refresh = true;
+        }
+
+        // Buffer is a member, nothing else has to be kept alive until the transaction is done
+        void _request() {
+            if (_reading.pending) {
+                return;
+            }
+
+            _reading.pending = i2cSubmitRead(lockedAddress(),
+                _reading.buffer, sizeof(_reading.buffer),
+                [this](uint8_t status) {
+                    _reading.status = status;
+                    _reading.pending = false;
+                    _reading.ready = true;
+                });
+        }
+
         // pg. 11/17
         // > The below formula is to calculate illuminance per 1 count.
         // >   H-reslution mode : Illuminance per 1 count ( lx / count ) = 1 / 1.2 *( 69 / X )
@@ -285,6 +334,19 @@ class BH1750Sensor : public I2CSensor<> {
         TimeSource::duration _wait_duration;
         bool _wait_reading = false;
 
+        TimeSource::time_point _last_pre;
+        TimeSource::duration _refresh_after;
+        bool _refresh = false;
+
+        struct Reading {
+            uint8_t buffer[2];
+            uint8_t status;
+            bool pending;
+            bool ready;
+        };
+
+        Reading _reading{};
+
         MeasurementTime _mtreg;
         uint8_t _modereg;
 
@@ -12,6 +12,257 @@
 
 #include "../libs/fs_math.h"
 
+#include <array>
+#include <memory>
+
+namespace espurna {
+namespace sensor {
+namespace emon {
+
+// Both kernels implement the same digital low pass filter extracting the VDC offset,
+// accumulating the squares of the remaining AC component. Results are in ADC counts.
+enum class Kernel {
+    Float,
+    Fixed,
+};
+
+static constexpr Kernel DefaultKernel {
+    EMON_FIXED_POINT ? Kernel::Fixed : Kernel::Float };
+
+static constexpr bool DefaultBackground { EMON_BACKGROUND_SAMPLING == 1 };
+
+struct Samples {
+    double pivot;
+    double rms;
+    int min;
+    int max;
+};
+
+// Nothing was sampled, pivot is kept as-is
+inline Samples empty(double pivot) {
+    const auto value = static_cast<int>(pivot);
+    return Samples{
+        .pivot = pivot,
+        .rms = 0.0,
+        .min = value,
+        .max = value,
+    };
+}
+
+// Reference implementation, everything is done with doubles
+class FloatKernel {
+public:
+    FloatKernel(double pivot, size_t) :
+        _pivot(pivot)
+    {}
+
+    void push(int sample) {
+        if (sample > _max) _max = sample;
+        if (sample < _min) _min = sample;
+
+        _pivot = (_pivot + (sample - _pivot) / EMON_FILTER_SPEED);
+
+        const double filtered = sample - _pivot;
+        _sum += (filtered * filtered);
+        ++_count;
+    }
+
+    Samples result() const {
+        if (!_count) {
+            return empty(_pivot);
+        }
+
+        return Samples{
+            .pivot = _pivot,
+            .rms = fs_sqrt(_sum / _count),
+            .min = _min,
+            .max = _max,
+        };
+    }
+
+    size_t count() const {
+        return _count;
+    }
+
+private:
+    double _pivot;
+    double _sum { 0.0 };
+    size_t _count { 0 };
+
+    int _min { std::numeric_limits<int>::max() };
+    int _max { std::numeric_limits<int>::min() };
+};
+
+// Integer implementation, avoiding software floating point math in the sampling loop.
+// Pivot is stored as a signed Q-number, with the fractional part width depending on the ADC resolution
+// (making sure both sample and the difference fit into 32bit). Squares are accumulated with 4 fractional
+// bits of precision, which is enough for 16bit ADC and 1000s of samples to fit into the 64bit sum.
+class FixedKernel {
+public:
+    static constexpr int SquareBits { 4 };
+
+    FixedKernel(double pivot, size_t resolution) :
+        _shift(fractional(resolution)),
+        _pivot(std::lround(pivot * static_cast<double>(int32_t(1) << _shift)))
+    {}
+
+    void push(int sample) {
+        if (sample > _max) _max = sample;
+        if (sample < _min) _min = sample;
+
+        const int32_t value = static_cast<int32_t>(sample) << _shift;
+        _pivot += (value - _pivot) / EMON_FILTER_SPEED;
+
+        const int32_t filtered = (value - _pivot) >> (_shift - SquareBits);
+        _sum += static_cast<uint64_t>(
+            static_cast<int64_t>(filtered) * static_cast<int64_t>(filtered));
+        ++_count;
+    }
+
+    Samples result() const {
+        const auto pivot = static_cast<double>(_pivot)
+            / static_cast<double>(int32_t(1) << _shift);
+        if (!_count) {
+            return empty(pivot);
+        }
+
+        return Samples{
+            .pivot = pivot,
+            .rms = fs_sqrt(static_cast<double>(_sum / _count))
+                / static_cast<double>(1 << SquareBits),
+            .min = _min,
+            .max = _max,
+        };
+    }
+
+    size_t count() const {
+        return _count;
+    }
+
+private:
+    static int fractional(size_t resolution) {
+        constexpr int Min { SquareBits };
+        constexpr int Max { 30 - 8 };
+
+        return std::clamp(30 - static_cast<int>(resolution), Min, Max);
+    }
+
+    int _shift;
+    int32_t _pivot;
+    uint64_t _sum { 0 };
+    size_t _count { 0 };
+
+    int _min { std::numeric_limits<int>::max() };
+    int _max { std::numeric_limits<int>::min() };
+};
+
+// Feed the kernel with samples from the generator
+template <typename T, typename Generator>
+Samples sample(double pivot, size_t resolution, size_t samples, Generator&& generator) {
+    T kernel(pivot, resolution);
+    for (size_t i = 0; i < samples; ++i) {
+        kernel.push(generator());
+    }
+
+    return kernel.result();
+}
+
+// Persistent kernel state, when samples are pushed in chunks instead of all at once
+class Accumulator {
+public:
+    Accumulator(Kernel kernel, double pivot, size_t resolution) :
+        _kernel(kernel),
+        _float(pivot, resolution),
+        _fixed(pivot, resolution)
+    {}
+
+    void push(int sample) {
+        if (_kernel == Kernel::Fixed) {
+            _fixed.push(sample);
+        } else {
+            _float.push(sample);
+        }
+    }
+
+    Samples result() const {
+        return (_kernel == Kernel::Fixed)
+            ? _fixed.result()
+            : _float.result();
+    }
+
+    size_t count() const {
+        return (_kernel == Kernel::Fixed)
+            ? _fixed.count()
+            : _float.count();
+    }
+
+private:
+    Kernel _kernel;
+    FloatKernel _float;
+    FixedKernel _fixed;
+};
+
+// Raw ADC values storage for the background sampling. Timer callback is the only producer and fills
+// one half, while the other half (once full) is waiting for the sensor tick() to consume it.
+// When both halves are full, new samples are dropped until the consumer catches up.
+class Buffer {
+public:
+    using Value = uint16_t;
+    static constexpr size_t Size { EMON_BACKGROUND_BUFFER_SIZE };
+
+    bool push(Value value) {
+        auto& half = _halves[_front];
+        if (half.ready) {
+            ++_overruns;
+            return false;
+        }
+
+        half.data[half.size++] = value;
+        if (half.size == Size) {
+            half.ready = true;
+            _front ^= 1;
+        }
+
+        return true;
+    }
+
+    template <typename T>
+    bool consume(T&& callback) {
+        auto& half = _halves[_back];
+        if (!half.ready) {
+            return false;
+        }
+
+        callback(half.data.data(), half.data.data() + half.size);
+
+        half.size = 0;
+        half.ready = false;
+        _back ^= 1;
+
+        return true;
+    }
+
+    size_t overruns() const {
+        return _overruns;
+    }
+
+private:
+    struct Half {
+        std::array<Value, Size> data;
+        size_t size { 0 };
+        bool ready { false };
+    };
+
+    Half _halves[2];
+    size_t _front { 0 };
+    size_t _back { 0 };
+    size_t _overruns { 0 };
+};
+
+} // namespace emon
+} // namespace sensor
+} // namespace espurna
+
 class BaseAnalogEmonSensor : public BaseEmonSensor {
 public:
     static const BaseSensor::ClassKind Kind;
@@ -68,6 +319,35 @@ public:
         _dirty = true;
     }
 
+    void setKernel(espurna::sensor::emon::Kernel kernel) {
+        _kernel = kernel;
+        resetAccumulator();
+    }
+
+    espurna::sensor::emon::Kernel getKernel() const {
+        return _kernel;
+    }
+
+    // Instead of sampling in pre(), samples are captured by the sampling timer
+    // and accumulated in tick(). Results are available at the next reading.
+    // Timer callback runs in SYS context, analogRead() implementation must not block, yield or
+    // use any shared bus. Meaning, only the internal ADC is allowed and *not* I2C ones.
+    void setBackground(bool value) {
+        if (value && !_buffer) {
+            _buffer = std::make_unique<espurna::sensor::emon::Buffer>();
+        } else if (!value) {
+            _buffer.reset();
+        }
+    }
+
+    bool background() const {
+        return static_cast<bool>(_buffer);
+    }
+
+    size_t overruns() const {
+        return _buffer ? _buffer->overruns() : 0;
+    }
+
     void setResolution(size_t resolution) {
         _resolution = resolution;
         _adc_counts = 1 << _resolution;
@@ -82,6 +362,7 @@ public:
         updateCurrent(0.0);
         setPivot(_adc_counts >> 1); // aka divide by 2
         calculateFactors();
+        resetAccumulator();
 
         _ready = true;
         _dirty = false;
@@ -98,8 +379,49 @@ public:
 #endif
     }
 
+    // Called by the sampling timer, should only be used when background sampling is enabled.
+    void capture() {
+        for (size_t sample = 0; sample < EMON_BACKGROUND_SAMPLES; ++sample) {
+            if (!_buffer->push(this->analogRead())) {
+                break;
+            }
+        }
+    }
+
+    void tick() override {
+        if (!_buffer) {
+            return;
+        }
+
+        while (_buffer->consume(
+            [&](const espurna::sensor::emon::Buffer::Value* begin,
+                const espurna::sensor::emon::Buffer::Value* end)
+            {
+                for (auto it = begin; it != end; ++it) {
+                    _accumulator.push(*it);
+                }
+            }))
+        {
+        }
+    }
+
     void pre() override {
-        updateCurrent(sampleCurrent());
+        if (_buffer) {
+            tick();
+            if (!_accumulator.count()) {
+                _error = SENSOR_ERROR_WARM_UP;
+                return;
+            }
+
+#if SENSOR_DEBUG
+            DEBUG_MSG_P(PSTR("[EMON] Background samples: %zu, overruns: %zu\n"),
+                _accumulator.count(), _buffer->overruns());
+#endif
+            updateCurrent(currentFrom(_accumulator.result()));
+            resetAccumulator();
+        } else {
+            updateCurrent(sampleCurrent());
+        }
 
         const auto now = TimeSource::now();
         if (!_initial) {
@@ -137,40 +459,53 @@ public:
     }
 
     double sampleCurrent() {
-        int max = 0;
-        int min = _adc_counts;
-        double sum = 0;
+        using namespace espurna::sensor::emon;
 
-        auto pivot = getPivot();
+        auto generator = [this]() -> int {
+            return this->analogRead();
+        };
 
         const auto time_span = TimeSource::now();
-        for (size_t i = 0; i < _samples; i++) {
-            int sample;
-            double filtered;
 
-            sample = this->analogRead();
-            if (sample > max) max = sample;
-            if (sample < min) min = sample;
+        const auto result = (_kernel == Kernel::Fixed)
+            ? sample<FixedKernel>(getPivot(), _resolution, _samples, generator)
+            : sample<FloatKernel>(getPivot(), _resolution, _samples, generator);
 
-            // Digital low pass filter extracts the VDC offset
-            pivot = (pivot + (sample - pivot) / EMON_FILTER_SPEED);
-            filtered = sample - pivot;
+        const auto elapsed = TimeSource::now() - time_span;
+        const auto current = currentFrom(result);
 
-            // Root-mean-square method
-            sum += (filtered * filtered);
+#if SENSOR_DEBUG
+        DEBUG_MSG_P(PSTR("[EMON] Total samples: %d\n"), _samples);
+        DEBUG_MSG_P(PSTR("[EMON] Total time (ms): %u\n"), elapsed.count());
+        DEBUG_MSG_P(PSTR("[EMON] Sample frequency (Hz): %d\n"), int(1000 * _samples / elapsed.count()));
+#endif
+
+        if ((elapsed > MaxTime)
+            || ((elapsed < MaxTime) && (_samples < _samples_max)))
+        {
+            _samples = (_samples * MaxTime.count()) / elapsed.count();
         }
 
-        const auto elapsed = TimeSource::now() - time_span;
+        return current;
+    }
+
+    void resetAccumulator() {
+        _accumulator = espurna::sensor::emon::Accumulator(
+            _kernel, getPivot(), _resolution);
+    }
 
+    // Update pivot and calculate current from the sampling results
+    double currentFrom(const espurna::sensor::emon::Samples& result) {
         // Quick fix
-        if (pivot < min || max < pivot) {
-            pivot = (max + min) / 2.0;
+        auto pivot = result.pivot;
+        if (pivot < result.min || result.max < pivot) {
+            pivot = (result.max + result.min) / 2.0;
         }
 
         setPivot(pivot);
 
         // Calculate current
-        double rms = _samples > 0 ? fs_sqrt(sum / _samples) : 0;
+        const double rms = result.rms;
         double current = _current_factor * rms;
 
         current = (double) (int(current * _multiplier) - 1) / _multiplier;
@@ -179,22 +514,13 @@ public:
         }
 
 #if SENSOR_DEBUG
-        DEBUG_MSG_P(PSTR("[EMON] Total samples: %d\n"), _samples);
-        DEBUG_MSG_P(PSTR("[EMON] Total time (ms): %u\n"), elapsed.count());
-        DEBUG_MSG_P(PSTR("[EMON] Sample frequency (Hz): %d\n"), int(1000 * _samples / elapsed.count()));
-        DEBUG_MSG_P(PSTR("[EMON] Max value: %d\n"), max);
-        DEBUG_MSG_P(PSTR("[EMON] Min value: %d\n"), min);
+        DEBUG_MSG_P(PSTR("[EMON] Max value: %d\n"), result.max);
+        DEBUG_MSG_P(PSTR("[EMON] Min value: %d\n"), result.min);
         DEBUG_MSG_P(PSTR("[EMON] Midpoint value: %d\n"), int(getPivot()));
         DEBUG_MSG_P(PSTR("[EMON] RMS value: %d\n"), int(rms));
         DEBUG_MSG_P(PSTR("[EMON] Current (mA): %d\n"), int(1000 * current));
 #endif
 
-        if ((elapsed > MaxTime)
-            || ((elapsed < MaxTime) && (_samples < _samples_max)))
-        {
-            _samples = (_samples * MaxTime.count()) / elapsed.count();
-        }
-
         return current;
     }
 
@@ -223,6 +549,13 @@ private:
     size_t _samples_max { EMON_MAX_SAMPLES };       // Number of samples, will be adjusted at runtime
     size_t _samples { _samples_max };               // based on the maximum value
 
+    espurna::sensor::emon::Kernel _kernel {         // Sampling loop implementation
+        espurna::sensor::emon::DefaultKernel };
+
+    std::unique_ptr<espurna::sensor::emon::Buffer> _buffer;         // Background sampling storage
+    espurna::sensor::emon::Accumulator _accumulator {               // and the running results
+        _kernel, 0.0, EMON_ANALOG_RESOLUTION };
+
     size_t _resolution { EMON_ANALOG_RESOLUTION };  // ADC resolution (in bits)
     size_t _adc_counts { static_cast<size_t>(1) << _resolution };       // Max count
 };
@@ -14,6 +14,10 @@
 
 class EmonAnalogSensor : public SimpleAnalogEmonSensor {
 public:
+    EmonAnalogSensor() {
+        setBackground(espurna::sensor::emon::DefaultBackground);
+    }
+
     // ---------------------------------------------------------------------
     // Sensor API
     // ---------------------------------------------------------------------
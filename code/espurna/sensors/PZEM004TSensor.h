@@ -64,6 +64,7 @@
 
 #include "BaseSensor.h"
 #include "BaseEmonSensor.h"
+#include "SerialPoller.h"
 
 #include "../sensor.h"
 #include "../terminal.h"
@@ -120,58 +121,65 @@ public:
     bool setAddress(const IPAddress &newAddr);
     bool setPowerAlarm(const IPAddress &addr, uint8_t threshold);
 
+    static PZEMCommand command(const IPAddress &addr, uint8_t cmd, uint8_t data = 0);
+    static float value(uint8_t resp, const uint8_t *data);
+    static uint8_t crc(const uint8_t *data, uint8_t sz);
+
 private:
     Stream* _serial;
     unsigned long _readTimeOut = PZEM_DEFAULT_READ_TIMEOUT;
 
+    float read(const IPAddress &addr, uint8_t cmd, uint8_t resp);
+
     void send(const IPAddress &addr, uint8_t cmd, uint8_t data = 0);
     bool receive(uint8_t resp, uint8_t *data = 0);
-
-    uint8_t crc(uint8_t *data, uint8_t sz);
 };
 
 float PZEM004T::voltage(const IPAddress &addr)
 {
-    uint8_t data[RESPONSE_DATA_SIZE];
-
-    send(addr, PZEM_VOLTAGE);
-    if(!receive(RESP_VOLTAGE, data))
-        return PZEM_ERROR_VALUE;
-
-    return (data[0] << 8) + data[1] + (data[2] / 10.0);
+    return read(addr, PZEM_VOLTAGE, RESP_VOLTAGE);
 }
 
 float PZEM004T::current(const IPAddress &addr)
 {
-    uint8_t data[RESPONSE_DATA_SIZE];
-
-    send(addr, PZEM_CURRENT);
-    if(!receive(RESP_CURRENT, data))
-        return PZEM_ERROR_VALUE;
-
-    return (data[0] << 8) + data[1] + (data[2] / 100.0);
+    return read(addr, PZEM_CURRENT, RESP_CURRENT);
 }
 
 float PZEM004T::power(const IPAddress &addr)
 {
-    uint8_t data[RESPONSE_DATA_SIZE];
-
-    send(addr, PZEM_POWER);
-    if(!receive(RESP_POWER, data))
-        return PZEM_ERROR_VALUE;
-
-    return (data[0] << 8) + data[1];
+    return read(addr, PZEM_POWER, RESP_POWER);
 }
 
 float PZEM004T::energy(const IPAddress &addr)
+{
+    return read(addr, PZEM_ENERGY, RESP_ENERGY);
+}
+
+float PZEM004T::read(const IPAddress &addr, uint8_t cmd, uint8_t resp)
 {
     uint8_t data[RESPONSE_DATA_SIZE];
 
-    send(addr, PZEM_ENERGY);
-    if(!receive(RESP_ENERGY, data))
+    send(addr, cmd);
+    if(!receive(resp, data))
         return PZEM_ERROR_VALUE;
 
-    return ((uint32_t)data[0] << 16) + ((uint16_t)data[1] << 8) + data[2];
+    return value(resp, data);
+}
+
+float PZEM004T::value(uint8_t resp, const uint8_t *data)
+{
+    switch (resp) {
+    case RESP_VOLTAGE:
+        return (data[0] << 8) + data[1] + (data[2] / 10.0);
+    case RESP_CURRENT:
+        return (data[0] << 8) + data[1] + (data[2] / 100.0);
+    case RESP_POWER:
+        return (data[0] << 8) + data[1];
+    case RESP_ENERGY:
+        return ((uint32_t)data[0] << 16) + ((uint16_t)data[1] << 8) + data[2];
+    }
+
+    return PZEM_ERROR_VALUE;
 }
 
 bool PZEM004T::setAddress(const IPAddress &newAddr)
@@ -186,7 +194,7 @@ bool PZEM004T::setPowerAlarm(const IPAddress &addr, uint8_t threshold)
     return receive(RESP_POWER_ALARM);
 }
 
-void PZEM004T::send(const IPAddress &addr, uint8_t cmd, uint8_t data)
+PZEMCommand PZEM004T::command(const IPAddress &addr, uint8_t cmd, uint8_t data)
 {
     PZEMCommand pzem;
 
@@ -195,14 +203,21 @@ void PZEM004T::send(const IPAddress &addr, uint8_t cmd, uint8_t data)
         pzem.addr[i] = addr[i];
     pzem.data = data;
 
-    uint8_t *bytes = (uint8_t*)&pzem;
+    const uint8_t *bytes = (const uint8_t*)&pzem;
     pzem.crc = crc(bytes, sizeof(pzem) - 1);
 
+    return pzem;
+}
+
+void PZEM004T::send(const IPAddress &addr, uint8_t cmd, uint8_t data)
+{
+    const auto pzem = command(addr, cmd, data);
+
     while (_serial->available()) {
         _serial->read();
     }
 
-    _serial->write(bytes, sizeof(pzem));
+    _serial->write((const uint8_t*)&pzem, sizeof(pzem));
 }
 
 bool PZEM004T::receive(uint8_t resp, uint8_t *data)
@@ -241,7 +256,7 @@ bool PZEM004T::receive(uint8_t resp, uint8_t *data)
     return true;
 }
 
-uint8_t PZEM004T::crc(uint8_t *data, uint8_t sz)
+uint8_t PZEM004T::crc(const uint8_t *data, uint8_t sz)
 {
     uint16_t crc = 0;
     for(uint8_t i=0; i<sz; i++)
@@ -249,16 +264,14 @@ uint8_t PZEM004T::crc(uint8_t *data, uint8_t sz)
     return (uint8_t)(crc & 0xFF);
 }
 
-class PZEM004TSensor : public BaseEmonSensor {
+class PZEM004TSensor : public BaseEmonSensor, public SerialPoller::Device {
 private:
     // Track instances returned by 'make()' in a singly linked list
     // Compared to stdlib's forward_list, head and tail are reversed
-    static PZEM004TSensor* _current_instance;
     static PZEM004TSensor* _head_instance;
-    PZEM004TSensor* _next_instance;
+    PZEM004TSensor* _next_instance { nullptr };
 
     using TimeSource = espurna::time::CoreClock;
-    static TimeSource::time_point _last_read;
 
     template <typename T>
     static void foreach(T&& callback) {
@@ -284,6 +297,7 @@ private:
 
 public:
     static constexpr TimeSource::duration ReadInterval { PZEM004T_READ_INTERVAL };
+    static constexpr TimeSource::duration ReadTimeout { PZEM004T_READ_TIMEOUT };
     static constexpr size_t DevicesMax { PZEM004T_DEVICES_MAX };
 
     static IPAddress defaultAddress(size_t device) {
@@ -301,80 +315,34 @@ public:
         return out;
     }
 
+    // Blocking PZEM004T methods are only used for the terminal commands,
+    // values are read through the poller by every device on the port
     struct SerialPort {
-        using PzemPtr = std::unique_ptr<PZEM004T>;
-
         SerialPort() = delete;
 
-        explicit SerialPort(PzemPtr pzem) :
-            _pzem(std::move(pzem))
-        {}
-
-        explicit SerialPort(Stream* stream) :
-            _pzem(std::make_unique<PZEM004T>(stream))
-        {}
-
-        float read(const IPAddress& address, unsigned char magnitude) {
-            switch (magnitude) {
-            case MAGNITUDE_CURRENT:
-                return _pzem->current(address);
-            case MAGNITUDE_VOLTAGE:
-                return _pzem->voltage(address);
-            case MAGNITUDE_POWER_ACTIVE:
-                return _pzem->power(address);
-            case MAGNITUDE_ENERGY:
-                return _pzem->energy(address);
-            }
-
-            return ErrorValue;
+        SerialPort(Stream* stream, TimeSource::duration timeout) :
+            _pzem(stream),
+            _poller(stream, timeout)
+        {
+            _pzem.setReadTimeout(timeout.count());
         }
 
-        bool read(Reading& reading, const IPAddress& address, unsigned char magnitude) {
-            if (_busy) {
-                return false;
-            }
-
-            _busy = true;
-
-            auto value = read(address, magnitude);
-
-            switch (magnitude) {
-            case MAGNITUDE_CURRENT:
-                reading.current = value;
-                break;
-            case MAGNITUDE_VOLTAGE:
-                reading.voltage = value;
-                break;
-            case MAGNITUDE_POWER_ACTIVE:
-                reading.power = value;
-                break;
-            case MAGNITUDE_ENERGY:
-                reading.energy = value;
-                break;
-            }
-
-            _busy = false;
-            return (value != ErrorValue);
+        SerialPoller& poller() {
+            return _poller;
         }
 
-        template <typename T>
-        bool read(Reading& reading, const IPAddress& address, T begin, T end) {
-            for (auto it = begin; it != end; ++it) {
-                if (!read(reading, address, *it)) {
-                    return false;
-                }
-            }
-
-            return true;
+        void tick() {
+            _poller.tick();
         }
 
         bool address(const IPAddress& address) {
-            return _pzem->setAddress(address);
+            _poller.abort();
+            return _pzem.setAddress(address);
         }
 
     private:
-        PzemPtr _pzem;
-        bool _busy { false };
+        PZEM004T _pzem;
+        SerialPoller _poller;
     };
 
     using PortPtr = std::shared_ptr<SerialPort>;
@@ -384,7 +352,9 @@ private:
         BaseEmonSensor(Magnitudes),
         _port(port),
         _address(address)
-    {}
+    {
+        _port->poller().add(this);
+    }
 
 public:
     using BaseEmonSensor::type;
@@ -416,7 +386,7 @@ public:
                 : &_head_instance;
 
             *target = new PZEM004TSensor(port, address);
-            _current_instance = *target;
+            addPort(port);
 
             return *target;
         }
@@ -448,6 +418,7 @@ public:
     void setAddress(const IPAddress& address) {
         _address = address;
         _reading = Reading{};
+        _step = 0;
         _dirty = true;
     }
 
@@ -539,36 +510,86 @@ public:
         return response;
     }
 
-    // Post-read hook (usually to reset things)
-    void post() override {
-        _error = SENSOR_ERROR_OK;
+    // Requests of every device sharing the port are sent back-to-back. Values and
+    // the error status are only updated after all of the magnitudes were received
+    void tick() override {
+        _port->tick();
     }
 
-    // Loop-like method, call it in your main loop
-    void tick() override {
+    // ---------------------------------------------------------------------
+    // Serial poller
+    // ---------------------------------------------------------------------
+
+    size_t request(uint8_t* buffer, size_t size) override {
         static_assert(std::size(Magnitudes) > 0, "");
-        if (!_head_instance || (_current_instance != this)) {
-            return;
+        static_assert(sizeof(PZEMCommand) <= SerialPoller::BufferSize, "");
+
+        if (size < sizeof(PZEMCommand)) {
+            return 0;
         }
 
-        // Current approach is to spread our reads of mutliple instances,
-        // instead of doing them in the same time slot.
-        if (TimeSource::now() - _last_read < ReadInterval) {
-            return;
+        if ((0 == _step) && (TimeSource::now() - _last_read < ReadInterval)) {
+            return 0;
         }
 
-        for (const auto& magnitude : Magnitudes) {
-            if (!_port->read(_reading, _address, magnitude.type)) {
-                _error = SENSOR_ERROR_TIMEOUT;
-                break;
-            }
-            yield();
+        if (0 == _step) {
+            _last_read = TimeSource::now();
+        }
+
+        const auto pzem = PZEM004T::command(_address, command(Magnitudes[_step].type));
+        std::memcpy(buffer, &pzem, sizeof(pzem));
+        _reply_size = 0;
+
+        return sizeof(pzem);
+    }
+
+    SerialPoller::Result receive(uint8_t c) override {
+        // skip 0 at startup
+        if (!c && !_reply_size) {
+            return SerialPoller::Result::Pending;
+        }
+
+        _reply[_reply_size++] = c;
+        if (_reply_size < RESPONSE_SIZE) {
+            return SerialPoller::Result::Pending;
+        }
+
+        const auto type = Magnitudes[_step].type;
+        const uint8_t response = command(type) - 0x10;
+        if ((_reply[RESPONSE_SIZE - 1] != PZEM004T::crc(_reply, RESPONSE_SIZE - 1))
+            || (_reply[0] != response))
+        {
+            failed(SENSOR_ERROR_CRC);
+            return SerialPoller::Result::Error;
+        }
+
+        const auto value = PZEM004T::value(response, &_reply[1]);
+        switch (type) {
+        case MAGNITUDE_CURRENT:
+            _pending.current = value;
+            break;
+        case MAGNITUDE_VOLTAGE:
+            _pending.voltage = value;
+            break;
+        case MAGNITUDE_POWER_ACTIVE:
+            _pending.power = value;
+            break;
+        case MAGNITUDE_ENERGY:
+            _pending.energy = value;
+            break;
         }
 
-        _last_read = TimeSource::now();
-        _current_instance = (_current_instance->_next_instance)
-            ? _current_instance->_next_instance
-            : _head_instance;
+        _step = (_step + 1) % std::size(Magnitudes);
+        if (0 == _step) {
+            _reading = _pending;
+            _error = SENSOR_ERROR_OK;
+        }
+
+        return SerialPoller::Result::Done;
+    }
+
+    void timeout() override {
+        failed(SENSOR_ERROR_TIMEOUT);
     }
 
 #if TERMINAL_SUPPORT
@@ -577,6 +598,38 @@ public:
     static void command_address(::terminal::CommandContext&&);
 #endif
 private:
+    static uint8_t command(unsigned char type) {
+        switch (type) {
+        case MAGNITUDE_CURRENT:
+            return PZEM_CURRENT;
+        case MAGNITUDE_VOLTAGE:
+            return PZEM_VOLTAGE;
+        case MAGNITUDE_POWER_ACTIVE:
+            return PZEM_POWER;
+        case MAGNITUDE_ENERGY:
+            return PZEM_ENERGY;
+        }
+
+        return 0;
+    }
+
+    // Start over on the next interval
+    void failed(unsigned char error) {
+        _error = error;
+        _step = 0;
+        _pending = Reading{};
+    }
+
+    static void addPort(const PortPtr& port) {
+        for (auto& ptr : _ports) {
+            if (ptr.lock() == port) {
+                return;
+            }
+        }
+
+        _ports.push_back(port);
+    }
+
     PortPtr _port;
     using PortWeakPtr = std::weak_ptr<PortPtr::element_type>;
     using Ports = std::vector<PortWeakPtr>;
@@ -584,10 +637,19 @@ private:
 
     IPAddress _address;
     Reading _reading;
+
+    Reading _pending;
+    size_t _step { 0 };
+    TimeSource::time_point _last_read { TimeSource::now() - ReadInterval };
+
+    uint8_t _reply[RESPONSE_SIZE];
+    size_t _reply_size { 0 };
 };
 
 #ifndef __cpp_inline_variables
 constexpr BaseEmonSensor::Magnitude PZEM004TSensor::Magnitudes[];
+constexpr PZEM004TSensor::TimeSource::duration PZEM004TSensor::ReadInterval;
+constexpr PZEM004TSensor::TimeSource::duration PZEM004TSensor::ReadTimeout;
 #endif
 
 #if TERMINAL_SUPPORT
@@ -698,9 +760,6 @@ void PZEM004TSensor::registerTerminalCommands() {
 #endif
 }
 
-PZEM004TSensor::TimeSource::time_point PZEM004TSensor::_last_read { PZEM004TSensor::TimeSource::now() - ReadInterval };
-
-PZEM004TSensor* PZEM004TSensor::_current_instance { nullptr };
 PZEM004TSensor* PZEM004TSensor::_head_instance { nullptr };
 
 PZEM004TSensor::Ports PZEM004TSensor::_ports{};
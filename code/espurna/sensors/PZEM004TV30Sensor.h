@@ -12,12 +12,15 @@ Copyright (C) 2020 by Maxim Prokhorov <prokhorov dot max at outlook dot com>
 */
 
 #include "BaseEmonSensor.h"
+#include "SerialPoller.h"
 
 #include "../utils.h"
 #include "../terminal.h"
 
 #include <cstdint>
 #include <array>
+#include <memory>
+#include <vector>
 
 #if DEBUG_SUPPORT
 #define PZEM_DEBUG_MSG_P(...) do { if (_debug) {\
@@ -27,23 +30,36 @@ Copyright (C) 2020 by Maxim Prokhorov <prokhorov dot max at outlook dot com>
 #define PZEM_DEBUG_MSG_P(...)
 #endif
 
-class PZEM004TV30Sensor : public BaseEmonSensor {
+class PZEM004TV30Sensor : public BaseEmonSensor, public SerialPoller::Device {
 public:
     using TimeSource = espurna::time::CoreClock;
-    using Instance = std::unique_ptr<PZEM004TV30Sensor>;
+    using PollerPtr = std::shared_ptr<SerialPoller>;
+    using Instances = std::vector<PZEM004TV30Sensor*>;
+
+    static constexpr size_t DevicesMax { PZEM004TV30_DEVICES_MAX };
 
     // Note that the device (aka slave) address needs be changed first via
     // - some external tool. For example, using USB2TTL adapter and a PC app
     // - `pzem.address` with **only** one device on the line
     //    (because we would change all 0xf8-addressed devices at the same time)
-    static PZEM004TV30Sensor* make(Stream* port, uint8_t address, TimeSource::duration timeout) {
+    // Every device on the same port shares the poller, requests are sent one after another
+    static PZEM004TV30Sensor* make(PollerPtr poller, uint8_t address) {
         static_assert(std::is_same<TimeSource::duration, espurna::duration::Milliseconds>::value, "");
-        if (!_instance) {
-            _instance.reset(new PZEM004TV30Sensor(port, address, timeout));
-            return _instance.get();
+        if (_instances.size() >= DevicesMax) {
+            return nullptr;
+        }
+
+        for (const auto* instance : _instances) {
+            if (instance->_address == address) {
+                return nullptr;
+            }
         }
 
-        return nullptr;
+        auto* out = new PZEM004TV30Sensor(poller, address);
+        poller->add(out);
+        _instances.push_back(out);
+
+        return out;
     }
 
     // per MODBUS application protocol specification
@@ -161,6 +177,7 @@ public:
         // Note that CRC order is reversed in comparison to every other value
         adu_builder& end() {
             static_assert(BufferSize >= 4, "Cannot fit the minimal request");
+            static_assert(BufferSize <= SerialPoller::BufferSize, "Cannot fit the request into the poller buffer");
             if (!locked) {
                 uint16_t value = crc16modbus(buffer.data(), size);
                 buffer[size] = static_cast<uint8_t>(value & 0xff);
@@ -201,97 +218,115 @@ public:
         }
     }
 
-    template <typename Callback>
-    void modbusProcess(const adu_builder& builder, Callback callback) {
-        if (!builder.locked) {
-            return;
+    // Replies are received incrementally, byte-by-byte, as they appear in the UART buffer.
+    // Since every device on the line receives every reply, anything not matching our address
+    // or the function code of the request is skipped.
+    SerialPoller::Result modbusReceive(uint8_t c) {
+        if ((0 == _reply_size) && (_address != c)) {
+            return SerialPoller::Result::Pending;
         }
 
-        _port->write(builder.buffer.data(), builder.size);
+        if (1 == _reply_size) {
+            const uint8_t code = _request.buffer[1];
+            if ((ErrorMask | code) == c) {
+                _reply_expect = 5;
+            } else if (code != c) {
+                _reply_size = 0;
+                return SerialPoller::Result::Pending;
+            }
+        }
 
-        size_t expect = modbusExpect(builder);
-        if (!expect) {
-            return;
+        _reply[_reply_size++] = c;
+        if (_reply_size < _reply_expect) {
+            return SerialPoller::Result::Pending;
         }
 
-        uint8_t code = builder.buffer[1];
-        uint8_t error_code = ErrorMask | code;
+        return modbusReply();
+    }
 
-        size_t bytes = 0;
+    SerialPoller::Result modbusReply() {
+        if (_debug) {
+            modbusDebugBuffer(F("Received"), _reply, _reply_size);
+        }
 
-        buffer_type buffer;
+        const uint16_t received_crc =
+            static_cast<uint16_t>(_reply[_reply_size - 1] << 8)
+          | static_cast<uint16_t>(_reply[_reply_size - 2]);
+        const uint16_t crc = crc16modbus(_reply.data(), _reply_size - 2);
+        if (received_crc != crc) {
+            PZEM_DEBUG_MSG_P(PSTR("[PZEM004TV3] ERROR: CRC invalid: expected %04X expected, received %04X\n"), crc, received_crc);
+            modbusResult(SENSOR_ERROR_CRC);
+            return SerialPoller::Result::Error;
+        }
 
-        // In case we need multiple devices, we need to manually set each one with an unique address **and** also provide
-        // a way to distinguish between bus messages based on addresses received. Multiple instances **could** work,
-        // based on the idea that we never receive replies from unknown addresses i.e. we never NOT read responses fully
-        // and leave something in the serial buffers.
-        // TODO: testing is much easier, b/c we can just grab any modbus simulator and set up multiple devices
-        const auto ts = TimeSource::now();
-        while ((bytes < expect) && (TimeSource::now() - ts < _read_timeout)) {
-            int c = _port->read();
-            if (c < 0) {
-                continue;
-            }
+        if (_reply[1] & ErrorMask) {
+            PZEM_DEBUG_MSG_P(PSTR("[PZEM004TV3] ERROR: %s (0x%02X)\n"),
+                errorToString(_reply[2]).c_str(), _reply[2]);
+            modbusResult(SENSOR_ERROR_OTHER);
+            return SerialPoller::Result::Error;
+        }
 
-            if ((0 == bytes) && (_address != c)) {
-                continue;
-            }
+        switch (_request.buffer[1]) {
+        case ReadInputCode:
+            modbusReadValues();
+            break;
 
-            if (1 == bytes) {
-                if (error_code == c) {
-                    expect = 5;
-                } else if (code != c) {
-                    bytes = 0;
-                    continue;
-                }
+        // quoting pzem user manual: "Set up correctly, the slave return to the data which is sent from the master."
+        case WriteCode:
+        case ResetEnergyCode:
+            if (!std::equal(_request.buffer.begin(), _request.buffer.begin() + _reply_size, _reply.begin())) {
+                modbusResult(SENSOR_ERROR_OTHER);
+                return SerialPoller::Result::Error;
             }
 
-            buffer[bytes++] = static_cast<uint8_t>(c);
+            modbusResult(SENSOR_ERROR_OK);
+            break;
         }
 
-        if (bytes && _debug) {
-            modbusDebugBuffer(F("Received"), buffer, bytes);
-        }
+        return SerialPoller::Result::Done;
+    }
 
-        if (bytes != expect) {
-            PZEM_DEBUG_MSG_P(PSTR("[PZEM004TV3] ERROR: Expected %u bytes, got %u\n"), expect, bytes);
-            _error = SENSOR_ERROR_OTHER; // TODO: more error codes
-            return;
+    void modbusResult(int error) {
+        switch (_request.buffer[1]) {
+        case ReadInputCode:
+            _error = error;
+            break;
+        case WriteCode:
+            _address_result = (SENSOR_ERROR_OK == error);
+            break;
+        case ResetEnergyCode:
+            PZEM_DEBUG_MSG_P(PSTR("[PZEM004TV3] Energy reset - %s\n"),
+                (SENSOR_ERROR_OK == error) ? PSTR("OK") : PSTR("FAIL"));
+            break;
         }
+    }
 
-        uint16_t received_crc = static_cast<uint16_t>(buffer[bytes - 1] << 8) | static_cast<uint16_t>(buffer[bytes - 2]);
-        uint16_t crc = crc16modbus(buffer.data(), bytes - 2);
-        if (received_crc != crc) {
-            PZEM_DEBUG_MSG_P(PSTR("[PZEM004TV3] ERROR: CRC invalid: expected %04X expected, received %04X\n"), crc, received_crc);
-            _error = SENSOR_ERROR_CRC;
-            return;
+    // Request stays around until the reply is received, since we need to know what to expect
+    size_t modbusRequest(const adu_builder& builder, uint8_t* buffer, size_t size) {
+        if (!builder.locked || (size < builder.size)) {
+            return 0;
         }
 
-        if (buffer[1] & ErrorMask) {
-            PZEM_DEBUG_MSG_P(PSTR("[PZEM004TV3] ERROR: %s (0x%02X)\n"),
-                errorToString(buffer[2]).c_str(), buffer[2]);
-            return;
+        _request = builder;
+        _reply_size = 0;
+        _reply_expect = modbusExpect(builder);
+        if (!_reply_expect) {
+            return 0;
         }
 
-        callback(std::move(buffer), bytes);
+        std::copy(builder.buffer.begin(), builder.buffer.begin() + builder.size, buffer);
+        return builder.size;
     }
 
     // Energy reset is a 'custom' function, and it does not take any function params
-    bool modbusResetEnergy() {
-        const auto request = adu_builder(_address, ResetEnergyCode)
+    adu_builder modbusResetEnergy() const {
+        return adu_builder(_address, ResetEnergyCode)
             .end();
-
-        // quoting pzem user manual: "Set up correctly, the slave return to the data which is sent from the master.",
-        bool result = false;
-        modbusProcess(request, [&](buffer_type&& buffer, size_t size) {
-            result = std::equal(request.buffer.begin(), request.buffer.begin() + size, buffer.begin());
-        });
-
-        return result;
     }
 
     // Address setter is only needed when we are using multiple devices.
     // Note that we would no longer be able to receive replies without changing _address member too
+    // Unlike other requests, this one is sent directly and blocks until the reply is received.
     bool modbusChangeAddress(uint8_t to) {
         if (_address == to) {
             return true;
@@ -302,13 +337,33 @@ public:
             .add(static_cast<uint16_t>(to))
             .end();
 
+        _poller->abort();
+
+        buffer_type buffer;
+        const auto size = modbusRequest(request, buffer.data(), buffer.size());
+        if (!size) {
+            return false;
+        }
+
+        auto* stream = _poller->stream();
+        stream->write(buffer.data(), size);
+
         // same as for resetEnergy, we receive echo
-        bool result = false;
-        modbusProcess(request, [&](buffer_type&& buffer, size_t size) {
-            result = std::equal(request.buffer.begin(), request.buffer.begin() + size, buffer.begin());
-        });
+        _address_result = false;
+
+        auto result = SerialPoller::Result::Pending;
+
+        const auto ts = TimeSource::now();
+        while ((result == SerialPoller::Result::Pending) && (TimeSource::now() - ts < _poller->timeout())) {
+            const int c = stream->read();
+            if (c < 0) {
+                continue;
+            }
+
+            result = modbusReceive(static_cast<uint8_t>(c));
+        }
 
-        return result;
+        return _address_result;
     }
 
     // For more, see MODBUS application protocol specification, 7 MODBUS Exception Responses
@@ -446,30 +501,57 @@ public:
     // ReadInput reply can be one of:
     // - addr, 0x04, nbytes, rndatahigh, rndatalow, rndata..., crchigh, crclow (on success)
     // - addr, 0x84, error_code, crchigh, crclow (on error. modbus rtu sets high bit to 1 i.e. 0b00000100 becomes 0b10000100)
-    void modbusReadValues() {
-        _error = SENSOR_ERROR_OK;
-
-        const auto request = adu_builder(_address, ReadInputCode)
+    adu_builder modbusReadValuesRequest() const {
+        return adu_builder(_address, ReadInputCode)
             .add(static_cast<uint16_t>(0))
             .add(static_cast<uint16_t>(10))
             .end();
+    }
 
-        modbusProcess(request,
-            [&](buffer_type&& buffer, size_t size) {
-                const auto reading = parseReading(std::move(buffer), size);
-                if (!reading.ok) {
-                    PZEM_DEBUG_MSG_P(PSTR("[PZEM004TV3] Could not parse latest reading\n"));
-                    return;
-                }
+    void modbusReadValues() {
+        const auto reading = parseReading(std::move(_reply), _reply_size);
+        if (!reading.ok) {
+            PZEM_DEBUG_MSG_P(PSTR("[PZEM004TV3] Could not parse latest reading\n"));
+            _error = SENSOR_ERROR_OTHER;
+            return;
+        }
 
-                if (_last_reading.ok && reading.ok) {
-                    const auto delta = energyDelta(
-                        _last_reading.energy_active, reading.energy_active);
-                    _energy_delta = delta.value;
-                }
+        if (_last_reading.ok && reading.ok) {
+            const auto delta = energyDelta(
+                _last_reading.energy_active, reading.energy_active);
+            _energy_delta = delta.value;
+        }
 
-                _last_reading = reading;
-            });
+        _last_reading = reading;
+        _error = SENSOR_ERROR_OK;
+    }
+
+    // ---------------------------------------------------------------------
+    // Serial poller
+    // ---------------------------------------------------------------------
+
+    size_t request(uint8_t* buffer, size_t size) override {
+        if (_reset_energy) {
+            _reset_energy = false;
+            return modbusRequest(modbusResetEnergy(), buffer, size);
+        }
+
+        if (TimeSource::now() - _last_update > _update_interval) {
+            _last_update = TimeSource::now();
+            return modbusRequest(modbusReadValuesRequest(), buffer, size);
+        }
+
+        return 0;
+    }
+
+    SerialPoller::Result receive(uint8_t c) override {
+        return modbusReceive(c);
+    }
+
+    void timeout() override {
+        PZEM_DEBUG_MSG_P(PSTR("[PZEM004TV3] ERROR: Expected %u bytes, got %u\n"),
+            _reply_expect, _reply_size);
+        modbusResult(SENSOR_ERROR_TIMEOUT);
     }
 
     // ---------------------------------------------------------------------
@@ -547,21 +629,10 @@ public:
         return 0.0;
     }
 
-    void pre() override {
-        consumeAvailable(*_port);
-
-        if (_reset_energy) {
-            const auto result [[gnu::unused]] = modbusResetEnergy();
-            PZEM_DEBUG_MSG_P(PSTR("[PZEM004TV3] Energy reset - %s\n"),
-                result ? PSTR("OK") : PSTR("FAIL"));
-            _reset_energy = false;
-            consumeAvailable(*_port);
-        }
-
-        if (TimeSource::now() - _last_update > _update_interval) {
-            modbusReadValues();
-            _last_update = TimeSource::now();
-        }
+    // Values and error status are updated as soon as the reply is received,
+    // reading magnitudes is simply returning the latest available values
+    void tick() override {
+        _poller->tick();
     }
 
 #if TERMINAL_SUPPORT
@@ -569,16 +640,20 @@ public:
 #endif
 private:
     PZEM004TV30Sensor() = delete;
-    PZEM004TV30Sensor(Stream* port, uint8_t address, TimeSource::duration timeout) :
+    PZEM004TV30Sensor(PollerPtr poller, uint8_t address) :
         BaseEmonSensor(Magnitudes),
-        _port(port),
-        _address(address),
-        _read_timeout(timeout)
+        _poller(poller),
+        _address(address)
     {}
 
-    Stream* _port { nullptr };
+    PollerPtr _poller;
     uint8_t _address { DefaultAddress };
-    TimeSource::duration _read_timeout { DefaultReadTimeout };
+
+    adu_builder _request { DefaultAddress, ReadInputCode };
+    buffer_type _reply;
+    size_t _reply_size { 0 };
+    size_t _reply_expect { 0 };
+    bool _address_result { false };
 
     bool _debug { false };
     char _debug_buffer[(BufferSize * 2) + 1];
@@ -591,7 +666,7 @@ private:
     double _energy_delta;
     Reading _last_reading;
 
-    static Instance _instance;
+    static Instances _instances;
 };
 
 #ifndef __cpp_inline_variables
@@ -601,7 +676,7 @@ constexpr BaseEmonSensor::Magnitude PZEM004TV30Sensor::Magnitudes[];
 constexpr espurna::duration::Milliseconds PZEM004TV30Sensor::DefaultReadTimeout;
 constexpr espurna::duration::Milliseconds PZEM004TV30Sensor::DefaultUpdateInterval;
 
-PZEM004TV30Sensor::Instance PZEM004TV30Sensor::_instance{};
+PZEM004TV30Sensor::Instances PZEM004TV30Sensor::_instances{};
 
 PROGMEM_STRING(PzemV3Address, "PZ.ADDRESS");
 
@@ -611,11 +686,16 @@ void PZEM004TV30Sensor::command_address(::terminal::CommandContext&& ctx) {
         return;
     }
 
+    if (_instances.size() != 1) {
+        terminalError(ctx, F("Only one device can be configured"));
+        return;
+    }
+
     uint8_t address = espurna::settings::internal::convert<uint8_t>(ctx.argv[1]);
 
-    consumeAvailable(*(_instance->_port));
-    if (_instance->modbusChangeAddress(address)) {
-        _instance->_address = address;
+    auto* instance = _instances.front();
+    if (instance->modbusChangeAddress(address)) {
+        instance->_address = address;
         setSetting("pzemv30Addr", address);
         terminalOK(ctx);
         return;
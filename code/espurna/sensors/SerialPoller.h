@@ -0,0 +1,176 @@
+// -----------------------------------------------------------------------------
+// Request-reply polling of multiple devices sharing the same serial line
+// Copyright (C) 2020-2025 by Maxim Prokhorov <prokhorov dot max at outlook dot com>
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "../utils.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Devices on the line (PZEM004T, PZEM004T V3.0, any other Modbus-RTU meter) only ever talk when
+// asked to, and only one of them can be answering at a time. Instead of waiting for the reply in the
+// sensor read path, every device serializes its request and then receives the reply byte-by-byte
+// as it arrives in the UART buffer. As soon as the reply is complete (or the device takes too long
+// to respond), the next device request is sent in the same tick(). Full sweep of N devices takes
+// N round-trips, and the loop is never blocked waiting for the line.
+class SerialPoller {
+public:
+    using TimeSource = espurna::time::CoreClock;
+
+    // Large enough for Modbus replies containing 10 registers
+    static constexpr size_t BufferSize { 32 };
+
+    enum class Result {
+        Pending,
+        Done,
+        Error,
+    };
+
+    class Device {
+    public:
+        virtual ~Device() = default;
+
+        // Serialize the next request into the buffer and return its size.
+        // Returning 0 skips the device until the next tick()
+        virtual size_t request(uint8_t* buffer, size_t size) = 0;
+
+        // Called for every byte received after the request was sent
+        virtual Result receive(uint8_t byte) = 0;
+
+        // Reply was not received (or was incomplete) in time
+        virtual void timeout() = 0;
+    };
+
+    struct Stats {
+        uint32_t requests;
+        uint32_t replies;
+        uint32_t errors;
+        uint32_t timeouts;
+    };
+
+    SerialPoller() = delete;
+    SerialPoller(Stream* stream, TimeSource::duration timeout) :
+        _stream(stream),
+        _timeout(timeout)
+    {}
+
+    Stream* stream() const {
+        return _stream;
+    }
+
+    TimeSource::duration timeout() const {
+        return _timeout;
+    }
+
+    const Stats& stats() const {
+        return _stats;
+    }
+
+    size_t devices() const {
+        return _devices.size();
+    }
+
+    void add(Device* device) {
+        _devices.push_back(device);
+    }
+
+    bool busy() const {
+        return _current != nullptr;
+    }
+
+    // Drop the active request and anything that was received so far. Line can be used directly
+    // afterwards, e.g. by some blocking operation initiated through the terminal
+    void abort() {
+        if (_current) {
+            _current->timeout();
+            _current = nullptr;
+        }
+
+        consumeAvailable(*_stream);
+    }
+
+    // Can be called multiple times per loop (usually, once from every device sharing the line)
+    void tick() {
+        if (_current) {
+            receive();
+        }
+
+        if (!_current) {
+            send();
+        }
+    }
+
+private:
+    void finish(Result result) {
+        switch (result) {
+        case Result::Pending:
+            return;
+        case Result::Done:
+            ++_stats.replies;
+            break;
+        case Result::Error:
+            ++_stats.errors;
+            break;
+        }
+
+        _current = nullptr;
+    }
+
+    void receive() {
+        while (_current && (_stream->available() > 0)) {
+            const auto c = _stream->read();
+            if (c < 0) {
+                break;
+            }
+
+            finish(_current->receive(static_cast<uint8_t>(c)));
+        }
+
+        if (_current && (TimeSource::now() - _sent > _timeout)) {
+            ++_stats.timeouts;
+            _current->timeout();
+            _current = nullptr;
+        }
+    }
+
+    // Each device is asked once per tick(), so devices that have nothing to send
+    // right now don't make us spin here
+    void send() {
+        for (size_t attempt = 0; attempt < _devices.size(); ++attempt) {
+            auto* device = _devices[_next];
+            _next = (_next + 1) % _devices.size();
+
+            const auto size = device->request(_buffer, sizeof(_buffer));
+            if (!size) {
+                continue;
+            }
+
+            // Anything still in the buffer is a late reply to some timed-out request
+            consumeAvailable(*_stream);
+            _stream->write(_buffer, size);
+
+            ++_stats.requests;
+            _current = device;
+            _sent = TimeSource::now();
+            break;
+        }
+    }
+
+    Stream* _stream;
+    TimeSource::duration _timeout;
+
+    std::vector<Device*> _devices;
+    size_t _next { 0 };
+
+    Device* _current { nullptr };
+    TimeSource::time_point _sent;
+
+    uint8_t _buffer[BufferSize];
+    Stats _stats { 0, 0, 0, 0 };
+};
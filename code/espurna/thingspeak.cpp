@@ -17,6 +17,8 @@ Copyright (C) 2019 by Xose Pérez <xose dot perez at gmail dot com>
 #include "thingspeak.h"
 #include "ws.h"
 
+#include "thingspeak_common.ipp"
+
 #include <memory>
 
 #if THINGSPEAK_USE_ASYNC
@@ -121,7 +123,7 @@ namespace {
 bool enabled = false;
 bool clear = false;
 
-String fields[build::Fields];
+Fields<build::Fields> fields;
 
 TimeSource::time_point last_flush;
 size_t retries = 0;
@@ -136,15 +138,12 @@ void schedule_flush() {
     internal::flush = true;
 }
 
-void enqueue(size_t index, const String& payload) {
-    if ((index > 0) && (index <= std::size(internal::fields))) {
-        internal::fields[--index] = payload;
-        return;
-    }
+void enqueue(size_t index, StringView payload) {
+    internal::fields.set(index, payload);
 }
 
 void enqueue(size_t index, bool status) {
-    enqueue(index, status ? String('1') : String('0'));
+    enqueue(index, status ? STRING_VIEW("1") : STRING_VIEW("0"));
 }
 
 void value(size_t index, double status) {
@@ -171,7 +170,7 @@ void onRelayStatus(size_t index, bool status) {
 #endif
 
 #if SENSOR_SUPPORT
-bool enqueueMagnitude(size_t index, const String& value) {
+bool enqueueMagnitude(size_t index, StringView value) {
     if (internal::enabled) {
         auto magnitudeIndex = settings::magnitude(index);
         if (magnitudeIndex) {
@@ -197,9 +196,7 @@ void maybe_retry(const String& body) {
 
     internal::retries = 0;
     if (internal::clear) {
-        for (auto& field : internal::fields) {
-            field = "";
-        }
+        internal::fields.clear();
     }
 }
 
@@ -627,16 +624,17 @@ void flush() {
         internal::data = "";
     }
 
-    // Walk the fields, IDs are mapped to indexes of the array
-    for (size_t id = 0; id < std::size(internal::fields); ++id) {
-        if (internal::fields[id].length()) {
+    // Walk the fields, only the ones with values are sent
+    for (size_t id = 1; id <= internal::fields.size(); ++id) {
+        const auto& field = internal::fields.get(id);
+        if (field.length()) {
             if (internal::data.length() > 0) {
                 internal::data.concat('&');
             }
 
-            char buf[32] = {0};
+            char buf[48] = {0};
             snprintf_P(buf, sizeof(buf), PSTR("field%u=%s"),
-                (id + 1), internal::fields[id].c_str());
+                id, field.c_str());
             internal::data.concat(buf);
         }
     }
@@ -722,7 +720,7 @@ void setup() {
     wsRegister()
         .onKeyCheck(onKeyCheck)
         .onVisible(onVisible)
-        .onConnected(onConnected);
+        .onConnected(Prefix, onConnected);
 }
 
 } // namespace
@@ -759,7 +757,7 @@ bool tspkEnqueueRelay(size_t index, bool status) {
 #endif
 
 #if SENSOR_SUPPORT
-bool tspkEnqueueMagnitude(unsigned char index, const String& value) {
+bool tspkEnqueueMagnitude(unsigned char index, espurna::StringView value) {
     return ::espurna::thingspeak::client::enqueueMagnitude(index, value);
 }
 #endif
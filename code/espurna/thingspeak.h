@@ -11,8 +11,10 @@ Copyright (C) 2019 by Xose Pérez <xose dot perez at gmail dot com>
 #include <Arduino.h>
 #include <cstdint>
 
+#include "types.h"
+
 bool tspkEnqueueRelay(unsigned char index, bool status);
-bool tspkEnqueueMagnitude(unsigned char index, const String& value);
+bool tspkEnqueueMagnitude(unsigned char index, espurna::StringView value);
 void tspkFlush();
 
 bool tspkEnabled();
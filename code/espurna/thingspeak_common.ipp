@@ -0,0 +1,57 @@
+/*
+
+Part of THINGSPEAK MODULE
+
+Channel field values, shared between the firmware and the host benchmark
+
+Copyright (C) 2019 by Xose Pérez <xose dot perez at gmail dot com>
+
+*/
+
+#pragma once
+
+#include "types.h"
+
+#include <array>
+
+namespace espurna {
+namespace thingspeak {
+namespace {
+
+// Values are stored as-is, fits any formatted magnitude value (sensor::Repr)
+using Field = InlineString<31>;
+
+// IDs are 1-based, same as field numbers in the channel settings
+template <size_t Size>
+class Fields {
+public:
+    static constexpr size_t size() {
+        return Size;
+    }
+
+    bool set(size_t id, StringView value) {
+        if ((id > 0) && (id <= Size)) {
+            _fields[id - 1] = Field(value);
+            return true;
+        }
+
+        return false;
+    }
+
+    const Field& get(size_t id) const {
+        return _fields[id - 1];
+    }
+
+    void clear() {
+        for (auto& field : _fields) {
+            field.clear();
+        }
+    }
+
+private:
+    std::array<Field, Size> _fields;
+};
+
+} // namespace
+} // namespace thingspeak
+} // namespace espurna
@@ -10,6 +10,7 @@ Copyright (C) 2019-2021 by Maxim Prokhorov <prokhorov dot max at outlook dot com
 #include <Arduino.h>
 #include <sys/pgmspace.h>
 
+#include <algorithm>
 #include <chrono>
 #include <memory>
 
@@ -396,6 +397,88 @@ inline String operator+(StringView lhs, const String& rhs) {
     return out;
 }
 
+// Fixed capacity string stored in-place, for short text that is created and passed around often.
+// Anything that does not fit is silently truncated, always null-terminated
+template <size_t Capacity>
+struct InlineString {
+    static_assert(Capacity < 256, "");
+
+    constexpr InlineString() noexcept = default;
+
+    InlineString(StringView value) noexcept {
+        *this += value;
+    }
+
+    static constexpr size_t capacity() {
+        return Capacity;
+    }
+
+    const char* begin() const {
+        return &_data[0];
+    }
+
+    const char* end() const {
+        return &_data[_length];
+    }
+
+    const char* c_str() const {
+        return &_data[0];
+    }
+
+    size_t length() const {
+        return _length;
+    }
+
+    StringView view() const {
+        return StringView(begin(), end());
+    }
+
+    operator StringView() const {
+        return view();
+    }
+
+    String toString() const {
+        return view().toString();
+    }
+
+    void clear() {
+        _length = 0;
+        _data[0] = '\0';
+    }
+
+    // source can be located either in RAM or in flash
+    InlineString& operator+=(StringView value) {
+        const auto size = std::min(value.length(), Capacity - _length);
+        memcpy_P(&_data[_length], value.data(), size);
+        _length += size;
+        _data[_length] = '\0';
+        return *this;
+    }
+
+    InlineString& operator+=(char value) {
+        if (_length < Capacity) {
+            _data[_length++] = value;
+            _data[_length] = '\0';
+        }
+
+        return *this;
+    }
+
+    // for functions writing into the buffer directly. size must be < capacity() + 1
+    char* data() {
+        return &_data[0];
+    }
+
+    void resize(size_t size) {
+        _length = std::min(size, Capacity);
+        _data[_length] = '\0';
+    }
+
+private:
+    char _data[Capacity + 1] {};
+    uint8_t _length { 0 };
+};
+
 #if defined(ARDUINO_ESP8266_RELEASE_2_7_4)
 inline String operator+(const String& lhs, const String& rhs) {
     String out;
@@ -462,6 +462,110 @@ void _onAPCaptiveRequest(AsyncWebServerRequest* request) {
 
 #if WEB_EMBEDDED
 PROGMEM_STRING(IfModifiedSince, "If-Modified-Since");
+PROGMEM_STRING(IfNoneMatch, "If-None-Match");
+PROGMEM_STRING(IfRange, "If-Range");
+PROGMEM_STRING(Range, "Range");
+
+// Image only changes with the firmware, so the tag is calculated by the compiler.
+// FNV-1a over blocks, every loop stays well below the constexpr iteration limit
+constexpr uint32_t _webImageHash(const uint8_t* data, size_t size) {
+    constexpr size_t Block { 4096 };
+
+    uint32_t out { 2166136261ul };
+    for (size_t block = 0; block < size; block += Block) {
+        const auto end = std::min(size, block + Block);
+        for (size_t index = block; index < end; ++index) {
+            out = (out ^ data[index]) * 16777619ul;
+        }
+    }
+
+    return out;
+}
+
+constexpr uint32_t WebImageHash { _webImageHash(webui_image, std::size(webui_image)) };
+
+String _webImageETag() {
+    char buffer[16];
+    snprintf_P(buffer, sizeof(buffer), PSTR("\"%08x\""), WebImageHash);
+    return buffer;
+}
+
+struct WebRange {
+    enum class Result {
+        Full,
+        Partial,
+        Unsatisfiable,
+    };
+
+    size_t start;
+    size_t length;
+};
+
+// Only a single range is supported, i.e. 'bytes=<first>-<last>', 'bytes=<first>-' or 'bytes=-<suffix>'
+// Anything else is ignored and the full content is sent instead
+WebRange::Result _webParseRange(espurna::StringView value, size_t size, WebRange& out) {
+    STRING_VIEW_INLINE(Bytes, "bytes=");
+    if (!value.startsWith(Bytes)) {
+        return WebRange::Result::Full;
+    }
+
+    value = value.slice(Bytes.length());
+
+    const auto dash = std::find(value.begin(), value.end(), '-');
+    if ((dash == value.end()) || (std::find(value.begin(), value.end(), ',') != value.end())) {
+        return WebRange::Result::Full;
+    }
+
+    const auto first = espurna::StringView(value.begin(), dash);
+    const auto last = espurna::StringView(dash + 1, value.end());
+
+    if (!first.length()) {
+        const auto suffix = parseUnsigned(last, 10);
+        if (!suffix.ok) {
+            return WebRange::Result::Full;
+        }
+
+        if (!suffix.value) {
+            return WebRange::Result::Unsatisfiable;
+        }
+
+        out.length = std::min<size_t>(suffix.value, size);
+        out.start = size - out.length;
+        return WebRange::Result::Partial;
+    }
+
+    const auto start = parseUnsigned(first, 10);
+    if (!start.ok) {
+        return WebRange::Result::Full;
+    }
+
+    if (start.value >= size) {
+        return WebRange::Result::Unsatisfiable;
+    }
+
+    size_t end = size - 1;
+    if (last.length()) {
+        const auto result = parseUnsigned(last, 10);
+        if (!result.ok || (result.value < start.value)) {
+            return WebRange::Result::Full;
+        }
+
+        end = std::min<size_t>(result.value, end);
+    }
+
+    out.start = start.value;
+    out.length = end - start.value + 1;
+
+    return WebRange::Result::Partial;
+}
+
+// Browser always revalidates, which is a cheap 304 when ETag matches
+// (and avoids using the cached image from the previous firmware after an update)
+void _webImageHeaders(AsyncWebServerResponse* response, const String& etag) {
+    response->addHeader(F("ETag"), etag);
+    response->addHeader(F("Cache-Control"), F("no-cache"));
+    response->addHeader(F("Last-Modified"), FPSTR(LastModified));
+}
 
 void _onHome(AsyncWebServerRequest *request) {
     if (!_isAPModeRequest(request) && !_authenticateRequest(request)) {
@@ -469,35 +573,74 @@ void _onHome(AsyncWebServerRequest *request) {
         return;
     }
 
-    if (request->hasHeader(FPSTR(IfModifiedSince))) {
+    const auto etag = _webImageETag();
+
+    // If-Modified-Since is only used when the tag is not
+    bool modified { true };
+    if (request->hasHeader(FPSTR(IfNoneMatch))) {
+        modified = request->header(FPSTR(IfNoneMatch)).indexOf(etag) < 0;
+    } else if (request->hasHeader(FPSTR(IfModifiedSince))) {
         const auto value = request->header(FPSTR(IfModifiedSince));
-        if (strncmp_P(value.c_str(), LastModified, value.length()) == 0) {
-            request->send(304);
-            return;
+        modified = strncmp_P(value.c_str(), LastModified, value.length()) != 0;
+    }
+
+    if (!modified) {
+        auto* response = request->beginResponse(304);
+        _webImageHeaders(response, etag);
+        request->send(response);
+        return;
+    }
+
+    // Resume interrupted download, unless the image has changed since then
+    WebRange range{0, std::size(webui_image)};
+    auto result = WebRange::Result::Full;
+    if (request->hasHeader(FPSTR(Range))) {
+        if (!request->hasHeader(FPSTR(IfRange)) || (request->header(FPSTR(IfRange)) == etag)) {
+            result = _webParseRange(request->header(FPSTR(Range)), std::size(webui_image), range);
         }
     }
 
+    if (result == WebRange::Result::Unsatisfiable) {
+        auto* response = request->beginResponse(416);
+        response->addHeader(F("Content-Range"),
+            String(F("bytes */")) + String(std::size(webui_image), 10));
+        request->send(response);
+        return;
+    }
+
+    const int code = (result == WebRange::Result::Partial) ? 206 : 200;
+    const auto* image = webui_image + range.start;
+
 #if WEB_SSL_ENABLED
     // Chunked response, we calculate the chunks based on free heap (in multiples of 32)
     // This is necessary when a TLS connection is open since it sucks too much memory
     const size_t max = (systemFreeHeap() / 3) & 0xFFE0;
-    auto* response = request->beginChunkedResponse("text/html", [max](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+    auto* response = request->beginChunkedResponse("text/html", [max, image, range](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
         // Get the chunk based on the index and maxLen
-        size_t len = std::size(webui_image) - index;
+        size_t len = range.length - index;
         len = std::min({len, maxLen, max});
         if (len > 0) {
-            memcpy_P(buffer, webui_image + index, len);
+            memcpy_P(buffer, image + index, len);
         }
 
         // Return the actual length of the chunk (0 for end of file)
         return len;
     });
+    response->setCode(code);
 #else
-    auto* response = request->beginResponse_P(200, F("text/html"), webui_image, std::size(webui_image));
+    auto* response = request->beginResponse_P(code, F("text/html"), image, range.length);
 #endif
 
+    if (result == WebRange::Result::Partial) {
+        char buffer[48];
+        snprintf_P(buffer, sizeof(buffer), PSTR("bytes %u-%u/%u"),
+            range.start, range.start + range.length - 1, std::size(webui_image));
+        response->addHeader(F("Content-Range"), buffer);
+    }
+
+    response->addHeader(F("Accept-Ranges"), F("bytes"));
     response->addHeader(F("Content-Encoding"), F("gzip"));
-    response->addHeader(F("Last-Modified"), FPSTR(LastModified));
+    _webImageHeaders(response, etag);
     response->addHeader(F("X-XSS-Protection"), F("1; mode=block"));
     response->addHeader(F("X-Content-Type-Options"), F("nosniff"));
     response->addHeader(F("X-Frame-Options"), F("deny"));
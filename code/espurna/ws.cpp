@@ -10,12 +10,16 @@ Copyright (C) 2016-2019 by Xose Pérez <xose dot perez at gmail dot com>
 
 #if WEB_SUPPORT
 
-#include <queue>
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <iterator>
 #include <vector>
 
 #include "datetime.h"
 #include "ntp.h"
 #include "system.h"
+#include "terminal.h"
 #include "utils.h"
 #include "web.h"
 #include "wifi.h"
@@ -37,6 +41,7 @@ namespace {
 namespace internal {
 
 STRING_VIEW_INLINE(SchemaKey, "schema");
+STRING_VIEW_INLINE(ValuesKey, "values");
 
 } // namespace internal
 
@@ -233,7 +238,7 @@ void _wsDoUpdate(const bool connected) {
     auto ts = decltype(_ws_last_update)::clock::now();
     if (ts - _ws_last_update > WsUpdateInterval) {
         _ws_last_update = ts;
-        wsSend(_wsUpdate);
+        wsPostDelta(_wsUpdate);
     }
 }
 
@@ -246,13 +251,278 @@ void _wsDoUpdate(const bool connected) {
 namespace {
 
 AsyncWebSocket _ws("/ws");
-std::queue<WsPostponedCallbacks> _ws_queue;
 ws_callbacks_t _ws_callbacks;
 
+// Messages are generated right before they are sent, one at a time. Instead of allocating
+// the json buffer from scratch every time, already allocated blocks are kept around and
+// re-used by the next message. Blocks are released when nobody is connected
+class WsJsonPool {
+public:
+    static constexpr size_t Blocks { 4 };
+
+    struct Stats {
+        uint32_t allocated;
+        uint32_t reused;
+        size_t cached;
+    };
+
+    void* allocate(size_t size) {
+        for (auto& block : _blocks) {
+            if (block.ptr && !block.used && (block.size >= size)) {
+                block.used = true;
+                ++_stats.reused;
+                return block.ptr;
+            }
+        }
+
+        auto* out = std::malloc(size);
+        if (!out) {
+            return nullptr;
+        }
+
+        ++_stats.allocated;
+
+        // prefer empty slot, but replace some smaller block when there's none
+        auto slot = std::find_if(
+            std::begin(_blocks), std::end(_blocks),
+            [](const Block& block) {
+                return !block.ptr;
+            });
+
+        if (slot == std::end(_blocks)) {
+            slot = std::find_if(
+                std::begin(_blocks), std::end(_blocks),
+                [](const Block& block) {
+                    return !block.used;
+                });
+        }
+
+        if (slot != std::end(_blocks)) {
+            if ((*slot).ptr) {
+                _stats.cached -= (*slot).size;
+                std::free((*slot).ptr);
+            }
+
+            *slot = Block{out, size, true};
+            _stats.cached += size;
+        }
+
+        return out;
+    }
+
+    void deallocate(void* ptr) {
+        for (auto& block : _blocks) {
+            if (block.ptr == ptr) {
+                block.used = false;
+                return;
+            }
+        }
+
+        std::free(ptr);
+    }
+
+    void release() {
+        for (auto& block : _blocks) {
+            if (block.ptr && !block.used) {
+                _stats.cached -= block.size;
+                std::free(block.ptr);
+                block = Block{};
+            }
+        }
+    }
+
+    const Stats& stats() const {
+        return _stats;
+    }
+
+private:
+    struct Block {
+        void* ptr { nullptr };
+        size_t size { 0 };
+        bool used { false };
+    };
+
+    Block _blocks[Blocks];
+    Stats _stats { 0, 0, 0 };
+};
+
+WsJsonPool _ws_json_pool;
+
+struct WsJsonAllocator {
+    void* allocate(size_t size) {
+        return _ws_json_pool.allocate(size);
+    }
+
+    void deallocate(void* ptr) {
+        _ws_json_pool.deallocate(ptr);
+    }
+};
+
+using WsJsonBuffer = ArduinoJson::Internals::DynamicJsonBufferBase<WsJsonAllocator>;
+
+// Optional parts of the protocol. Client lists the ones it supports when requesting the ticket,
+// anything else receives the same payloads as before these were introduced
+// GET /auth?features=delta,modules
+enum WsFeature : uint8_t {
+    // Only the changed 'values' entries of the delta updates, see _wsSendDeltaEnumerable()
+    WsFeatureDelta = 1 << 0,
+    // Module data is only sent when requested with the 'module' action, see _wsModule()
+    WsFeatureModules = 1 << 1,
+};
+
+// Added when client connects and removed on disconnect
+struct WsClient {
+    using TimeSource = espurna::time::CoreClock;
+
+    // What was sent to the client through the delta updates. Values are never stored, only their hashes
+    struct Field {
+        uint32_t key;
+        uint32_t value;
+        TimeSource::time_point sent;
+    };
+
+    static constexpr size_t Priorities { 3 };
+    using Queue = std::deque<WsPostponedCallbacks>;
+
+    WsClient(uint32_t id, uint8_t features) :
+        id(id),
+        features(features)
+    {}
+
+    Queue& queue(WsPriority priority) {
+        return queues[static_cast<size_t>(priority)];
+    }
+
+    size_t queued() const {
+        size_t out { 0 };
+        for (const auto& queue : queues) {
+            out += queue.size();
+        }
+
+        return out;
+    }
+
+    uint32_t id;
+    uint8_t features;
+
+    // Negotiated binary telemetry frames, see wsPostTelemetry()
+    bool binary { false };
+    uint8_t binary_pending { 0 };
+    TimeSource::time_point binary_resync;
+
+    // State updates are held back until the initial payload is sent
+    bool ready { false };
+
+    std::vector<Field> fields;
+    Queue queues[Priorities];
+
+    uint32_t dropped { 0 };
+    uint32_t merged { 0 };
+};
+
+// Per client and priority. Queued state updates are merged, so this is mostly reached by the stalled clients
+constexpr size_t WsQueueLimit { 16 };
+
+std::vector<WsClient> _ws_clients;
+size_t _ws_clients_next { 0 };
+
+WsClient* _wsClient(uint32_t client_id) {
+    for (auto& client : _ws_clients) {
+        if (client.id == client_id) {
+            return &client;
+        }
+    }
+
+    return nullptr;
+}
+
+void _wsClientConnected(uint32_t client_id, uint8_t features) {
+    _ws_clients.emplace_back(client_id, features);
+}
+
+void _wsClientDisconnected(uint32_t client_id) {
+    _ws_clients.erase(
+        std::remove_if(
+            _ws_clients.begin(),
+            _ws_clients.end(),
+            [&](const WsClient& client) {
+                return client.id == client_id;
+            }),
+        _ws_clients.end());
+}
+
+bool _wsSameUpdate(const WsPostponedCallbacks& lhs, const WsPostponedCallbacks& rhs) {
+    return (lhs.key() == rhs.key())
+        && (lhs.delta() == rhs.delta())
+        && (lhs.telemetry() == rhs.telemetry());
+}
+
+void _wsQueue(WsClient& client, WsPriority priority, const WsPostponedCallbacks& callbacks) {
+    if (callbacks.telemetry() && client.binary) {
+        return;
+    }
+
+    auto& queue = client.queue(priority);
+
+    // Payload is generated when it is about to be sent, queued entry would already include the latest values
+    if (callbacks.key()) {
+        for (const auto& entry : queue) {
+            if (!entry.started() && _wsSameUpdate(entry, callbacks)) {
+                ++client.merged;
+                return;
+            }
+        }
+    }
+
+    if (queue.size() >= WsQueueLimit) {
+        ++client.dropped;
+        return;
+    }
+
+    queue.push_back(callbacks);
+}
+
+// Client id equal to 0 means that every client receives its own copy
+void _wsQueue(uint32_t client_id, WsPriority priority, const WsPostponedCallbacks& callbacks) {
+    if (client_id) {
+        auto* client = _wsClient(client_id);
+        if (client) {
+            _wsQueue(*client, priority, callbacks);
+        }
+
+        return;
+    }
+
+    for (auto& client : _ws_clients) {
+        _wsQueue(client, priority, callbacks);
+    }
+}
+
+template <typename T>
+void _wsPostCallbacks(uint32_t client_id, T&& cbs, WsPostponedCallbacks::Mode mode) {
+    _wsQueue(client_id, WsPriority::Bulk,
+        WsPostponedCallbacks(client_id, std::forward<T>(cbs), mode));
+}
+
+template <typename T>
+void _wsPostDelta(uint32_t client_id, T&& cb) {
+    WsPostponedCallbacks callbacks(client_id, std::forward<T>(cb));
+    callbacks.delta(true);
+    _wsQueue(client_id, WsPriority::State, callbacks);
+}
+
+// Replies to the specific client are usually the result of some action
+WsPriority _wsPostPriority(uint32_t client_id) {
+    return client_id
+        ? WsPriority::Control
+        : WsPriority::State;
+}
+
 } // namespace
 
 void wsPost(uint32_t client_id, ws_on_send_callback_f&& cb) {
-    _ws_queue.emplace(client_id, std::move(cb));
+    _wsQueue(client_id, _wsPostPriority(client_id),
+        WsPostponedCallbacks(client_id, std::move(cb)));
 }
 
 void wsPost(ws_on_send_callback_f&& cb) {
@@ -260,21 +530,29 @@ void wsPost(ws_on_send_callback_f&& cb) {
 }
 
 void wsPost(uint32_t client_id, const ws_on_send_callback_f& cb) {
-    _ws_queue.emplace(client_id, cb);
+    _wsQueue(client_id, _wsPostPriority(client_id),
+        WsPostponedCallbacks(client_id, cb));
 }
 
 void wsPost(const ws_on_send_callback_f& cb) {
     wsPost(0, cb);
 }
 
-namespace {
+void wsPostDelta(uint32_t client_id, ws_on_send_callback_f&& cb) {
+    _wsPostDelta(client_id, std::move(cb));
+}
 
-template <typename T>
-void _wsPostCallbacks(uint32_t client_id, T&& cbs, WsPostponedCallbacks::Mode mode) {
-    _ws_queue.emplace(client_id, std::forward<T>(cbs), mode);
+void wsPostDelta(ws_on_send_callback_f&& cb) {
+    wsPostDelta(0, std::move(cb));
 }
 
-} // namespace
+void wsPostDelta(uint32_t client_id, const ws_on_send_callback_f& cb) {
+    _wsPostDelta(client_id, cb);
+}
+
+void wsPostDelta(const ws_on_send_callback_f& cb) {
+    wsPostDelta(0, cb);
+}
 
 void wsPostAll(uint32_t client_id, ws_on_send_callback_list_t&& cbs) {
     _wsPostCallbacks(client_id, std::move(cbs), WsPostponedCallbacks::Mode::All);
@@ -320,6 +598,11 @@ ws_callbacks_t& ws_callbacks_t::onConnected(ws_callbacks_t::on_send_f cb) {
     return *this;
 }
 
+ws_callbacks_t& ws_callbacks_t::onConnected(espurna::StringView module, ws_callbacks_t::on_send_f cb) {
+    on_module.push_back({module, cb});
+    return *this;
+}
+
 ws_callbacks_t& ws_callbacks_t::onData(ws_callbacks_t::on_send_f cb) {
     on_data.push_back(cb);
     return *this;
@@ -335,6 +618,362 @@ ws_callbacks_t& ws_callbacks_t::onKeyCheck(ws_callbacks_t::on_keycheck_f cb) {
     return *this;
 }
 
+// -----------------------------------------------------------------------------
+// Delta updates
+// -----------------------------------------------------------------------------
+
+namespace {
+
+class WsDeltaHash : public Print {
+public:
+    static constexpr uint32_t Basis { 2166136261ul };
+    static constexpr uint32_t Prime { 16777619ul };
+
+    size_t write(uint8_t c) override {
+        _value = (_value ^ c) * Prime;
+        return 1;
+    }
+
+    size_t write(const uint8_t* data, size_t size) override {
+        for (size_t index = 0; index < size; ++index) {
+            write(data[index]);
+        }
+
+        return size;
+    }
+
+    void update(const void* data, size_t size) {
+        write(static_cast<const uint8_t*>(data), size);
+    }
+
+    uint32_t value() const {
+        return _value;
+    }
+
+private:
+    uint32_t _value { Basis };
+};
+
+constexpr espurna::duration::Seconds WsDeltaResyncInterval { WS_DELTA_RESYNC_INTERVAL };
+
+uint32_t _wsDeltaKey(const char* key) {
+    WsDeltaHash out;
+    out.update(key, strlen(key));
+    return out.value();
+}
+
+uint32_t _wsDeltaKey(const char* key, size_t index) {
+    WsDeltaHash out;
+    out.update(key, strlen(key) + 1);
+    out.update(&index, sizeof(index));
+    return out.value();
+}
+
+// Values are hashed as they are stored in the buffer, numbers are never converted to text
+void _wsDeltaHash(WsDeltaHash& out, const JsonVariant& value) {
+    if (value.is<JsonArray>()) {
+        out.write('[');
+        for (const auto& element : value.as<JsonArray>()) {
+            _wsDeltaHash(out, element);
+        }
+        out.write(']');
+    } else if (value.is<JsonObject>()) {
+        out.write('{');
+        for (const auto& kv : value.as<JsonObject>()) {
+            out.update(kv.key, strlen(kv.key) + 1);
+            _wsDeltaHash(out, kv.value);
+        }
+        out.write('}');
+    } else if (value.is<const char*>()) {
+        const auto* string = value.as<const char*>();
+        out.write('"');
+        if (string) {
+            out.update(string, strlen(string));
+        }
+    } else if (value.is<bool>()) {
+        out.write(value.as<bool>() ? 't' : 'f');
+    } else if (value.is<long>()) {
+        const auto number = value.as<long>();
+        out.write('i');
+        out.update(&number, sizeof(number));
+    } else if (value.is<double>()) {
+        const auto number = value.as<double>();
+        out.write('f');
+        out.update(&number, sizeof(number));
+    } else {
+        value.printTo(out);
+    }
+}
+
+uint32_t _wsDeltaValue(const JsonVariant& value) {
+    WsDeltaHash out;
+    _wsDeltaHash(out, value);
+    return out.value();
+}
+
+// True when value is not in the snapshot yet, was changed or needs to be sent again
+bool _wsDeltaUpdate(WsClient& client, WsClient::TimeSource::time_point now, uint32_t key, uint32_t value, bool force) {
+    auto it = std::find_if(
+        client.fields.begin(),
+        client.fields.end(),
+        [&](const WsClient::Field& sent) {
+            return sent.key == key;
+        });
+
+    if (it == client.fields.end()) {
+        client.fields.push_back(
+            WsClient::Field{
+                .key = key,
+                .value = value,
+                .sent = now,
+            });
+        return true;
+    }
+
+    if (force || ((*it).value != value) || (now - (*it).sent >= WsDeltaResyncInterval)) {
+        (*it).value = value;
+        (*it).sent = now;
+        return true;
+    }
+
+    return false;
+}
+
+// EnumerablePayload entries are compared one by one, see espurna::web::ws::EnumerablePayload
+struct WsDeltaEnumerable {
+    JsonArray* schema;
+    JsonArray* values;
+};
+
+WsDeltaEnumerable _wsDeltaEnumerable(const JsonVariant& value) {
+    using espurna::web::ws::internal::SchemaKey;
+    using espurna::web::ws::internal::ValuesKey;
+
+    WsDeltaEnumerable out{nullptr, nullptr};
+    if (!value.is<JsonObject>()) {
+        return out;
+    }
+
+    auto& object = value.as<JsonObject>();
+    if (object.size() != 2) {
+        return out;
+    }
+
+    for (auto& kv : object) {
+        if (!kv.value.is<JsonArray>()) {
+            break;
+        }
+
+        const auto key = espurna::StringView(kv.key);
+        if (key == SchemaKey) {
+            out.schema = &kv.value.as<JsonArray>();
+        } else if (key == ValuesKey) {
+            out.values = &kv.value.as<JsonArray>();
+        }
+    }
+
+    if (!out.schema || !out.values) {
+        return WsDeltaEnumerable{nullptr, nullptr};
+    }
+
+    return out;
+}
+
+// Schema and the number of entries are tracked as a separate value, any change there sends the whole key.
+// Otherwise, only changed entries are sent and the rest of them are replaced with 'null'. Clients that
+// did not ask for the 'delta' feature would not expect 'null', and always receive the whole key instead
+bool _wsSendDeltaEnumerable(WsClient& client, WsClient::TimeSource::time_point now, JsonObject& out, const char* key, const WsDeltaEnumerable& enumerable) {
+    using espurna::web::ws::internal::SchemaKey;
+    using espurna::web::ws::internal::ValuesKey;
+
+    WsDeltaHash layout;
+    _wsDeltaHash(layout, *enumerable.schema);
+
+    const auto size = enumerable.values->size();
+    layout.update(&size, sizeof(size));
+
+    bool whole = _wsDeltaUpdate(client, now, _wsDeltaKey(key), layout.value(), false);
+    const bool partial = (client.features & WsFeatureDelta) != 0;
+
+    JsonArray* values = nullptr;
+
+    size_t index = 0;
+    for (auto& entry : *enumerable.values) {
+        const auto updated = _wsDeltaUpdate(client, now,
+            _wsDeltaKey(key, index), _wsDeltaValue(entry), whole);
+        if (!partial) {
+            whole = whole || updated;
+            ++index;
+            continue;
+        }
+
+        if (!whole && updated && !values) {
+            JsonObject& partial = out.createNestedObject(key);
+            partial[SchemaKey] = *enumerable.schema;
+            values = &partial.createNestedArray(ValuesKey);
+            for (size_t skipped = 0; skipped < index; ++skipped) {
+                values->add(static_cast<const char*>(nullptr));
+            }
+        }
+
+        if (values) {
+            if (updated) {
+                values->add(entry);
+            } else {
+                values->add(static_cast<const char*>(nullptr));
+            }
+        }
+
+        ++index;
+    }
+
+    return whole;
+}
+
+// Snapshot is updated before the message is actually sent. Since the only reason for
+// it to fail at that point is being out of memory, lost value will be re-sent with the next resync
+void _wsSendDelta(JsonBuffer& buffer, WsClient& client, JsonObject& root) {
+    const auto now = WsClient::TimeSource::now();
+
+    JsonObject& out = buffer.createObject();
+    bool complete { true };
+
+    for (auto& kv : root) {
+        const auto enumerable = _wsDeltaEnumerable(kv.value);
+        if (enumerable.values) {
+            if (_wsSendDeltaEnumerable(client, now, out, kv.key, enumerable)) {
+                out[kv.key] = kv.value;
+            } else {
+                complete = false;
+            }
+            continue;
+        }
+
+        if (_wsDeltaUpdate(client, now, _wsDeltaKey(kv.key), _wsDeltaValue(kv.value), false)) {
+            out[kv.key] = kv.value;
+        } else {
+            complete = false;
+        }
+    }
+
+    if (!out.size()) {
+        return;
+    }
+
+    wsSend(client.id, complete ? root : out);
+}
+
+// Telemetry frame generators, registered when posted for the first time. Clients only keep the mask of pending ones
+constexpr size_t WsBinaryCallbacksMax { 8 };
+std::vector<ws_on_binary_callback_f> _ws_binary_callbacks;
+
+size_t _wsBinaryIndex(ws_on_binary_callback_f binary) {
+    const auto it = std::find(_ws_binary_callbacks.begin(), _ws_binary_callbacks.end(), binary);
+    if (it != _ws_binary_callbacks.end()) {
+        return std::distance(_ws_binary_callbacks.begin(), it);
+    }
+
+    if (_ws_binary_callbacks.size() < WsBinaryCallbacksMax) {
+        _ws_binary_callbacks.push_back(binary);
+        return _ws_binary_callbacks.size() - 1;
+    }
+
+    return WsBinaryCallbacksMax;
+}
+
+uint8_t _wsBinaryMaskAll() {
+    return (1ul << _ws_binary_callbacks.size()) - 1ul;
+}
+
+// Client already received the JSON payload, but telemetry is not sent as JSON anymore
+// Send every frame to make sure that the current state is known
+void _wsBinaryEnable(uint32_t client_id) {
+    auto* client = _wsClient(client_id);
+    if (client) {
+        (*client).binary = true;
+        (*client).binary_pending = _wsBinaryMaskAll();
+        (*client).binary_resync = WsClient::TimeSource::now();
+    }
+}
+
+// Pending frames are sent once the client was sent the initial payload and has enough space in its queue.
+// Every frame is also repeated after WS_DELTA_RESYNC_INTERVAL, same as the unchanged delta values.
+// Same buffer is shared between every client, frame itself is only generated when at least one can receive it
+void _wsSendBinary() {
+    const auto now = WsClient::TimeSource::now();
+
+    bool pending { false };
+    for (auto& client : _ws_clients) {
+        if (client.binary && (now - client.binary_resync >= WsDeltaResyncInterval)) {
+            client.binary_pending = _wsBinaryMaskAll();
+            client.binary_resync = now;
+        }
+
+        pending = pending || (client.binary && client.binary_pending);
+    }
+
+    if (!pending) {
+        return;
+    }
+
+    for (size_t index = 0; index < _ws_binary_callbacks.size(); ++index) {
+        const uint8_t mask = 1 << index;
+        AsyncWebSocketMessageBuffer* buffer = nullptr;
+
+        for (auto& client : _ws_clients) {
+            if (!client.binary || !client.ready || !(client.binary_pending & mask)) {
+                continue;
+            }
+
+            auto* ws_client = _ws.client(client.id);
+            if (!ws_client || ws_client->queueIsFull()) {
+                continue;
+            }
+
+            if (!buffer) {
+                const auto frame = _ws_binary_callbacks[index]();
+                buffer = _ws.makeBuffer(frame.size());
+                if (!buffer) {
+                    return;
+                }
+
+                std::memcpy(buffer->get(), frame.data(), frame.size());
+                buffer->lock();
+            }
+
+            ws_client->binary(buffer);
+            client.binary_pending &= ~mask;
+        }
+
+        if (buffer) {
+            buffer->unlock();
+        }
+    }
+}
+
+} // namespace
+
+void wsPostTelemetry(ws_callbacks_t::on_send_f cb, ws_on_binary_callback_f binary) {
+    WsPostponedCallbacks callbacks(0, cb);
+    callbacks.delta(true);
+    callbacks.key(cb);
+
+    // too many generators, binary clients receive the JSON payload instead
+    const auto index = _wsBinaryIndex(binary);
+    if (index < WsBinaryCallbacksMax) {
+        for (auto& client : _ws_clients) {
+            if (client.binary) {
+                client.binary_pending |= 1 << index;
+            }
+        }
+
+        callbacks.telemetry(true);
+        _wsSendBinary();
+    }
+
+    _wsQueue(0, WsPriority::State, callbacks);
+}
+
 // -----------------------------------------------------------------------------
 // WS authentication
 // -----------------------------------------------------------------------------
@@ -346,6 +985,44 @@ constexpr espurna::duration::Seconds WsTimeout { WS_TIMEOUT };
 
 WsTicket _ws_tickets[WsMaxClients];
 
+struct WsFeatureName {
+    espurna::StringView name;
+    WsFeature feature;
+};
+
+STRING_VIEW_INLINE(WsDelta, "delta");
+STRING_VIEW_INLINE(WsModules, "modules");
+
+constexpr WsFeatureName WsFeatureNames[] {
+    {WsDelta, WsFeatureDelta},
+    {WsModules, WsFeatureModules},
+};
+
+// Comma-separated list of names, unknown ones are ignored
+uint8_t _wsParseFeatures(AsyncWebServerRequest* request) {
+    STRING_VIEW_INLINE(Features, "features");
+
+    auto* param = request->getParam(Features.toString());
+    if (!param) {
+        return 0;
+    }
+
+    uint8_t out { 0 };
+
+    auto split = espurna::SplitStringView(param->value(), ',');
+    while (split.next()) {
+        const auto current = split.current();
+        for (const auto& entry : WsFeatureNames) {
+            if (current == entry.name) {
+                out |= entry.feature;
+                break;
+            }
+        }
+    }
+
+    return out;
+}
+
 void _onAuth(AsyncWebServerRequest* request) {
     if (!webApModeRequest(request) && !webAuthenticate(request)) {
         return request->requestAuthentication();
@@ -367,6 +1044,7 @@ void _onAuth(AsyncWebServerRequest* request) {
     if (it != std::end(_ws_tickets)) {
         (*it).ip = ip;
         (*it).timestamp = now;
+        (*it).features = _wsParseFeatures(request);
         request->send(200, "text/plain", "OK");
         return;
     }
@@ -384,6 +1062,18 @@ void _wsAuthUpdate(AsyncWebSocketClient* client) {
     }
 }
 
+// Tickets are per address, so the latest request from the same address wins
+uint8_t _wsFeatures(AsyncWebSocketClient* client) {
+    IPAddress ip = client->remoteIP();
+    for (const auto& ticket : _ws_tickets) {
+        if (ticket.ip == ip) {
+            return ticket.features;
+        }
+    }
+
+    return 0;
+}
+
 bool _wsAuth(AsyncWebSocketClient* client) {
     IPAddress ip = client->remoteIP();
     auto now = WsTicket::TimeSource::now();
@@ -550,6 +1240,20 @@ void _wsPostParse(uint32_t client_id, bool save, bool reload) {
     });
 }
 
+// Module data is sent on request, only when client actually needs it
+void _wsModule(uint32_t client_id, espurna::StringView name) {
+    ws_on_send_callback_list_t callbacks;
+    for (const auto& callback : _ws_callbacks.on_module) {
+        if (callback.module == name) {
+            callbacks.push_back(callback.callback);
+        }
+    }
+
+    if (!callbacks.empty()) {
+        wsPostSequence(client_id, std::move(callbacks));
+    }
+}
+
 void _wsParse(AsyncWebSocketClient* client, uint8_t* payload, size_t length) {
     //DEBUG_MSG_P(PSTR("[WEBSOCKET] Parsing: %.*s\n"),
     //    length, reinterpret_cast<cont char*>(payload));
@@ -607,6 +1311,21 @@ void _wsParse(AsyncWebSocketClient* client, uint8_t* payload, size_t length) {
 
         JsonObject& data = root["data"];
         if (data.success()) {
+            if (strcmp(action, "binary") == 0) {
+                if (data[F("version")].as<int>() == espurna::web::ws::BinaryFrame::Version) {
+                    _wsBinaryEnable(client_id);
+                }
+                return;
+            }
+
+            if (strcmp(action, "module") == 0) {
+                const char* name = data[F("name")];
+                if (name) {
+                    _wsModule(client_id, name);
+                }
+                return;
+            }
+
             if (strcmp(action, "restore") == 0) {
                 const auto message = settingsRestoreJson(data)
                     ? STRING_VIEW("Changes saved, you should be able to reboot now")
@@ -686,6 +1405,24 @@ void _wsOnConnected(JsonObject& root) {
 
     root[F("webPort")] = getSetting(F("webPort"), espurna::web::ws::build::port());
     root[F("wsAuth")] = getSetting(F("wsAuth"), espurna::web::ws::build::authentication());
+
+    // Client replies with the 'binary' action when it is able to decode the telemetry frames
+    root[F("wsBinary")] = espurna::web::ws::BinaryFrame::Version;
+}
+
+// Every module only once, callbacks of the same module are expected to be registered together
+void _wsOnConnectedModules(JsonObject& root) {
+    const auto& callbacks = _ws_callbacks.on_module;
+    if (callbacks.empty()) {
+        return;
+    }
+
+    JsonArray& modules = root.createNestedArray(F("wsModules"));
+    for (auto it = callbacks.begin(); it != callbacks.end(); ++it) {
+        if ((it == callbacks.begin()) || (std::prev(it)->module != it->module)) {
+            modules.add(it->module);
+        }
+    }
 }
 
 void _wsConnected(uint32_t client_id) {
@@ -704,7 +1441,27 @@ void _wsConnected(uint32_t client_id) {
 
     wsPostAll(client_id, _ws_callbacks.on_visible);
     wsPostSequence(client_id, _ws_callbacks.on_connected);
-    wsPostSequence(client_id, _ws_callbacks.on_data);
+
+    // Module data is requested by the client when the module panel is shown. Clients that did not ask
+    // for the 'modules' feature would never do that, and receive everything right away instead
+    const auto* client = _wsClient(client_id);
+    if (client && (client->features & WsFeatureModules)) {
+        wsPostSequence(client_id, {_wsOnConnectedModules});
+    } else {
+        ws_on_send_callback_list_t modules;
+        for (const auto& callback : _ws_callbacks.on_module) {
+            modules.push_back(callback.callback);
+        }
+
+        if (!modules.empty()) {
+            wsPostSequence(client_id, std::move(modules));
+        }
+    }
+
+    // New client snapshot is empty, so it receives everything
+    WsPostponedCallbacks data(client_id, _ws_callbacks.on_data, WsPostponedCallbacks::Mode::Sequence);
+    data.delta(true);
+    _wsQueue(client_id, WsPriority::Bulk, data);
 }
 
 void _wsEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len) {
@@ -724,6 +1481,7 @@ void _wsEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType
         DEBUG_MSG_P(PSTR("[WEBSOCKET] #%u connected, ip: %s, url: %s\n"),
             client->id(), ip.c_str(), server->url());
 
+        _wsClientConnected(client->id(), _wsFeatures(client));
         _wsConnected(client->id());
         _wsResetUpdateTimer();
 
@@ -738,6 +1496,7 @@ void _wsEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType
             delete ptr;
             client->_tempObject = nullptr;
         }
+        _wsClientDisconnected(client->id());
         wifiApCheck();
         break;
 
@@ -763,62 +1522,111 @@ void _wsEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType
     }
 }
 
-void _wsHandlePostponedCallbacks(bool connected) {
-    // TODO: make this generic loop method to queue important ws messages?
-    //       or, if something uses ticker / async ctx to send messages,
-    //       it needs a retry mechanism built into the callback object
-    if (!connected && !_ws_queue.empty()) {
-        _ws_queue.pop();
-        return;
+// Entries that were waiting for too long are dropped. Since every queue is ordered by time,
+// only its first entries need to be checked
+void _wsExpireCallbacks(WsClient& client) {
+    using TimeSource = WsPostponedCallbacks::TimeSource;
+    using CpuSeconds = std::chrono::duration<TimeSource::rep>;
+
+    constexpr CpuSeconds WsQueueTimeoutClockCycles { 10 };
+
+    const auto now = TimeSource::now();
+    for (auto& queue : client.queues) {
+        while (!queue.empty() && (now - queue.front().timestamp() > WsQueueTimeoutClockCycles)) {
+            queue.pop_front();
+            ++client.dropped;
+        }
     }
+}
 
-    if (_ws_queue.empty()) return;
-    auto& callbacks = _ws_queue.front();
+bool _wsNextPriority(WsClient& client, WsPriority& out) {
+    if (!client.queue(WsPriority::Control).empty()) {
+        out = WsPriority::Control;
+        return true;
+    }
 
-    // avoid stalling forever when can't send anything
-    using TimeSource = espurna::time::CpuClock;
-    using CpuSeconds = std::chrono::duration<TimeSource::rep>;
+    const auto& bulk = client.queue(WsPriority::Bulk);
+    if (bulk.empty()) {
+        client.ready = true;
+    }
 
-    constexpr CpuSeconds WsQueueTimeoutClockCycles { 10 };
-    if (TimeSource::now() - callbacks.timestamp() > WsQueueTimeoutClockCycles) {
-        _ws_queue.pop();
-        return;
+    if (client.ready && !client.queue(WsPriority::State).empty()) {
+        out = WsPriority::State;
+        return true;
     }
 
-    // client id equal to 0 means we need to send the message to every client
-    if (callbacks.id()) {
-        AsyncWebSocketClient* ws_client = _ws.client(callbacks.id());
+    if (!bulk.empty()) {
+        out = WsPriority::Bulk;
+        return true;
+    }
 
-        // ...but, we need to check if client is still connected
-        if (!ws_client) {
-            _ws_queue.pop();
-            return;
-        }
+    return false;
+}
 
-        // wait until we can send the next batch of messages
-        // XXX: enforce that callbacks send only one message per iteration
-        if (ws_client->queueIsFull()) {
-            return;
-        }
+bool _wsHandlePostponedCallbacks(WsClient& client) {
+    auto* ws_client = _ws.client(client.id);
+    if (!ws_client) {
+        return false;
+    }
+
+    _wsExpireCallbacks(client);
+
+    // wait until we can send the next batch of messages
+    // XXX: enforce that callbacks send only one message per iteration
+    if (ws_client->queueIsFull()) {
+        return false;
+    }
+
+    WsPriority priority;
+    if (!_wsNextPriority(client, priority)) {
+        return false;
     }
 
+    const auto id = client.id;
+    auto& callbacks = client.queue(priority).front();
+
     // XXX: block allocation will try to create *2 next time,
     // likely failing and causing wsSend to reference empty objects
     // XXX: arduinojson6 will not do this, but we may need to use per-callback buffers
     constexpr size_t WsQueueJsonBufferSize = 3192;
-    DynamicJsonBuffer jsonBuffer(WsQueueJsonBufferSize);
+    WsJsonBuffer jsonBuffer(WsQueueJsonBufferSize);
     JsonObject& root = jsonBuffer.createObject();
 
     callbacks.send(root);
-    if (callbacks.id()) {
-        wsSend(callbacks.id(), root);
+
+    const bool done = callbacks.done();
+    if (callbacks.delta()) {
+        _wsSendDelta(jsonBuffer, client, root);
     } else {
-        wsSend(root);
+        wsSend(id, root);
+    }
+
+    // client list could've changed while sending, do not reference anything from before
+    if (done) {
+        auto* current = _wsClient(id);
+        if (current) {
+            current->queue(priority).pop_front();
+        }
     }
+
     yield();
 
-    if (callbacks.done()) {
-        _ws_queue.pop();
+    return true;
+}
+
+// Clients are served in turn, one message per loop. Stalled client only delays its own queue
+void _wsHandlePostponedCallbacks(bool connected) {
+    if (!connected || _ws_clients.empty()) {
+        _ws_json_pool.release();
+        return;
+    }
+
+    for (size_t attempt = 0; attempt < _ws_clients.size(); ++attempt) {
+        _ws_clients_next %= _ws_clients.size();
+        auto& client = _ws_clients[_ws_clients_next++];
+        if (_wsHandlePostponedCallbacks(client)) {
+            break;
+        }
     }
 }
 
@@ -826,6 +1634,7 @@ void _wsLoop() {
     const bool connected = wsConnected();
     _wsDoUpdate(connected);
     _wsHandlePostponedCallbacks(connected);
+    _wsSendBinary();
     #if DEBUG_WEB_SUPPORT
         _ws_debug.send(connected);
     #endif
@@ -843,6 +1652,16 @@ WsClientInfo wsClientInfo(uint32_t client_id) {
     WsClientInfo out;
     out.connected = (client != nullptr);
     out.stalled = out.connected && client->queueIsFull();
+    out.queued = 0;
+    out.dropped = 0;
+    out.merged = 0;
+
+    const auto* tracked = _wsClient(client_id);
+    if (tracked) {
+        out.queued = tracked->queued();
+        out.dropped = tracked->dropped;
+        out.merged = tracked->merged;
+    }
 
     return out;
 }
@@ -855,6 +1674,10 @@ bool wsConnected(uint32_t client_id) {
     return _ws.hasClient(client_id);
 }
 
+size_t wsClients() {
+    return _ws.count();
+}
+
 void wsPayloadModule(JsonObject& root, espurna::StringView name) {
     STRING_VIEW_INLINE(Key, "modulesVisible");
     JsonArray& modules = root.containsKey(Key)
@@ -922,6 +1745,43 @@ void wsSend(uint32_t client_id, const char * payload) {
     _ws.text(client_id, payload);
 }
 
+#if TERMINAL_SUPPORT
+
+namespace {
+
+PROGMEM_STRING(WsCommand, "WS");
+
+static void _wsCommand(::terminal::CommandContext&& ctx) {
+    for (const auto& client : _ws_clients) {
+        ctx.output.printf_P(PSTR("#%u {Binary=%s Ready=%s Control=%u State=%u Bulk=%u Dropped=%u Merged=%u}\n"),
+            client.id,
+            client.binary ? PSTR("yes") : PSTR("no"),
+            client.ready ? PSTR("yes") : PSTR("no"),
+            client.queues[static_cast<size_t>(WsPriority::Control)].size(),
+            client.queues[static_cast<size_t>(WsPriority::State)].size(),
+            client.queues[static_cast<size_t>(WsPriority::Bulk)].size(),
+            client.dropped, client.merged);
+    }
+
+    const auto& stats = _ws_json_pool.stats();
+    ctx.output.printf_P(PSTR("json buffers: allocated %u, reused %u, cached %u bytes\n"),
+        stats.allocated, stats.reused, stats.cached);
+
+    terminalOK(ctx);
+}
+
+static constexpr ::terminal::Command WsCommands[] PROGMEM {
+    {WsCommand, _wsCommand},
+};
+
+void _wsCommandsSetup() {
+    espurna::terminal::add(WsCommands);
+}
+
+} // namespace
+
+#endif
+
 void wsSetup() {
 
     _ws.onEvent(_wsEvent);
@@ -940,6 +1800,10 @@ void wsSetup() {
         .onConnected(_wsOnConnected)
         .onKeyCheck(_wsOnKeyCheck);
 
+#if TERMINAL_SUPPORT
+    _wsCommandsSetup();
+#endif
+
     espurnaRegisterLoop(_wsLoop);
 }
 
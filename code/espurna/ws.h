@@ -27,6 +27,12 @@ Copyright (C) 2019 by Maxim Prokhorov <prokhorov dot max at outlook dot com>
 // - on_connected is sent next, but each callback's data will be sent separately
 // - on_data is the final one, each callback is executed separately
 //
+// On request:
+// - on_module callbacks are registered with the module name, which is sent to the client as 'wsModules' list.
+//   Data is sent the same way as on_connected, but only after client asks for it with the 'module' action
+//   (e.g. when the module settings panel is opened). Clients that did not request the 'modules' feature
+//   through the /auth ticket receive this data right after on_connected instead
+//
 // While connected:
 // - on_action will be ran whenever we receive special JSON 'action' payload
 // - on_keycheck will be used to determine if we can handle specific settings keys
@@ -40,10 +46,18 @@ using ws_on_send_callback_list_t = std::vector<ws_on_send_callback_f>;
 using ws_on_action_callback_list_t = std::vector<ws_on_action_callback_f>;
 using ws_on_keycheck_callback_list_t = std::vector<ws_on_keycheck_callback_f>;
 
+struct ws_on_module_callback_t {
+    espurna::StringView module;
+    void(*callback)(JsonObject&);
+};
+
+using ws_on_module_callback_list_t = std::vector<ws_on_module_callback_t>;
+
 struct ws_callbacks_t {
     using on_send_f = void(*)(JsonObject&);
     ws_callbacks_t& onVisible(on_send_f);
     ws_callbacks_t& onConnected(on_send_f);
+    ws_callbacks_t& onConnected(espurna::StringView module, on_send_f);
     ws_callbacks_t& onData(on_send_f);
 
     using on_action_f = void(*)(uint32_t, const char*, JsonObject&);
@@ -55,6 +69,7 @@ struct ws_callbacks_t {
     ws_on_send_callback_list_t on_visible;
     ws_on_send_callback_list_t on_connected;
     ws_on_send_callback_list_t on_data;
+    ws_on_module_callback_list_t on_module;
 
     ws_on_action_callback_list_t on_action;
     ws_on_keycheck_callback_list_t on_keycheck;
@@ -66,6 +81,12 @@ bool wsDebugSend(const char* prefix, const char* message);
 
 // Postponed json messages. schedules callback(s) to be called when resources to do so are available.
 // Queued item is removed on client disconnection *or* when internal timeout occurs
+//
+// Every client has its own queue, broadcasts are copied to each one. Queues are processed by priority:
+// - wsPost() with the specific client_id (replies to the client actions)
+// - wsPost() to every client, wsPostDelta() and wsPostTelemetry() (status updates)
+// - wsPostAll() and wsPostSequence() (initial payload and configuration)
+// Status updates are only sent after the initial payload
 
 // There are two policies set on how to send the data:
 // - All will use the same JsonObject for each callback
@@ -82,6 +103,26 @@ void wsPost(ws_on_send_callback_f&& cb);
 void wsPost(uint32_t client_id, const ws_on_send_callback_f& cb);
 void wsPost(const ws_on_send_callback_f& cb);
 
+// Same as wsPost(), but each client only receives top-level keys which values had changed since
+// they were last sent to this specific client. Unchanged keys are sent again every WS_DELTA_RESYNC_INTERVAL
+// Nested objects and arrays are compared as a whole, any change there sends the whole key. Except for
+// the EnumerablePayload 'values', where only the changed entries are sent and the rest are 'null'
+// (but only when client requested the 'delta' feature through the /auth ticket)
+
+void wsPostDelta(uint32_t client_id, ws_on_send_callback_f&& cb);
+void wsPostDelta(ws_on_send_callback_f&& cb);
+void wsPostDelta(uint32_t client_id, const ws_on_send_callback_f& cb);
+void wsPostDelta(const ws_on_send_callback_f& cb);
+
+// Live telemetry. Clients that asked for the binary frames receive the result of the 'binary' callback
+// as soon as they have space in their queue, everyone else receives the JSON payload through wsPostDelta().
+// Frame is only generated when needed, and is not dropped when the client is busy
+
+// Queued telemetry update is not repeated when the same callback is posted again before it was sent
+
+using ws_on_binary_callback_f = espurna::web::ws::BinaryFrame(*)();
+void wsPostTelemetry(ws_callbacks_t::on_send_f cb, ws_on_binary_callback_f binary);
+
 void wsPostAll(uint32_t client_id, ws_on_send_callback_list_t&& cbs);
 void wsPostAll(ws_on_send_callback_list_t&& cbs);
 void wsPostAll(uint32_t client_id, const ws_on_send_callback_list_t& cbs);
@@ -108,12 +149,16 @@ void wsSend(const char* data);
 struct WsClientInfo {
     bool connected;
     bool stalled;
+    size_t queued;    // postponed messages waiting to be sent
+    uint32_t dropped; // postponed messages that were not sent because of the timeout or the queue limit
+    uint32_t merged;  // state updates superseded by the one already queued
 };
 
 WsClientInfo wsClientInfo(uint32_t client_id);
 
 bool wsConnected();
 bool wsConnected(uint32_t client_id);
+size_t wsClients();
 
 // Append module's name that webui can make it's widgets visible
 // (for the payload in `on_send` callback(s))
@@ -26,6 +26,7 @@ struct WsTicket {
     using TimeSource = espurna::time::CoreClock;
     IPAddress ip;
     TimeSource::time_point timestamp{};
+    uint8_t features { 0 };
 };
 
 // -----------------------------------------------------------------------------
@@ -35,6 +36,14 @@ struct WsTicket {
 // The idea here is to bind either:
 // - constant 'callbacks' list as reference, which was registered via wsRegister()
 // - in-place callback / callbacks that will be moved inside this container
+// Copies share the in-place storage, since broadcasts are queued separately for every client
+
+// Each client queue is processed in this order
+enum class WsPriority {
+    Control, // replies to the client actions
+    State,   // status updates, newer update supersedes the one that is still queued
+    Bulk,    // initial payload and configuration
+};
 
 class WsPostponedCallbacks {
 public:
@@ -117,6 +126,40 @@ public:
         return _client_id;
     }
 
+    // Only send the values that changed since the last time, see wsPostDelta()
+    bool delta() const {
+        return _delta;
+    }
+
+    void delta(bool value) {
+        _delta = value;
+    }
+
+    // Clients receiving binary frames already got this data, see wsPostTelemetry()
+    bool telemetry() const {
+        return _telemetry;
+    }
+
+    void telemetry(bool value) {
+        _telemetry = value;
+    }
+
+    // Only set for the plain functions generating the current state, which makes
+    // queued entry with the same key equivalent to the new one as long as it was not sent yet
+    using Key = void(*)(JsonObject&);
+
+    Key key() const {
+        return _key;
+    }
+
+    void key(Key value) {
+        _key = value;
+    }
+
+    bool started() const {
+        return _current != _callbacks.begin();
+    }
+
     TimeSource::time_point timestamp() const {
         return _timestamp;
     }
@@ -125,8 +168,11 @@ private:
     uint32_t _client_id;
     TimeSource::time_point _timestamp;
     Mode _mode;
+    bool _delta { false };
+    bool _telemetry { false };
+    Key _key { nullptr };
 
-    std::unique_ptr<ws_on_send_callback_list_t> _storage;
+    std::shared_ptr<ws_on_send_callback_list_t> _storage;
 
     const ws_on_send_callback_list_t& _callbacks;
     ws_on_send_callback_list_t::const_iterator _current;
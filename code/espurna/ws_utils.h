@@ -40,6 +40,9 @@ Copyright (C) 2019-2021 by Maxim Prokhorov <prokhorov dot max at outlook dot com
 
 #include <ArduinoJson.h>
 
+#include <cstdint>
+#include <vector>
+
 #include "settings.h"
 
 namespace espurna {
@@ -144,6 +147,57 @@ private:
     JsonArray& _root;
 };
 
+// Compact frames for the live telemetry, sent as binary messages to the clients that asked for them
+// Frame starts with its type, followed by the type-specific layout. Multi-byte values are little-endian
+// (native to the esp8266, decoder in the webui expects exactly that). See code/html/src/binary.mjs
+//
+// Magnitudes - u8 count, then for each magnitude: f64 value, u8 decimals, u8 units, u8 error
+// Relays - u8 count, then for each relay: u8 with bit0 as status and bits 1..2 as lock
+// Light - u8 flags (bit0 state, bit1 mireds, bit2 rgb, bit3 hsv), u8 brightness,
+//         u8 count and u8 value of each channel, then optional u16 mireds, u8[3] rgb and u16 hue, u8 saturation, u8 value
+struct BinaryFrame {
+    static constexpr uint8_t Version { 1 };
+
+    enum class Type : uint8_t {
+        Magnitudes = 1,
+        Relays = 2,
+        Light = 3,
+    };
+
+    BinaryFrame(Type type, size_t size) {
+        _data.reserve(size + 1);
+        u8(static_cast<uint8_t>(type));
+    }
+
+    void u8(uint8_t value) {
+        _data.push_back(value);
+    }
+
+    void u16(uint16_t value) {
+        write(&value, sizeof(value));
+    }
+
+    void f64(double value) {
+        write(&value, sizeof(value));
+    }
+
+    const uint8_t* data() const {
+        return _data.data();
+    }
+
+    size_t size() const {
+        return _data.size();
+    }
+
+private:
+    void write(const void* data, size_t size) {
+        const auto* ptr = static_cast<const uint8_t*>(data);
+        _data.insert(_data.end(), ptr, ptr + size);
+    }
+
+    std::vector<uint8_t> _data;
+};
+
 } // namespace ws
 } // namespace web
 } // namespace espurna
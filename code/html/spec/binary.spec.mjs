@@ -0,0 +1,128 @@
+import { expect, test } from 'vitest';
+import { decodeBinaryFrame } from '../src/binary.mjs';
+
+/**
+ * @param {number} size
+ * @param {function(DataView): void} callback
+ * @returns {ArrayBuffer}
+ */
+function makeFrame(size, callback) {
+    const out = new ArrayBuffer(size);
+    callback(new DataView(out));
+    return out;
+}
+
+test('magnitudes frame is decoded as json payload', () => {
+    const frame = makeFrame(2 + (3 * 11), (view) => {
+        view.setUint8(0, 1);
+        view.setUint8(1, 3);
+
+        view.setFloat64(2, 21.456, true);
+        view.setUint8(10, 1);
+        view.setUint8(11, 1);
+        view.setUint8(12, 0);
+
+        view.setFloat64(13, NaN, true);
+        view.setUint8(21, 2);
+        view.setUint8(22, 4);
+        view.setUint8(23, 0);
+
+        view.setFloat64(24, 230, true);
+        view.setUint8(32, 0);
+        view.setUint8(33, 7);
+        view.setUint8(34, 5);
+    });
+
+    expect(decodeBinaryFrame(frame)).toEqual({
+        magnitudes: {
+            schema: ['value', 'units', 'error'],
+            values: [
+                ['21.5', 1, 0],
+                ['nan', 4, 0],
+                ['230', 7, 5],
+            ],
+        },
+    });
+});
+
+test('relays frame unpacks status and lock', () => {
+    const frame = makeFrame(5, (view) => {
+        view.setUint8(0, 2);
+        view.setUint8(1, 3);
+        view.setUint8(2, 0b001);
+        view.setUint8(3, 0b010);
+        view.setUint8(4, 0b101);
+    });
+
+    expect(decodeBinaryFrame(frame)).toEqual({
+        relayState: {
+            schema: ['status', 'lock'],
+            values: [[1, 0], [0, 1], [1, 2]],
+        },
+    });
+});
+
+test('light frame only contains enabled fields', () => {
+    const rgb = makeFrame(11, (view) => {
+        view.setUint8(0, 3);
+        view.setUint8(1, 0b0101);
+        view.setUint8(2, 128);
+        view.setUint8(3, 3);
+        view.setUint8(4, 255);
+        view.setUint8(5, 10);
+        view.setUint8(6, 0);
+        view.setUint8(7, 0xff);
+        view.setUint8(8, 0x0a);
+        view.setUint8(9, 0x00);
+    });
+
+    expect(decodeBinaryFrame(rgb)).toEqual({
+        light: {
+            state: true,
+            brightness: 128,
+            values: [255, 10, 0],
+            rgb: '#FF0A00',
+        },
+    });
+
+    // hsv flag is set, but the values are missing
+    const truncated = makeFrame(8, (view) => {
+        view.setUint8(0, 3);
+        view.setUint8(1, 0b1010);
+        view.setUint8(2, 50);
+        view.setUint8(3, 0);
+        view.setUint16(4, 153, true);
+        view.setUint16(6, 300, true);
+    });
+
+    expect(() => decodeBinaryFrame(truncated)).toThrow();
+
+    const hsv = makeFrame(10, (view) => {
+        view.setUint8(0, 3);
+        view.setUint8(1, 0b1010);
+        view.setUint8(2, 50);
+        view.setUint8(3, 0);
+        view.setUint16(4, 153, true);
+        view.setUint16(6, 300, true);
+        view.setUint8(8, 75);
+        view.setUint8(9, 20);
+    });
+
+    expect(decodeBinaryFrame(hsv)).toEqual({
+        light: {
+            state: false,
+            brightness: 50,
+            values: [],
+            mireds: 153,
+            hsv: '300,75,20',
+        },
+    });
+});
+
+test('unknown frames are ignored', () => {
+    const frame = makeFrame(2, (view) => {
+        view.setUint8(0, 255);
+    });
+
+    expect(decodeBinaryFrame(frame)).toEqual({});
+});
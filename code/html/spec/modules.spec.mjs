@@ -0,0 +1,20 @@
+import { expect, test } from 'vitest';
+import { ModuleRequests } from '../src/modules.mjs';
+
+test('module is requested only once, and only when offered', () => {
+    const requests = new ModuleRequests();
+    expect(requests.show('sch')).toEqual([]);
+
+    expect(requests.offer(['rfb', 'sch'])).toEqual(['sch']);
+    expect(requests.show('sch')).toEqual([]);
+
+    expect(requests.show('status')).toEqual([]);
+    expect(requests.show('rfb')).toEqual(['rfb']);
+    expect(requests.show('rfb')).toEqual([]);
+});
+
+test('offer without any panel shown does not request anything', () => {
+    const requests = new ModuleRequests();
+    expect(requests.offer(['mqtt'])).toEqual([]);
+    expect(requests.show('mqtt')).toEqual(['mqtt']);
+});
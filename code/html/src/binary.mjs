@@ -0,0 +1,169 @@
+import { sendAction } from './connection.mjs';
+import { listenVariables } from './settings.mjs';
+
+// Compact telemetry frames, see `espurna::web::ws::BinaryFrame`
+// Decoded frame has exactly the same layout as the JSON payload
+// with the same keys, and is handled by the usual variable listeners
+
+export const BINARY_VERSION = 1;
+
+const TYPE_MAGNITUDES = 1;
+const TYPE_RELAYS = 2;
+const TYPE_LIGHT = 3;
+
+class FrameReader {
+    /** @param {ArrayBuffer} buffer */
+    constructor(buffer) {
+        this.view = new DataView(buffer);
+        this.offset = 0;
+    }
+
+    /** @returns {number} */
+    u8() {
+        const out = this.view.getUint8(this.offset);
+        this.offset += 1;
+        return out;
+    }
+
+    /** @returns {number} */
+    u16() {
+        const out = this.view.getUint16(this.offset, true);
+        this.offset += 2;
+        return out;
+    }
+
+    /** @returns {number} */
+    f64() {
+        const out = this.view.getFloat64(this.offset, true);
+        this.offset += 8;
+        return out;
+    }
+}
+
+/**
+ * Same as the firmware-side formatter, which uses 'inf' regardless of the sign
+ * @param {number} value
+ * @param {number} decimals
+ * @returns {string}
+ */
+function formatMagnitude(value, decimals) {
+    if (Number.isNaN(value)) {
+        return "nan";
+    }
+
+    if (!Number.isFinite(value)) {
+        return "inf";
+    }
+
+    return value.toFixed(decimals);
+}
+
+/** @param {FrameReader} reader */
+function magnitudes(reader) {
+    const values = [];
+
+    const count = reader.u8();
+    for (let index = 0; index < count; ++index) {
+        const value = reader.f64();
+        const decimals = reader.u8();
+        const units = reader.u8();
+        const error = reader.u8();
+        values.push([formatMagnitude(value, decimals), units, error]);
+    }
+
+    return {
+        "magnitudes": {
+            schema: ["value", "units", "error"],
+            values,
+        },
+    };
+}
+
+/** @param {FrameReader} reader */
+function relays(reader) {
+    const values = [];
+
+    const count = reader.u8();
+    for (let index = 0; index < count; ++index) {
+        const packed = reader.u8();
+        values.push([packed & 1, (packed >> 1) & 3]);
+    }
+
+    return {
+        "relayState": {
+            schema: ["status", "lock"],
+            values,
+        },
+    };
+}
+
+/**
+ * @param {number} value
+ * @returns {string}
+ */
+function hexByte(value) {
+    return value.toString(16).padStart(2, "0").toUpperCase();
+}
+
+/** @param {FrameReader} reader */
+function light(reader) {
+    const flags = reader.u8();
+
+    /** @type {{[k: string]: any}} */
+    const out = {
+        state: (flags & 1) === 1,
+        brightness: reader.u8(),
+    };
+
+    const values = [];
+
+    const count = reader.u8();
+    for (let index = 0; index < count; ++index) {
+        values.push(reader.u8());
+    }
+
+    out.values = values;
+
+    if (flags & (1 << 1)) {
+        out.mireds = reader.u16();
+    }
+
+    if (flags & (1 << 2)) {
+        out.rgb = `#${hexByte(reader.u8())}${hexByte(reader.u8())}${hexByte(reader.u8())}`;
+    } else if (flags & (1 << 3)) {
+        const hue = reader.u16();
+        const saturation = reader.u8();
+        const value = reader.u8();
+        out.hsv = `${hue},${saturation},${value}`;
+    }
+
+    return {"light": out};
+}
+
+/**
+ * @param {ArrayBuffer} buffer
+ * @returns {{[k: string]: any}}
+ */
+export function decodeBinaryFrame(buffer) {
+    const reader = new FrameReader(buffer);
+
+    switch (reader.u8()) {
+    case TYPE_MAGNITUDES:
+        return magnitudes(reader);
+    case TYPE_RELAYS:
+        return relays(reader);
+    case TYPE_LIGHT:
+        return light(reader);
+    }
+
+    return {};
+}
+
+export function init() {
+    // Device offers the frames right after connecting, only accept the version we understand
+    listenVariables("wsBinary", (_, value) => {
+        if (value === BINARY_VERSION) {
+            sendAction("binary", {version: value});
+        }
+    });
+}
@@ -28,13 +28,23 @@ function makeUrl(path, root) {
     return out;
 }
 
+// Optional parts of the protocol that are understood by this version of the webui
+// Device does not use them unless they are listed when requesting the ticket
+const Features = [
+    "delta",
+    "modules",
+];
+
 /**
  * @param {URL} root
  * @returns ConnectionUrls
  */
 function makeConnectionUrls(root) {
+    const auth = makeUrl("auth", root);
+    auth.searchParams.set("features", Features.join(","));
+
     return {
-        auth: makeUrl("auth", root),
+        auth,
         config: makeUrl("config", root),
         upgrade: makeUrl("upgrade", root),
         ws: makeWebSocketUrl(root),
@@ -96,6 +106,7 @@ class ConnectionBase {
  */
 ConnectionBase.prototype.open = function(urls, {onopen = null, onclose = null, onmessage = null} = {}) {
     this._socket = new WebSocket(urls.ws.href);
+    this._socket.binaryType = "arraybuffer";
     this._socket.onopen = (event) => {
         this._ping_pong = setInterval(
             () => { sendAction("ping"); }, 5000);
@@ -107,6 +107,9 @@ export function showPanel(elem) {
         elem.style.display = "revert";
     }
 
+    window.dispatchEvent(
+        new CustomEvent("app-panel", {detail: {name: elem.id.replace(/^panel-/, "")}}));
+
     const layout = document.getElementById("layout")
     if (layout) {
         menuHide(layout);
@@ -32,6 +32,12 @@ import {
     sendAction,
 } from './connection.mjs';
 
+import {
+    init as initBinary,
+    decodeBinaryFrame,
+} from './binary.mjs';
+import { init as initModules } from './modules.mjs';
+
 import { init as initApi } from './api.mjs';
 import { init as initCurtain } from './curtain.mjs';
 import { init as initDebug } from './debug.mjs';
@@ -312,7 +318,7 @@ function onConnectionClose(event) {
 /**
  * @param {MessageEvent<any>} event
  */
-function onJsonPayload(event) {
+function onPayload(event) {
     Ago = 0;
 
     if (!KeepTime) {
@@ -320,6 +326,11 @@ function onJsonPayload(event) {
     }
 
     try {
+        if (event.data instanceof ArrayBuffer) {
+            updateVariables(decodeBinaryFrame(event.data));
+            return;
+        }
+
         const parsed = JSON.parse(
             event.data
                 .replace(/:Infinity/g, ':"inf"')
@@ -359,6 +370,8 @@ function init() {
     variableListeners(listeners());
 
     initConnection();
+    initBinary();
+    initModules();
     initSettings();
     initPassword();
     initWiFi();
@@ -444,7 +457,7 @@ function init() {
     }
 
     // don't autoconnect w/ localhost or file://
-    connect({onclose: onConnectionClose, onmessage: onJsonPayload});
+    connect({onclose: onConnectionClose, onmessage: onPayload});
 }
 
 document.addEventListener("DOMContentLoaded", init);
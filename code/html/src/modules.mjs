@@ -0,0 +1,69 @@
+import { sendAction } from './connection.mjs';
+import { listenVariables } from './settings.mjs';
+
+// Device does not send settings of every module right after connecting. Instead,
+// such modules are listed in 'wsModules' and the data is requested once the panel
+// with the same name is shown. See `ws_callbacks_t::onConnected(module, ...)`
+
+export class ModuleRequests {
+    constructor() {
+        /** @type {Set<string>} */
+        this.available = new Set();
+
+        /** @type {Set<string>} */
+        this.requested = new Set();
+
+        /** @type {string | null} */
+        this.current = null;
+    }
+
+    /**
+     * Panel might have been shown before the list arrived
+     * @param {string[]} modules
+     * @returns {string[]}
+     */
+    offer(modules) {
+        modules.forEach((module) => {
+            this.available.add(module);
+        });
+
+        return (this.current !== null)
+            ? this.show(this.current)
+            : [];
+    }
+
+    /**
+     * @param {string} name
+     * @returns {string[]}
+     */
+    show(name) {
+        this.current = name;
+        if (!this.available.has(name) || this.requested.has(name)) {
+            return [];
+        }
+
+        this.requested.add(name);
+        return [name];
+    }
+}
+
+const Requests = new ModuleRequests();
+
+/** @param {string[]} names */
+function request(names) {
+    names.forEach((name) => {
+        sendAction("module", {name});
+    });
+}
+
+export function init() {
+    listenVariables("wsModules", (_, value) => {
+        request(Requests.offer(value));
+    });
+
+    window.addEventListener("app-panel", (event) => {
+        const name = /** @type {CustomEvent<{name: string}>} */
+            (event).detail.name;
+        request(Requests.show(name));
+    });
+}
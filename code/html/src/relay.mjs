@@ -71,6 +71,11 @@ function initToggle(id) {
  */
 function updateFromState(states, schema) {
     states.forEach((state, id) => {
+        // delta updates only include the relays that changed
+        if (!state) {
+            return;
+        }
+
         const elem = /** @type {!HTMLInputElement} */
             (document.querySelector(`input[name='relay'][data-id='${id}']`));
 
@@ -554,6 +554,11 @@ function initMagnitudesSettings(values, schema) {
  */
 function updateMagnitudes(values, schema) {
     values.forEach((value, id) => {
+        // delta updates only include the magnitudes that changed
+        if (!value) {
+            return;
+        }
+
         const props = Magnitudes.properties.get(id);
         if (!props) {
             return;
@@ -599,6 +604,10 @@ function updateEnergyInput(input, saved) {
  */
 function updateEnergy(values, schema) {
     values.forEach((value) => {
+        if (!value) {
+            return;
+        }
+
         const energy = fromSchema(value, schema);
 
         const props = Magnitudes.properties.get(
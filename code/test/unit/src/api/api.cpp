@@ -0,0 +1,110 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <ArduinoJson.h>
+
+#include <espurna/api_body.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace espurna {
+namespace api {
+namespace test {
+namespace {
+
+bool append(Body& body, const char* data, size_t index, size_t total) {
+    return body.append(
+        reinterpret_cast<const uint8_t*>(data), std::strlen(data), index, total);
+}
+
+void test_body_packets() {
+    const char payload[] = R"({"relay":[1,0,1],"name":"kitchen"})";
+    constexpr size_t Total { sizeof(payload) - 1 };
+
+    Body body(1024);
+    TEST_ASSERT(body.append(reinterpret_cast<const uint8_t*>(&payload[0]), 10, 0, Total));
+    TEST_ASSERT_FALSE(body.complete());
+    TEST_ASSERT(body.append(reinterpret_cast<const uint8_t*>(&payload[10]), 5, 10, Total));
+    TEST_ASSERT_FALSE(body.complete());
+    TEST_ASSERT(body.append(reinterpret_cast<const uint8_t*>(&payload[15]), Total - 15, 15, Total));
+    TEST_ASSERT(body.complete());
+    TEST_ASSERT_EQUAL(Total, body.size());
+
+    DynamicJsonBuffer buffer(64);
+    JsonObject& root = buffer.parseObject(body);
+    TEST_ASSERT(root.success());
+    TEST_ASSERT_EQUAL(3, root["relay"].as<JsonArray&>().size());
+    TEST_ASSERT_EQUAL_STRING("kitchen", root["name"].as<const char*>());
+}
+
+void test_body_chunks() {
+    // value is split between multiple chunks
+    String value;
+    for (size_t index = 0; index < (Body::ChunkSize * 2) + 17; ++index) {
+        value += static_cast<char>('a' + (index % 26));
+    }
+
+    String payload;
+    payload += "{\"value\":\"";
+    payload += value;
+    payload += "\"}";
+
+    Body body(Body::ChunkSize * 4);
+    for (size_t index = 0; index < payload.length(); index += 100) {
+        const auto length = std::min<size_t>(payload.length() - index, 100);
+        TEST_ASSERT(body.append(
+            reinterpret_cast<const uint8_t*>(payload.c_str()) + index,
+            length, index, payload.length()));
+    }
+
+    TEST_ASSERT(body.complete());
+
+    DynamicJsonBuffer buffer(64);
+    JsonObject& root = buffer.parseObject(body);
+    TEST_ASSERT(root.success());
+    TEST_ASSERT_EQUAL_STRING(value.c_str(), root["value"].as<const char*>());
+}
+
+void test_body_errors() {
+    Body large(8);
+    TEST_ASSERT_FALSE(append(large, "{\"a\":", 0, 16));
+    TEST_ASSERT(Body::Error::TooLarge == large.error());
+
+    // nothing else is accepted after an error
+    TEST_ASSERT_FALSE(append(large, "1}", 5, 16));
+    TEST_ASSERT(Body::Error::TooLarge == large.error());
+
+    Body gap(64);
+    TEST_ASSERT(append(gap, "{\"a\":", 0, 16));
+    TEST_ASSERT_FALSE(append(gap, "1}", 7, 16));
+    TEST_ASSERT(Body::Error::Unexpected == gap.error());
+
+    Body overflow(64);
+    TEST_ASSERT(append(overflow, "{\"a\":", 0, 7));
+    TEST_ASSERT_FALSE(append(overflow, "123}", 5, 7));
+    TEST_ASSERT(Body::Error::Unexpected == overflow.error());
+    TEST_ASSERT_FALSE(overflow.complete());
+
+    // parser stops at the body size, incomplete object is an error
+    Body partial(64);
+    TEST_ASSERT(append(partial, "{\"a\":", 0, 5));
+    TEST_ASSERT(partial.complete());
+
+    DynamicJsonBuffer buffer(64);
+    TEST_ASSERT_FALSE(buffer.parseObject(partial).success());
+}
+
+} // namespace
+} // namespace test
+} // namespace api
+} // namespace espurna
+
+int main(int, char**) {
+    using namespace espurna::api::test;
+    UNITY_BEGIN();
+    RUN_TEST(test_body_packets);
+    RUN_TEST(test_body_chunks);
+    RUN_TEST(test_body_errors);
+    return UNITY_END();
+}
@@ -0,0 +1,222 @@
+#include <unity.h>
+
+#include <Arduino.h>
+
+#include <espurna/api_path.h>
+
+#include "../benchmark/benchmark.h"
+
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+// API router, comparing the list of handlers (where every one of them parses request path and
+// tries to match it with its own pattern) and the PathTrie (path is parsed once and matched once)
+// Patterns are the ones registered by relay, light and sensor modules, plus generated ones
+//
+// Number of patterns can be specified on the command line, e.g. to run only a single case
+// $ test-api_path <patterns>
+
+namespace espurna {
+namespace test {
+namespace {
+
+constexpr const char* Patterns[] {
+    "api/relay",
+    "api/relay/batch",
+    "api/relay/+",
+    "api/pulse/+",
+    "api/timer/+",
+    "api/lock/+",
+    "api/rgb",
+    "api/hsv",
+    "api/mired",
+    "api/transition",
+    "api/transition/+",
+    "api/brightness",
+    "api/channel/+",
+    "api/light",
+    "api/magnitudes",
+    "api/read/+",
+    "api/temperature/+",
+    "api/humidity/+",
+    "api/schedule",
+    "api/schedule/+",
+    "api/list",
+    "api/rpc",
+};
+
+constexpr const char* Paths[] {
+    "api/relay",
+    "api/relay/batch",
+    "api/relay/0",
+    "api/lock/3",
+    "api/light",
+    "api/channel/2",
+    "api/read/temperature",
+    "api/humidity/1",
+    "api/rpc",
+    "api/unknown",
+    "api/relay/0/extra",
+    "static/index.html",
+};
+
+struct Router {
+    explicit Router(size_t size) {
+        // PathParts reference the string, make sure it is not moved later
+        _patterns.reserve(size);
+        for (size_t index = 0; index < size; ++index) {
+            if (index < std::size(Patterns)) {
+                _patterns.emplace_back(Patterns[index]);
+                continue;
+            }
+
+            String pattern("api/generated");
+            pattern += String(index, 10);
+            if (index % 2) {
+                pattern += "/+";
+            }
+
+            _patterns.push_back(std::move(pattern));
+        }
+
+        _parts.reserve(size);
+        for (size_t index = 0; index < size; ++index) {
+            _parts.emplace_back(_patterns[index]);
+            TEST_ASSERT(_trie.add(_parts.back(), index));
+        }
+    }
+
+    size_t size() const {
+        return _parts.size();
+    }
+
+    // Same as the list of web handlers, every one of them parses the path again
+    PathTrie::Id linear(StringView path) const {
+        for (size_t index = 0; index < _parts.size(); ++index) {
+            if (_parts[index].match(PathParts(path))) {
+                return index;
+            }
+        }
+
+        return PathTrie::None;
+    }
+
+    PathTrie::Id trie(StringView path) const {
+        return _trie.match(PathParts(path));
+    }
+
+    const PathTrie& nodes() const {
+        return _trie;
+    }
+
+private:
+    std::vector<String> _patterns;
+    std::vector<PathParts> _parts;
+    PathTrie _trie;
+};
+
+void test_trie_match() {
+    String relay("relay/+");
+    String batch("relay/batch");
+    String any("relay/#");
+    String lock("lock/+/+");
+
+    PathTrie trie;
+    TEST_ASSERT(trie.add(PathParts(batch), 0));
+    TEST_ASSERT(trie.add(PathParts(relay), 1));
+    TEST_ASSERT(trie.add(PathParts(any), 2));
+    TEST_ASSERT(trie.add(PathParts(lock), 3));
+
+    // same pattern cannot be added twice, broken one cannot be added at all
+    TEST_ASSERT_FALSE(trie.add(PathParts(relay), 4));
+    TEST_ASSERT_FALSE(trie.add(PathParts("relay/#/broken"), 5));
+
+    // 'relay' is shared by all of the relay patterns
+    TEST_ASSERT_EQUAL(8, trie.size());
+
+    // when multiple patterns match, the one added first wins
+    TEST_ASSERT_EQUAL(0, trie.match("relay/batch"));
+    TEST_ASSERT_EQUAL(1, trie.match("relay/5"));
+    TEST_ASSERT_EQUAL(2, trie.match("relay/5/something"));
+    TEST_ASSERT_EQUAL(2, trie.match("relay"));
+
+    TEST_ASSERT_EQUAL(3, trie.match("lock/1/2"));
+    TEST_ASSERT_EQUAL(PathTrie::None, trie.match("lock/1"));
+    TEST_ASSERT_EQUAL(PathTrie::None, trie.match("lock/1/2/3"));
+
+    // paths cannot contain wildcards
+    TEST_ASSERT_EQUAL(PathTrie::None, trie.match("relay/+"));
+    TEST_ASSERT_EQUAL(PathTrie::None, trie.match(""));
+}
+
+std::vector<size_t> sizes;
+
+void test_router() {
+    constexpr size_t Lookups { 10000 };
+
+    for (auto size : sizes) {
+        Router router(size);
+
+        // results are expected to be exactly the same
+        for (const auto* path : Paths) {
+            TEST_ASSERT_EQUAL(router.linear(path), router.trie(path));
+        }
+
+        size_t linear_matches { 0 };
+        const auto linear = benchmark::measure(Lookups,
+            [&](size_t iteration) {
+                const auto* path = Paths[iteration % std::size(Paths)];
+                linear_matches += (router.linear(path) != PathTrie::None) ? 1 : 0;
+            });
+
+        size_t trie_matches { 0 };
+        const auto trie = benchmark::measure(Lookups,
+            [&](size_t iteration) {
+                const auto* path = Paths[iteration % std::size(Paths)];
+                trie_matches += (router.trie(path) != PathTrie::None) ? 1 : 0;
+            });
+
+        TEST_ASSERT_EQUAL(linear_matches, trie_matches);
+
+        // only the path parts vector, exactly once
+        TEST_ASSERT_EQUAL_DOUBLE(1.0, trie.allocations);
+
+        char name[128];
+        snprintf(name, sizeof(name), "linear patterns=%zu", router.size());
+        benchmark::print(name, linear);
+
+        snprintf(name, sizeof(name), "trie patterns=%zu (%zu nodes)",
+            router.size(), router.nodes().size());
+        benchmark::print(name, trie);
+    }
+}
+
+} // namespace
+} // namespace test
+} // namespace espurna
+
+int main(int argc, char** argv) {
+    using namespace espurna::test;
+    if (argc > 2) {
+        printf("%s <patterns>\n", argv[0]);
+        return 1;
+    }
+
+    if (argc == 2) {
+        const auto size = std::strtoul(argv[1], nullptr, 10);
+        if (!size) {
+            printf("%s <patterns>\n", argv[0]);
+            return 1;
+        }
+
+        sizes.push_back(size);
+    } else {
+        sizes = {std::size(Patterns), 64, 256};
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_trie_match);
+    RUN_TEST(test_router);
+    return UNITY_END();
+}
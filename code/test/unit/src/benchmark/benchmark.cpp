@@ -0,0 +1,92 @@
+#include <unity.h>
+
+#include "benchmark.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Replace libc allocation functions to keep track of heap usage. Both String (realloc)
+// and operator new (malloc) end up here, so there's no need to replace the latter.
+// Only glibc provides __libc_... functions, other platforms won't have any counts
+
+#if defined(__GLIBC__)
+extern "C" {
+
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+void __libc_free(void*);
+
+} // extern "C"
+#endif
+
+namespace espurna {
+namespace test {
+namespace benchmark {
+namespace {
+namespace internal {
+
+Allocations allocations { 0, 0 };
+
+} // namespace internal
+
+void track(size_t size) {
+    ++internal::allocations.count;
+    internal::allocations.bytes += size;
+}
+
+} // namespace
+
+Allocations allocations() {
+    return internal::allocations;
+}
+
+uint64_t cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+void print(const char* name, const Result& result) {
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer),
+        "%s: %zu iterations, %.1f ns, %.0f cycles, %.2f allocations (%.1f bytes) per iteration",
+        name, result.iterations, result.nanoseconds, result.cycles,
+        result.allocations, result.bytes);
+    TEST_MESSAGE(buffer);
+}
+
+} // namespace benchmark
+} // namespace test
+} // namespace espurna
+
+#if defined(__GLIBC__)
+extern "C" {
+
+void* malloc(size_t size) {
+    espurna::test::benchmark::track(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    espurna::test::benchmark::track(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    espurna::test::benchmark::track(size);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+    __libc_free(ptr);
+}
+
+} // extern "C"
+#endif
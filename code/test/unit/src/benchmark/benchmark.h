@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Minimal helpers for host benchmarks. Not a replacement for the on-device measurements,
+// but should be enough to compare relative costs and to catch regressions in heap usage.
+
+namespace espurna {
+namespace test {
+namespace benchmark {
+
+// Total number of heap allocations (malloc, calloc, realloc, operator new) since the program start
+struct Allocations {
+    size_t count;
+    size_t bytes;
+};
+
+Allocations allocations();
+
+// Current value of the cpu cycle counter, when available. Otherwise, always returns 0
+uint64_t cycles();
+
+struct Result {
+    size_t iterations;
+    double nanoseconds;
+    double cycles;
+    double allocations;
+    double bytes;
+};
+
+// Per-iteration average of everything that happened inside of the callback
+template <typename T>
+Result measure(size_t iterations, T&& callback) {
+    using Clock = std::chrono::steady_clock;
+
+    const auto allocations_start = allocations();
+    const auto cycles_start = cycles();
+    const auto time_start = Clock::now();
+
+    for (size_t iteration = 0; iteration < iterations; ++iteration) {
+        callback(iteration);
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(
+        Clock::now() - time_start);
+    const auto cycles_end = cycles();
+    const auto allocations_end = allocations();
+
+    const auto divisor = static_cast<double>(iterations ? iterations : 1);
+
+    return Result{
+        .iterations = iterations,
+        .nanoseconds = elapsed.count() / divisor,
+        .cycles = static_cast<double>(cycles_end - cycles_start) / divisor,
+        .allocations = static_cast<double>(allocations_end.count - allocations_start.count) / divisor,
+        .bytes = static_cast<double>(allocations_end.bytes - allocations_start.bytes) / divisor,
+    };
+}
+
+// Result is sent as unity message, prefixed with the benchmark name
+void print(const char* name, const Result&);
+
+} // namespace benchmark
+} // namespace test
+} // namespace espurna
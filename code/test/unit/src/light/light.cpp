@@ -0,0 +1,227 @@
+#include <unity.h>
+
+#include <Arduino.h>
+
+#include <espurna/light_common.ipp>
+
+#include <cstdint>
+#include <iterator>
+
+namespace espurna {
+namespace test {
+namespace {
+
+// Same as LIGHT_MIN_VALUE and LIGHT_MAX_VALUE defaults
+constexpr long ValueMin { 0 };
+constexpr long ValueMax { 255 };
+
+// Channel output as it was calculated before the tables were introduced.
+// Gamma is mapped via the 8bit table, inverse flips the value, range is scaled to the provider one
+long reference_gamma(long value) {
+    constexpr auto Divisor = (ValueMax - ValueMin);
+    const long Scaled {
+        (value - ValueMin) * (light::output::GammaMax - light::output::GammaMin) / Divisor
+            + light::output::GammaMin };
+    return light::output::gamma_value(static_cast<size_t>(Scaled));
+}
+
+template <typename T>
+T reference_value_map(long value, T min, T max) {
+    return (value - ValueMin) * (max - min) / (ValueMax - ValueMin) + min;
+}
+
+template <typename T>
+T reference(long value, bool gamma, bool inverse, T min, T max) {
+    if (gamma) {
+        value = reference_gamma(value);
+    }
+
+    if (inverse) {
+        value = ValueMax - value;
+    }
+
+    return reference_value_map(value, min, max);
+}
+
+template <typename T>
+void check_table(T min, T max) {
+    using Table = light::output::Table<T, ValueMin, ValueMax>;
+    Table table;
+
+    for (const bool gamma : {false, true}) {
+        for (const bool inverse : {false, true}) {
+            table.reset(typename Table::Options{
+                .gamma = gamma,
+                .inverse = inverse,
+                .min = min,
+                .max = max,
+            });
+
+            for (long value = ValueMin; value <= ValueMax; ++value) {
+                TEST_ASSERT(reference(value, gamma, inverse, min, max) == table[value]);
+            }
+        }
+    }
+}
+
+void test_output_table_size() {
+    using Table = light::output::Table<uint32_t, ValueMin, ValueMax>;
+    TEST_ASSERT_EQUAL(256, Table::Size);
+}
+
+// generic esp8266 pwm (default and custom periods) & the pwm library from the esp8266 sdk
+void test_output_table_pwm() {
+    check_table<uint32_t>(0, 255);
+    check_table<uint32_t>(0, 1023);
+    check_table<uint32_t>(0, 5000);
+    check_table<uint32_t>(0, 10000);
+    check_table<uint32_t>(0, 22222);
+}
+
+// my92xx 8, 12, 14 and 16 bit commands
+void test_output_table_my92xx() {
+    check_table<uint16_t>(0, 255);
+    check_table<uint16_t>(0, 4095);
+    check_table<uint16_t>(0, 16383);
+    check_table<uint16_t>(0, 65535);
+}
+
+// custom providers receive a floating point value in the same range as the input
+void test_output_table_custom() {
+    check_table<float>(static_cast<float>(ValueMin), static_cast<float>(ValueMax));
+}
+
+void test_output_table_bounds() {
+    using Table = light::output::Table<uint32_t, ValueMin, ValueMax>;
+
+    Table table;
+    table.reset(Table::Options{
+        .gamma = true,
+        .inverse = true,
+        .min = 0,
+        .max = 1023,
+    });
+
+    TEST_ASSERT_EQUAL(1023, table[ValueMin]);
+    TEST_ASSERT_EQUAL(0, table[ValueMax]);
+
+    TEST_ASSERT_EQUAL(table[ValueMin], table[ValueMin - 100]);
+    TEST_ASSERT_EQUAL(table[ValueMax], table[ValueMax + 100]);
+}
+
+void test_output_table_options() {
+    using Table = light::output::Table<uint16_t, ValueMin, ValueMax>;
+
+    const Table::Options options{
+        .gamma = true,
+        .inverse = false,
+        .min = 0,
+        .max = 4095,
+    };
+
+    Table table;
+    table.reset(options);
+    TEST_ASSERT(table.options() == options);
+
+    auto other = options;
+    other.inverse = true;
+    TEST_ASSERT(!(table.options() == other));
+
+    table.reset(other);
+    TEST_ASSERT(table.options() == other);
+    TEST_ASSERT_EQUAL(4095, table[ValueMin]);
+}
+
+namespace easing = light::easing;
+
+constexpr easing::Points Linear = easing::make(easing::linear);
+constexpr easing::Points EaseIn = easing::make(easing::in);
+constexpr easing::Points EaseOut = easing::make(easing::out);
+constexpr easing::Points EaseInOut = easing::make(easing::in_out);
+constexpr easing::Points Perceptual = easing::make(easing::perceptual);
+
+constexpr const easing::Points* Curves[] {
+    &Linear, &EaseIn, &EaseOut, &EaseInOut, &Perceptual,
+};
+
+// progress of the linear transition is not changed
+void test_easing_linear() {
+    for (uint32_t progress = 0; progress <= easing::ProgressMax; ++progress) {
+        TEST_ASSERT_EQUAL(progress, easing::value(Linear, progress));
+        TEST_ASSERT_EQUAL(progress, easing::reverse(Linear, progress));
+    }
+}
+
+// every curve starts at zero, ends at max and never goes back
+void test_easing_bounds() {
+    for (const auto* curve : Curves) {
+        TEST_ASSERT_EQUAL(0, easing::value(*curve, 0));
+        TEST_ASSERT_EQUAL(easing::ProgressMax, easing::value(*curve, easing::ProgressMax));
+        TEST_ASSERT_EQUAL(easing::ProgressMax, easing::value(*curve, easing::ProgressMax + 1));
+
+        TEST_ASSERT_EQUAL(0, easing::reverse(*curve, 0));
+        TEST_ASSERT_EQUAL(easing::ProgressMax, easing::reverse(*curve, easing::ProgressMax));
+
+        uint32_t last { 0 };
+        uint32_t last_reverse { 0 };
+        for (uint32_t progress = 0; progress <= easing::ProgressMax; ++progress) {
+            const auto value = easing::value(*curve, progress);
+            TEST_ASSERT(value >= last);
+            last = value;
+
+            const auto reverse = easing::reverse(*curve, progress);
+            TEST_ASSERT(reverse >= last_reverse);
+            last_reverse = reverse;
+        }
+    }
+}
+
+// segments are close enough to the original function
+void test_easing_accuracy() {
+    using Func = double(*)(double);
+    constexpr Func Funcs[] {
+        easing::linear, easing::in, easing::out, easing::in_out, easing::perceptual,
+    };
+
+    for (size_t index = 0; index < std::size(Funcs); ++index) {
+        for (uint32_t progress = 0; progress <= easing::ProgressMax; progress += 7) {
+            const auto x = static_cast<double>(progress) / static_cast<double>(easing::ProgressMax);
+            const auto expected = Funcs[index](x) * static_cast<double>(easing::ProgressMax);
+            const auto value = static_cast<double>(easing::value(*Curves[index], progress));
+            TEST_ASSERT_DOUBLE_WITHIN(easing::ProgressMax / 1000.0, expected, value);
+        }
+    }
+}
+
+// curves can be used in either direction
+void test_easing_reverse() {
+    for (uint32_t progress = 0; progress <= easing::ProgressMax; progress += 13) {
+        TEST_ASSERT_UINT32_WITHIN(1, easing::value(EaseOut, progress), easing::reverse(EaseIn, progress));
+        TEST_ASSERT_UINT32_WITHIN(1, easing::value(EaseIn, progress), easing::reverse(EaseOut, progress));
+        TEST_ASSERT_UINT32_WITHIN(1, easing::value(EaseInOut, progress), easing::reverse(EaseInOut, progress));
+    }
+
+    const auto half = easing::ProgressMax / 2;
+    TEST_ASSERT(easing::value(Perceptual, half) < half);
+    TEST_ASSERT(easing::reverse(Perceptual, half) > half);
+}
+
+} // namespace
+} // namespace test
+} // namespace espurna
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    using namespace espurna::test;
+    RUN_TEST(test_output_table_size);
+    RUN_TEST(test_output_table_pwm);
+    RUN_TEST(test_output_table_my92xx);
+    RUN_TEST(test_output_table_custom);
+    RUN_TEST(test_output_table_bounds);
+    RUN_TEST(test_output_table_options);
+    RUN_TEST(test_easing_linear);
+    RUN_TEST(test_easing_bounds);
+    RUN_TEST(test_easing_accuracy);
+    RUN_TEST(test_easing_reverse);
+    return UNITY_END();
+}
@@ -0,0 +1,399 @@
+#include <unity.h>
+
+#include <Arduino.h>
+
+#include <espurna/light_common.ipp>
+
+#include "../benchmark/benchmark.h"
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Host version of the light.cpp update chain. Every update parses a payload, processes channel input values,
+// prepares the transition and runs it until completion, passing every step through a stub provider.
+// Channels, payload handlers, value processing and the transition handler are the ones used by light.cpp
+// (see light_common.ipp). Time is simulated, every provider update advances it by the transition step
+//
+// Benchmark parameters can be specified on the command line, e.g. to run only a single case
+// $ test-light_pipeline <case> <transition time> <transition step>
+// where <case> is one of: brightness, rgb, hsv, rgbw, cct, rgb-cct
+
+namespace espurna {
+namespace test {
+namespace {
+
+// Same as LIGHT_MIN_VALUE, LIGHT_MAX_VALUE, LIGHT_MIN_BRIGHTNESS and LIGHT_MAX_BRIGHTNESS defaults
+constexpr long ValueMin { 0 };
+constexpr long ValueMax { 255 };
+
+constexpr long BrightnessMin { 0 };
+constexpr long BrightnessMax { 255 };
+
+// Same as LIGHT_COLDWHITE_MIRED, LIGHT_WARMWHITE_MIRED and LIGHT_WHITE_FACTOR defaults
+constexpr long MiredsCold { 153 };
+constexpr long MiredsWarm { 500 };
+constexpr float WhiteFactor { 1.0f };
+
+// Generic PWM provider with the default PWM_FREQUENCY, see pwm.cpp
+constexpr uint32_t OutputMax { 10000 };
+
+using OutputTable = light::output::Table<uint32_t, ValueMin, ValueMax>;
+
+using Channel = light::Channel<OutputTable>;
+using Channels = std::vector<Channel>;
+using Mapping = light::Mapping<Channel>;
+
+using Brightness = light::process::Brightness<BrightnessMin, BrightnessMax>;
+
+// Simulated time, advanced by the pipeline after every provider update
+struct Clock {
+    using duration = espurna::duration::Milliseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<Clock, duration>;
+
+    static constexpr bool is_steady { true };
+
+    static time_point now() {
+        return time_point(current);
+    }
+
+    static duration current;
+};
+
+Clock::duration Clock::current { 0 };
+
+// Same fields as LightTransition, curve itself is chosen by the pipeline
+struct Options {
+    duration::Milliseconds time;
+    duration::Milliseconds step;
+    int curve;
+    bool channels;
+};
+
+using Transition = light::transition::Handler<Channel, Options, Clock>;
+
+struct State {
+    Mapping mapping;
+    Brightness brightness;
+    long mireds { (MiredsCold + MiredsWarm) / 2 };
+};
+
+// _lightValuesWith*
+void with_brightness(Channels& channels, const State& state) {
+    light::values::brightness(channels, state.brightness);
+}
+
+void with_brightness_except_white(Channels& channels, const State& state) {
+    light::values::brightness_except_white(channels, state.brightness);
+}
+
+void with_rgb_white(Channels& channels, const State& state) {
+    light::values::rgb_white(channels, state.brightness, WhiteFactor);
+}
+
+void with_cct(Channels& channels, const State& state) {
+    light::values::cct(channels, state.brightness,
+        light::color::factor(state.mireds, MiredsCold, MiredsWarm), WhiteFactor);
+}
+
+void with_rgb_cct(Channels& channels, const State& state) {
+    light::values::rgb_cct(channels, state.brightness, 1000000 / state.mireds);
+}
+
+// Payload handlers, see _lightFromRgbPayload, _lightFromHsvPayload, lightBrightness and lightTemperature
+void from_brightness(State& state, StringView payload) {
+    const auto result = parseUnsigned(payload, 10);
+    if (result.ok) {
+        state.brightness = result.value;
+    }
+}
+
+void from_rgb(State& state, StringView payload) {
+    light::payload::rgb(payload, state.mapping, state.brightness);
+}
+
+void from_hsv(State& state, StringView payload) {
+    light::color::Values values;
+    if (light::payload::hsv(payload, values)) {
+        light::payload::hsv(state.mapping, state.brightness, values);
+    }
+}
+
+void from_mireds(State& state, StringView payload) {
+    const auto result = parseUnsigned(payload, 10);
+    if (result.ok) {
+        state.mireds = std::clamp(static_cast<long>(result.value), MiredsCold, MiredsWarm);
+    }
+}
+
+using Process = void(*)(Channels&, const State&);
+using Payload = void(*)(State&, StringView);
+
+enum class Format {
+    Decimal,
+    Hex,
+    Hsv,
+    CommaSeparated,
+    Mireds,
+};
+
+struct Case {
+    const char* name;
+    size_t channels;
+    Format format;
+    Payload payload;
+    Process process;
+};
+
+constexpr Case Cases[] {
+    {"brightness", 1, Format::Decimal, from_brightness, with_brightness},
+    {"rgb", 3, Format::Hex, from_rgb, with_brightness_except_white},
+    {"hsv", 3, Format::Hsv, from_hsv, with_brightness_except_white},
+    {"rgbw", 4, Format::CommaSeparated, from_rgb, with_rgb_white},
+    {"cct", 5, Format::Mireds, from_mireds, with_cct},
+    {"rgb-cct", 3, Format::Mireds, from_mireds, with_rgb_cct},
+};
+
+std::vector<std::string> payloads(const Case& type) {
+    std::vector<std::string> out;
+
+    char buffer[32];
+    for (int index = 0; index < 16; ++index) {
+        const int value = (index * 37) % 256;
+        switch (type.format) {
+        case Format::Decimal:
+            snprintf(buffer, sizeof(buffer), "%d", value);
+            break;
+        case Format::Hex:
+            snprintf(buffer, sizeof(buffer), "#%02X%02X%02X",
+                value, 255 - value, (value * 7) % 256);
+            break;
+        case Format::Hsv:
+            snprintf(buffer, sizeof(buffer), "%d,%d,%d",
+                (index * 23) % 360, 50 + (index * 3) % 51, 10 + (index * 11) % 91);
+            break;
+        case Format::CommaSeparated:
+            snprintf(buffer, sizeof(buffer), "%d,%d,%d",
+                value, 255 - value, (value * 7) % 256);
+            break;
+        case Format::Mireds:
+            snprintf(buffer, sizeof(buffer), "%ld",
+                MiredsCold + (index * 29) % (MiredsWarm - MiredsCold + 1));
+            break;
+        }
+
+        out.emplace_back(buffer);
+    }
+
+    return out;
+}
+
+constexpr light::easing::Points Linear = light::easing::make(light::easing::linear);
+
+struct Provider {
+    void value(size_t index, uint32_t value) {
+        values[index] = value;
+        ++writes;
+    }
+
+    void update() {
+        ++updates;
+    }
+
+    std::array<uint32_t, 5> values{};
+    size_t writes { 0 };
+    size_t updates { 0 };
+};
+
+struct Config {
+    const Case* type;
+    uint64_t time;
+    uint64_t step;
+};
+
+class Pipeline {
+public:
+    explicit Pipeline(const Config& config) :
+        _config(config),
+        _channels(config.type->channels),
+        _payloads(payloads(*config.type))
+    {
+        _output.reset(OutputTable::Options{
+            .gamma = false,
+            .inverse = false,
+            .min = 0,
+            .max = OutputMax,
+        });
+
+        // payloads that only change the brightness need some input value to work with
+        for (auto& channel : _channels) {
+            channel = ValueMax;
+            channel.output = &_output;
+        }
+
+        _state.mapping = _channels;
+    }
+
+    // Single lightUpdate(), from the payload to the last transition step
+    void update(size_t iteration) {
+        const auto& payload = _payloads[iteration % _payloads.size()];
+        _config.type->payload(_state,
+            StringView(payload.data(), payload.size()));
+
+        _config.type->process(_channels, _state);
+
+        // same as light.cpp, handler is re-created on every update
+        auto transition = std::make_unique<Transition>(
+            _channels,
+            Options{
+                .time = duration::Milliseconds(_config.time),
+                .step = duration::Milliseconds(_config.step),
+                .curve = 0,
+                .channels = false,
+            },
+            Linear, false, true);
+
+        for (;;) {
+            Clock::current += duration::Milliseconds(_config.step);
+            const auto next = transition->run(
+                [](bool) {
+                },
+                [&](size_t index, uint32_t value) {
+                    _provider.value(index, value);
+                },
+                [&]() {
+                    _provider.update();
+                });
+            if (!next) {
+                break;
+            }
+        }
+    }
+
+    const Channels& channels() const {
+        return _channels;
+    }
+
+    const Provider& provider() const {
+        return _provider;
+    }
+
+    const OutputTable& output() const {
+        return _output;
+    }
+
+private:
+    Config _config;
+
+    Channels _channels;
+    State _state;
+
+    std::vector<std::string> _payloads;
+
+    OutputTable _output;
+    Provider _provider;
+};
+
+std::vector<Config> configs;
+
+void run(const Config& config) {
+    constexpr size_t Updates { 1000 };
+
+    Pipeline pipeline(config);
+    const auto result = benchmark::measure(Updates,
+        [&](size_t iteration) {
+            pipeline.update(iteration);
+        });
+
+    // provider always ends up with the target value of every channel
+    const auto& provider = pipeline.provider();
+    const auto& channels = pipeline.channels();
+    for (size_t index = 0; index < channels.size(); ++index) {
+        TEST_ASSERT_EQUAL(pipeline.output()[channels[index].target], provider.values[index]);
+        TEST_ASSERT_EQUAL(light::transition::fixed(channels[index].target), channels[index].current);
+    }
+
+    // at most one provider update per step, at least one for every lightUpdate()
+    const auto steps = config.step ? (config.time / config.step) : 0;
+    TEST_ASSERT(provider.updates >= Updates);
+    TEST_ASSERT(provider.updates <= (Updates * std::max<uint64_t>(steps, 1)));
+
+    char name[128];
+    snprintf(name, sizeof(name),
+        "case=%s channels=%zu transition=%llums step=%llums (%zu steps)",
+        config.type->name, config.type->channels,
+        static_cast<unsigned long long>(config.time),
+        static_cast<unsigned long long>(config.step),
+        provider.updates / Updates);
+    benchmark::print(name, result);
+}
+
+void test_pipeline() {
+    for (const auto& config : configs) {
+        run(config);
+    }
+}
+
+bool parse(int argc, char** argv) {
+    if (argc != 4) {
+        return false;
+    }
+
+    Config config;
+    config.type = nullptr;
+    config.time = std::strtoull(argv[2], nullptr, 10);
+    config.step = std::strtoull(argv[3], nullptr, 10);
+
+    for (const auto& type : Cases) {
+        if (0 == std::strcmp(type.name, argv[1])) {
+            config.type = &type;
+            break;
+        }
+    }
+
+    if (!config.type || !config.step) {
+        return false;
+    }
+
+    configs.push_back(config);
+    return true;
+}
+
+void defaults() {
+    // immediate, default LIGHT_TRANSITION_TIME & LIGHT_TRANSITION_STEP, long transition
+    for (const auto& type : Cases) {
+        for (uint64_t time : {0, 500, 10000}) {
+            configs.push_back(Config{
+                .type = &type,
+                .time = time,
+                .step = 10,
+            });
+        }
+    }
+}
+
+} // namespace
+} // namespace test
+} // namespace espurna
+
+int main(int argc, char** argv) {
+    using namespace espurna::test;
+    if (argc > 1 && !parse(argc, argv)) {
+        printf("%s <case> <transition time> <transition step>\n", argv[0]);
+        return 1;
+    }
+
+    if (configs.empty()) {
+        defaults();
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_pipeline);
+    return UNITY_END();
+}
@@ -10,7 +10,9 @@
 #include <espurna/libs/StreamEcho.h>
 #include <espurna/utils.h>
 
+#include <espurna/sensor_common.ipp>
 #include <espurna/sensor_emon.ipp>
+#include <espurna/sensor_journal.ipp>
 
 // TODO is ..._SUPPORT wrapping necessary inside of sensor includes?
 // TODO ..._PORT should not be used in the class itself?
@@ -22,7 +24,12 @@
 #include <espurna/config/sensors.h>
 #include <espurna/sensors/CSE7766Sensor.h>
 #include <espurna/sensors/A02YYUSensor.h>
+#include <espurna/sensors/BaseAnalogEmonSensor.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iterator>
 #include <memory>
 #include <vector>
 
@@ -193,6 +200,339 @@ void test_a02yyu_data() {
     TEST_ASSERT_EQUAL_DOUBLE(1.953, ptr->value(0));
 }
 
+// synthetic mains current waveform, sampled by the ADC with the given resolution
+// amplitude is in ADC counts, centered around the middle of the range and with some noise on top
+std::vector<int> emon_waveform(size_t resolution, double amplitude, size_t samples) {
+    constexpr double Pi { 3.14159265358979323846 };
+    constexpr double Frequency { 50.0 };
+    constexpr double SampleRate { 5000.0 };
+
+    const int counts = 1 << resolution;
+    const double offset = counts / 2.0;
+
+    std::vector<int> out;
+    out.reserve(samples);
+
+    uint32_t noise { 0xdeadbeef };
+    for (size_t index = 0; index < samples; ++index) {
+        noise = (noise * 1664525) + 1013904223;
+
+        const double angle = 2.0 * Pi * Frequency * index / SampleRate;
+        const double value = offset
+            + (amplitude * std::sin(angle))
+            + static_cast<double>(static_cast<int>(noise >> 29) - 4);
+
+        out.push_back(std::clamp(static_cast<int>(std::lround(value)), 0, counts - 1));
+    }
+
+    return out;
+}
+
+template <typename Kernel>
+sensor::emon::Samples emon_sample(const std::vector<int>& waveform, size_t resolution) {
+    auto it = waveform.begin();
+    return sensor::emon::sample<Kernel>(
+        static_cast<double>(1 << (resolution - 1)), resolution, waveform.size(),
+        [&]() {
+            return *(it++);
+        });
+}
+
+void test_emon_kernel_accuracy() {
+    constexpr size_t Samples { 1000 };
+
+    struct Case {
+        size_t resolution;
+        double amplitude;
+    };
+
+    constexpr Case cases[] {
+        {10, 10.0},
+        {10, 100.0},
+        {10, 500.0},
+        {12, 50.0},
+        {12, 2000.0},
+        {16, 300.0},
+        {16, 30000.0},
+    };
+
+    for (const auto& test : cases) {
+        const auto waveform = emon_waveform(test.resolution, test.amplitude, Samples);
+        const auto expected = emon_sample<sensor::emon::FloatKernel>(waveform, test.resolution);
+        const auto result = emon_sample<sensor::emon::FixedKernel>(waveform, test.resolution);
+
+        // reference kernel should be close to the actual RMS value
+        TEST_ASSERT_DOUBLE_WITHIN(
+            (test.amplitude / std::sqrt(2.0)) * 0.05 + 2.0,
+            test.amplitude / std::sqrt(2.0), expected.rms);
+
+        // and fixed point one should be close to the reference
+        TEST_ASSERT_DOUBLE_WITHIN(expected.rms * 0.001 + 0.1, expected.rms, result.rms);
+        TEST_ASSERT_DOUBLE_WITHIN(0.01, expected.pivot, result.pivot);
+        TEST_ASSERT_EQUAL(expected.min, result.min);
+        TEST_ASSERT_EQUAL(expected.max, result.max);
+    }
+}
+
+void test_emon_kernel_speed() {
+    constexpr size_t Resolution { 10 };
+    constexpr size_t Samples { 1000000 };
+
+    const auto waveform = emon_waveform(Resolution, 300.0, Samples);
+
+    using Clock = std::chrono::steady_clock;
+
+    auto measure = [&](auto&& func) {
+        const auto start = Clock::now();
+        const auto result = func();
+        const auto elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(
+            Clock::now() - start);
+
+        TEST_ASSERT_GREATER_THAN(0, result.rms);
+
+        return static_cast<double>(Samples) / elapsed.count();
+    };
+
+    const auto reference = measure([&]() {
+        return emon_sample<sensor::emon::FloatKernel>(waveform, Resolution);
+    });
+    const auto fixed = measure([&]() {
+        return emon_sample<sensor::emon::FixedKernel>(waveform, Resolution);
+    });
+
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer),
+        "samples per second: float %.0f, fixed %.0f (%.2fx)",
+        reference, fixed, fixed / reference);
+    TEST_MESSAGE(buffer);
+}
+
+void test_emon_buffer() {
+    using sensor::emon::Buffer;
+
+    Buffer buffer;
+
+    auto consume = [&](Buffer::Value expected) {
+        size_t size { 0 };
+        const auto result = buffer.consume(
+            [&](const Buffer::Value* begin, const Buffer::Value* end) {
+                size = std::distance(begin, end);
+                TEST_ASSERT_EACH_EQUAL_UINT16(expected, begin, size);
+            });
+
+        return result ? size : 0;
+    };
+
+    // nothing is available until the first half is filled
+    TEST_ASSERT_EQUAL(0, consume(0));
+    for (size_t index = 0; index < Buffer::Size - 1; ++index) {
+        TEST_ASSERT(buffer.push(1));
+    }
+    TEST_ASSERT_EQUAL(0, consume(0));
+
+    TEST_ASSERT(buffer.push(1));
+
+    // both halves are filled, everything else is dropped
+    for (size_t index = 0; index < Buffer::Size; ++index) {
+        TEST_ASSERT(buffer.push(2));
+    }
+
+    TEST_ASSERT_FALSE(buffer.push(3));
+    TEST_ASSERT_EQUAL(1, buffer.overruns());
+
+    // halves are consumed in the same order they were filled
+    TEST_ASSERT_EQUAL(Buffer::Size, consume(1));
+    TEST_ASSERT(buffer.push(4));
+    TEST_ASSERT_EQUAL(Buffer::Size, consume(2));
+    TEST_ASSERT_EQUAL(0, consume(0));
+}
+
+void test_emon_accumulator() {
+    constexpr size_t Resolution { 12 };
+    const auto waveform = emon_waveform(Resolution, 1000.0, 1000);
+
+    for (auto kernel : {sensor::emon::Kernel::Float, sensor::emon::Kernel::Fixed}) {
+        const auto pivot = static_cast<double>(1 << (Resolution - 1));
+
+        // pushing samples in chunks should not be any different from doing it all at once
+        sensor::emon::Accumulator accumulator(kernel, pivot, Resolution);
+        for (auto sample : waveform) {
+            accumulator.push(sample);
+        }
+
+        const auto expected = (kernel == sensor::emon::Kernel::Fixed)
+            ? emon_sample<sensor::emon::FixedKernel>(waveform, Resolution)
+            : emon_sample<sensor::emon::FloatKernel>(waveform, Resolution);
+
+        const auto result = accumulator.result();
+        TEST_ASSERT_EQUAL(waveform.size(), accumulator.count());
+        TEST_ASSERT_EQUAL_DOUBLE(expected.rms, result.rms);
+        TEST_ASSERT_EQUAL_DOUBLE(expected.pivot, result.pivot);
+    }
+}
+
+void test_magnitude_format() {
+    struct Case {
+        double value;
+        unsigned char decimals;
+        const char* expected;
+    };
+
+    const Case cases[] {
+        {0.0, 2, "0.00"},
+        {1.999, 2, "2.00"},
+        {-1.5, 1, "-1.5"},
+        {123.456, 0, "123"},
+        {0.05, 1, "0.1"},
+        {1234567.891, 3, "1234567.891"},
+        {4294967296.0, 1, "4294967296.0"},
+        {0.125, 12, "0.125000000"},
+        {1e20, 2, "ovf"},
+        {sensor::Value::Unknown, 2, "nan"},
+        {std::numeric_limits<double>::infinity(), 2, "inf"},
+    };
+
+    for (const auto& test : cases) {
+        const auto result = sensor::magnitude::repr(test.value, test.decimals);
+        TEST_ASSERT_EQUAL_STRING(test.expected, result.c_str());
+        TEST_ASSERT_EQUAL(strlen(test.expected), result.length());
+        TEST_ASSERT_EQUAL_STRING(test.expected,
+            sensor::magnitude::format(test.value, test.decimals).c_str());
+    }
+
+    // output is never truncated, value that does not fit is replaced
+    char buffer[6];
+    TEST_ASSERT_EQUAL(5, sensor::magnitude::format(12.345, 2, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_STRING("12.35", buffer);
+    TEST_ASSERT_EQUAL(3, sensor::magnitude::format(123.456, 2, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_STRING("ovf", buffer);
+}
+
+// Flash-like storage, bits can only be cleared by writes and set by erasing the whole sector
+struct JournalStorage {
+    static constexpr size_t SectorSize { 1024 };
+    static constexpr size_t Sectors { 2 };
+
+    JournalStorage() {
+        std::fill(data.begin(), data.end(), 0xff);
+    }
+
+    size_t sectors() const {
+        return Sectors;
+    }
+
+    size_t sector_size() const {
+        return SectorSize;
+    }
+
+    bool read(size_t offset, sensor::energy::journal::Record& out) {
+        std::memcpy(&out, &data[offset], sizeof(out));
+        return true;
+    }
+
+    bool write(size_t offset, const sensor::energy::journal::Record& record) {
+        const auto* ptr = reinterpret_cast<const uint8_t*>(&record);
+        for (size_t index = 0; index < sizeof(record); ++index) {
+            data[offset + index] &= ptr[index];
+        }
+        ++writes;
+        return true;
+    }
+
+    bool erase(size_t sector) {
+        std::fill(&data[sector * SectorSize], &data[(sector + 1) * SectorSize], 0xff);
+        ++erases;
+        return true;
+    }
+
+    std::array<uint8_t, SectorSize * Sectors> data;
+    size_t writes { 0 };
+    size_t erases { 0 };
+};
+
+std::array<sensor::energy::journal::Entry, sensor::energy::journal::Entries> journal_entries(uint32_t value) {
+    std::array<sensor::energy::journal::Entry, sensor::energy::journal::Entries> out;
+    for (size_t index = 0; index < out.size(); ++index) {
+        out[index] = sensor::energy::journal::Entry{
+            .kwh = value,
+            .ws = static_cast<uint32_t>(index),
+            .timestamp = value * 60,
+        };
+    }
+
+    return out;
+}
+
+void test_energy_journal_recover() {
+    using namespace sensor::energy::journal;
+
+    JournalStorage storage;
+    sensor::energy::journal::Record record;
+
+    {
+        Journal<JournalStorage> journal(storage);
+        TEST_ASSERT_FALSE(journal.recover(record));
+        TEST_ASSERT_EQUAL(0, journal.next());
+        TEST_ASSERT_EQUAL(2 * (JournalStorage::SectorSize / sizeof(Record)), journal.slots());
+
+        for (uint32_t value = 1; value <= 5; ++value) {
+            TEST_ASSERT(journal.append(journal_entries(value)));
+        }
+
+        // only the first sector was ever erased
+        TEST_ASSERT_EQUAL(1, storage.erases);
+        TEST_ASSERT_EQUAL(5, storage.writes);
+    }
+
+    Journal<JournalStorage> journal(storage);
+    TEST_ASSERT(journal.recover(record));
+    TEST_ASSERT_EQUAL(5, record.sequence);
+    TEST_ASSERT_EQUAL(5, journal.next());
+    TEST_ASSERT_EQUAL(5, record.entries[0].kwh);
+    TEST_ASSERT_EQUAL(300, record.entries[3].timestamp);
+    TEST_ASSERT_EQUAL(3, record.entries[3].ws);
+
+    // corrupted record is skipped, the previous one is used instead
+    storage.data[(4 * sizeof(Record)) + offsetof(Record, entries)] ^= 0x1;
+    TEST_ASSERT(journal.recover(record));
+    TEST_ASSERT_EQUAL(4, record.sequence);
+    TEST_ASSERT_EQUAL(4, record.entries[0].kwh);
+
+    // slot with the broken record can't be re-used without erasing,
+    // continue with the next sector and keep the old records intact
+    TEST_ASSERT(journal.append(journal_entries(6)));
+    TEST_ASSERT_EQUAL(2, storage.erases);
+    TEST_ASSERT_EQUAL(journal.slots() / 2 + 1, journal.next());
+
+    TEST_ASSERT(journal.recover(record));
+    TEST_ASSERT_EQUAL(5, record.sequence);
+    TEST_ASSERT_EQUAL(6, record.entries[0].kwh);
+}
+
+void test_energy_journal_wrap() {
+    using namespace sensor::energy::journal;
+
+    JournalStorage storage;
+    Journal<JournalStorage> journal(storage);
+
+    sensor::energy::journal::Record record;
+    TEST_ASSERT_FALSE(journal.recover(record));
+
+    // sectors are erased only when the write position enters them
+    const auto slots = journal.slots();
+    const auto total = (slots * 3) + 1;
+    for (uint32_t value = 1; value <= total; ++value) {
+        TEST_ASSERT(journal.append(journal_entries(value)));
+        TEST_ASSERT(journal.recover(record));
+        TEST_ASSERT_EQUAL(value, record.sequence);
+        TEST_ASSERT_EQUAL(value, record.entries[0].kwh);
+    }
+
+    TEST_ASSERT_EQUAL(total, storage.writes);
+    TEST_ASSERT_EQUAL(7, storage.erases);
+    TEST_ASSERT_EQUAL(1, journal.next());
+}
+
 } // namespace
 } // namespace test
 } // namespace espurna
@@ -202,5 +542,12 @@ int main(int, char**) {
     using namespace espurna::test;
     RUN_TEST(test_cse7766_data);
     RUN_TEST(test_a02yyu_data);
+    RUN_TEST(test_emon_kernel_accuracy);
+    RUN_TEST(test_emon_kernel_speed);
+    RUN_TEST(test_emon_buffer);
+    RUN_TEST(test_emon_accumulator);
+    RUN_TEST(test_magnitude_format);
+    RUN_TEST(test_energy_journal_recover);
+    RUN_TEST(test_energy_journal_wrap);
     return UNITY_END();
 }
@@ -0,0 +1,389 @@
+#include <unity.h>
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include <espurna/sensors/BaseSensor.h>
+#include <espurna/sensor_common.ipp>
+#include <espurna/thingspeak_common.ipp>
+
+#include "../benchmark/benchmark.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <forward_list>
+#include <vector>
+
+// Host version of the sensor.cpp read loop. Sensor values are synthetic, every magnitude is processed
+// by the same sensor_common.ipp functions as in sensor::loop(), reports are passed through a number of subscribers
+// (similar to mqtt, thingspeak, domoticz, influxdb and websocket callbacks)
+//
+// Benchmark parameters can be specified on the command line, e.g. to run only a single case
+// $ test-sensor_pipeline <magnitudes> <filter> <report every> <subscribers>
+// where <filter> is one of: last, max, median, min, moving-average, sum
+
+namespace espurna {
+namespace test {
+namespace {
+
+// Generates slightly different values for each slot. Magnitude types are
+// cycled through the list, so units and decimals are not all the same
+class SyntheticSensor : public BaseSensor {
+public:
+    static constexpr unsigned char Types[] {
+        MAGNITUDE_TEMPERATURE,
+        MAGNITUDE_HUMIDITY,
+        MAGNITUDE_PRESSURE,
+        MAGNITUDE_CURRENT,
+        MAGNITUDE_VOLTAGE,
+        MAGNITUDE_POWER_ACTIVE,
+        MAGNITUDE_ENERGY,
+    };
+
+    explicit SyntheticSensor(size_t count) :
+        _values(count, 0.0)
+    {}
+
+    unsigned char id() const override {
+        return 0;
+    }
+
+    unsigned char count() const override {
+        return _values.size();
+    }
+
+    String description() const override {
+        return STRING_VIEW("SyntheticSensor").toString();
+    }
+
+    unsigned char type(unsigned char index) const override {
+        return Types[index % std::size(Types)];
+    }
+
+    void pre() override {
+        ++_step;
+        for (size_t index = 0; index < _values.size(); ++index) {
+            const auto offset = static_cast<double>((_step * (index + 7) * 37) % 1000);
+            _values[index] = 10.0 * static_cast<double>(index + 1) + (offset / 97.0);
+        }
+    }
+
+    double value(unsigned char index) override {
+        return _values[index];
+    }
+
+private:
+    std::vector<double> _values;
+    size_t _step { 0 };
+};
+
+constexpr unsigned char SyntheticSensor::Types[];
+
+// Same fields as the sensor.cpp Magnitude, shared code in sensor_common.ipp only works with these
+struct Magnitude {
+    static size_t counts(unsigned char type) {
+        return _counts[type];
+    }
+
+    static bool indexed(unsigned char type) {
+        return counts(type) > 1;
+    }
+
+    static void reset() {
+        std::fill(std::begin(_counts), std::end(_counts), 0);
+    }
+
+    Magnitude(BaseSensor* sensor, unsigned char slot) :
+        sensor(sensor),
+        slot(slot),
+        type(sensor->type(slot)),
+        index_global(_counts[type]++),
+        units(sensor->units(slot))
+    {}
+
+    BaseSensor* sensor;
+    unsigned char slot;
+    unsigned char type;
+    unsigned char index_global;
+
+    sensor::Unit units;
+    unsigned char decimals { 2 };
+
+    sensor::BaseFilterPtr filter;
+    size_t read_count { 0 };
+
+    sensor::ValuePair last = sensor::DefaultValuePair;
+    sensor::ValuePair reported = sensor::DefaultValuePair;
+
+    double min_delta { 0.0 };
+    double max_delta { 0.0 };
+
+    double min_threshold { sensor::Value::Unknown };
+    double max_threshold { sensor::Value::Unknown };
+
+    double zero_threshold { sensor::Value::Unknown };
+    double correction { 0.0 };
+
+private:
+    static unsigned char _counts[MAGNITUDE_MAX];
+};
+
+unsigned char Magnitude::_counts[MAGNITUDE_MAX] = {0};
+
+struct Config {
+    size_t magnitudes;
+    sensor::Filter filter;
+    size_t report_every;
+    size_t subscribers;
+};
+
+struct Counters {
+    size_t reads;
+    size_t reports;
+};
+
+class Pipeline {
+public:
+    using Handler = void(*)(const sensor::Value&);
+
+    explicit Pipeline(const Config& config) :
+        _sensor(config.magnitudes),
+        _report_every(config.report_every)
+    {
+        Magnitude::reset();
+
+        _magnitudes.reserve(config.magnitudes);
+        for (size_t slot = 0; slot < config.magnitudes; ++slot) {
+            _magnitudes.emplace_back(&_sensor, slot);
+
+            auto& magnitude = _magnitudes.back();
+            magnitude.filter = sensor::magnitude::makeFilter(config.filter);
+            magnitude.filter->resize(config.report_every);
+        }
+
+        for (size_t index = 0; index < config.subscribers; ++index) {
+            _handlers.push_front(subscriber);
+        }
+    }
+
+    // Single iteration of the sensor::loop(), assuming ready_to_read() returned true.
+    // Everything besides reading the value and notifying subscribers is done by the shared code
+    void read() {
+        _sensor.pre();
+
+        for (size_t index = 0; index < _magnitudes.size(); ++index) {
+            auto& magnitude = _magnitudes[index];
+            if (SENSOR_ERROR_OK != magnitude.sensor->error()) {
+                continue;
+            }
+
+            const auto raw = sensor::ValuePair{
+                .value = magnitude.sensor->value(magnitude.slot),
+                .units = magnitude.sensor->units(magnitude.slot),
+            };
+
+            const auto processed = sensor::processed_value(magnitude, raw);
+
+            bool report = sensor::magnitude::update(magnitude, processed, _report_every);
+            notify(_read_handlers, sensor::magnitude::value(magnitude, processed));
+            ++_counters.reads;
+
+            sensor::ValuePair report_value;
+            report = sensor::ready_to_report(
+                report_value, processed, magnitude, report);
+
+            if (report) {
+                const auto value = sensor::magnitude::value(magnitude, report_value);
+
+                magnitude.reported = report_value;
+                notify(_handlers, value);
+                ++_counters.reports;
+
+                // Same as tspkEnqueueMagnitude(), every magnitude is assigned a field
+                _fields.set(1 + (index % _fields.size()), value.repr);
+            }
+        }
+
+        _sensor.post();
+    }
+
+    const Counters& counters() const {
+        return _counters;
+    }
+
+    static size_t notifications() {
+        return _notifications;
+    }
+
+    const thingspeak::Fields<8>& fields() const {
+        return _fields;
+    }
+
+private:
+    using Handlers = std::forward_list<Handler>;
+
+    static void subscriber(const sensor::Value& value) {
+        if (value.repr.length() && value.topic.length()) {
+            ++_notifications;
+        }
+    }
+
+    static void notify(const Handlers& handlers, const sensor::Value& value) {
+        for (auto& handler : handlers) {
+            handler(value);
+        }
+    }
+
+    static size_t _notifications;
+
+    SyntheticSensor _sensor;
+    std::vector<Magnitude> _magnitudes;
+
+    size_t _report_every;
+
+    Handlers _read_handlers;
+    Handlers _handlers;
+
+    thingspeak::Fields<8> _fields;
+
+    Counters _counters { 0, 0 };
+};
+
+size_t Pipeline::_notifications { 0 };
+
+struct FilterName {
+    const char* name;
+    sensor::Filter filter;
+};
+
+constexpr FilterName Filters[] {
+    {"last", sensor::Filter::Last},
+    {"max", sensor::Filter::Max},
+    {"median", sensor::Filter::Median},
+    {"min", sensor::Filter::Min},
+    {"moving-average", sensor::Filter::MovingAverage},
+    {"sum", sensor::Filter::Sum},
+};
+
+const char* filter_name(sensor::Filter filter) {
+    for (const auto& entry : Filters) {
+        if (entry.filter == filter) {
+            return entry.name;
+        }
+    }
+
+    return "?";
+}
+
+std::vector<Config> configs;
+
+void run(const Config& config) {
+    constexpr size_t Reads { 10000 };
+
+    Pipeline pipeline(config);
+
+    const auto notifications = Pipeline::notifications();
+    const auto result = benchmark::measure(Reads,
+        [&](size_t) {
+            pipeline.read();
+        });
+
+    // every magnitude is reported once per N reads, no other checks are involved
+    const auto& counters = pipeline.counters();
+    TEST_ASSERT_EQUAL(Reads * config.magnitudes, counters.reads);
+    TEST_ASSERT_EQUAL((Reads / config.report_every) * config.magnitudes, counters.reports);
+    TEST_ASSERT_EQUAL(counters.reports * config.subscribers,
+        Pipeline::notifications() - notifications);
+
+    const auto& fields = pipeline.fields();
+    for (size_t id = 1; id <= std::min(fields.size(), config.magnitudes); ++id) {
+        TEST_ASSERT(fields.get(id).length() > 0);
+    }
+
+    // filters reserve their storage in advance, values are formatted in-place
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, result.allocations);
+
+    char name[128];
+    snprintf(name, sizeof(name),
+        "magnitudes=%zu filter=%s report=%zu subscribers=%zu (%zu reports)",
+        config.magnitudes, filter_name(config.filter), config.report_every,
+        config.subscribers, counters.reports);
+    benchmark::print(name, result);
+}
+
+void test_pipeline() {
+    for (const auto& config : configs) {
+        run(config);
+    }
+}
+
+bool parse(int argc, char** argv) {
+    if (argc != 5) {
+        return false;
+    }
+
+    Config config;
+    config.magnitudes = std::strtoul(argv[1], nullptr, 10);
+    config.filter = sensor::Filter::Median;
+    config.report_every = std::strtoul(argv[3], nullptr, 10);
+    config.subscribers = std::strtoul(argv[4], nullptr, 10);
+
+    bool filter { false };
+    for (const auto& entry : Filters) {
+        if (0 == std::strcmp(entry.name, argv[2])) {
+            config.filter = entry.filter;
+            filter = true;
+            break;
+        }
+    }
+
+    if (!filter || !config.magnitudes || !config.report_every) {
+        return false;
+    }
+
+    configs.push_back(config);
+    return true;
+}
+
+void defaults() {
+    for (size_t magnitudes : {1, 4, 16}) {
+        for (const auto& entry : Filters) {
+            configs.push_back(Config{
+                .magnitudes = magnitudes,
+                .filter = entry.filter,
+                .report_every = 10,
+                .subscribers = 5,
+            });
+        }
+    }
+
+    for (size_t report_every : {1, 60}) {
+        configs.push_back(Config{
+            .magnitudes = 8,
+            .filter = sensor::Filter::Median,
+            .report_every = report_every,
+            .subscribers = 5,
+        });
+    }
+}
+
+} // namespace
+} // namespace test
+} // namespace espurna
+
+int main(int argc, char** argv) {
+    using namespace espurna::test;
+    if (argc > 1 && !parse(argc, argv)) {
+        printf("%s <magnitudes> <filter> <report every> <subscribers>\n", argv[0]);
+        return 1;
+    }
+
+    if (configs.empty()) {
+        defaults();
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_pipeline);
+    return UNITY_END();
+}